@@ -13,6 +13,12 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#define AT86_CHAN_MIN        (11U) // IEEE 802.15.4 channels of the 2.4 GHz band
+#define AT86_CHAN_MAX        (26U)
+#define AT86_CHAN_FREQ(chan) (2405U + 5U*((chan) - AT86_CHAN_MIN)) // Center frequency (MHz) of a channel
+#define AT86_FREQ_MIN        (2322U) // Lowest and highest center frequencies (MHz) CC_CTRL_0/CC_CTRL_1 can tune to, in 1 MHz steps
+#define AT86_FREQ_MAX        (2527U)
+
 typedef enum // List of states the AT86RF233 may be in. See section 7 of the datasheet for details.
 {
     statusP_ON                         = 0x00,
@@ -56,8 +62,34 @@ typedef enum // List of interrupts that may be issued by the AT86RF233. See sect
     irqBAT_LOW = 0x80
 } AT86_Irq_Enum;
 
+typedef enum // Outcome of the latest transaction in the extended operating mode (TRX_STATE.TRAC_STATUS). See section 9 of the datasheet for details.
+{
+    tracSUCCESS                = 0x00,
+    tracSUCCESS_DATA_PENDING   = 0x01,
+    tracSUCCESS_WAIT_FOR_ACK   = 0x02,
+    tracCHANNEL_ACCESS_FAILURE = 0x03,
+    tracNO_ACK                 = 0x05,
+    tracINVALID                = 0x07
+} AT86_Trac_Enum;
+
+typedef enum // Data rates of the O-QPSK PHY (TRX_CTRL_2.OQPSK_DATA_RATE). The SHR and PHR of a frame always go at 250 kb/s, only the PSDU at the higher rates. See section 11.3 of the datasheet for details.
+{
+    rate250KBPS = 0x00,
+    rate500KBPS = 0x01,
+    rate1MBPS   = 0x02,
+    rate2MBPS   = 0x03
+} AT86_Rate_Enum;
+
+typedef void (*AT86_Handler)(AT86_Irq_Enum irqs); // Completion callback of an asynchronous operation. Called from the IRQ interrupt handler with the IRQ_STATUS bits that ended it.
+
 void AT86_init(void); // Initialize the MSP430 peripherals used to control the AT86RF233, and put the AT86RF233 in an idle state.
 
+void AT86_reset(void); // Reset the AT86RF233 registers through its RESET pin and wait until it is idle.
+
+void AT86_sleep(void); // Put the AT86RF233 to sleep.
+
+void AT86_wakeup(void); // Wake the AT86RF233 from sleep and wait until it is idle.
+
 uint8_t AT86_getPartNum(void); // Retrieve the part number of the AT86RF233.
 
 uint8_t AT86_getVersionNum(void); // Retrieve the version number of the AT86RF233.
@@ -72,6 +104,16 @@ uint8_t AT86_getChan(void); // Get the current channel on which the AT86RF233 is
 
 void AT86_setChan(uint8_t chan); // Configure the channel on which the AT86RF233 will transmit and receive.
 
+uint16_t AT86_getFreq(void); // Get the center frequency (MHz) at which the AT86RF233 is transmitting and receiving, set by a channel or directly.
+
+void AT86_setFreq(uint16_t freq); // Configure the center frequency (MHz) at which the AT86RF233 will transmit and receive, in place of a channel.
+
+bool AT86_hopChan(uint8_t chan); // Move the AT86RF233 to another channel and wait until its PLL has locked on it. False if it didn't lock in time.
+
+bool AT86_hopFreq(uint16_t freq); // Move the AT86RF233 to another center frequency (MHz) and wait until its PLL has locked on it. False if it didn't lock in time.
+
+void AT86_calibratePll(void); // Calibrate the PLL of the AT86RF233 on the current frequency.
+
 uint16_t AT86_getPan(void); // Get the PAN ID of the AT86RF233.
 
 void AT86_setPan(uint16_t pan); // Configure the PAN ID of the AT86RF233.
@@ -80,8 +122,18 @@ int16_t AT86_getTxPower(void); // Get the power (dBm) at which the AT86RF233 wil
 
 void AT86_setTxPower(int16_t power); // Configure the power (dBm) at which the AT86RF233 will transmit.
 
+AT86_Rate_Enum AT86_getDataRate(void); // Get the data rate at which the AT86RF233 transmits and receives the PSDU of a frame.
+
+void AT86_setDataRate(AT86_Rate_Enum rate, bool scrambler); // Configure the data rate at which the AT86RF233 transmits and receives the PSDU of a frame, and whether it is scrambled.
+
+uint16_t AT86_getAirtime(uint8_t len); // Get the time (us) a frame with a PSDU of len bytes spends on the air at the current data rate.
+
 AT86_Status_Enum AT86_getStatus(void); // Read the status register of the AT86RF233, indicating its current state.
 
+AT86_Status_Enum AT86_lastStatus(void); // Get the state of the AT86RF233 as of the latest SPI transaction, without talking to it.
+
+void AT86_waitStatus(AT86_Status_Enum status); // Wait until the AT86RF233 has reached a state it stays in until commanded otherwise.
+
 void AT86_sendCmd(AT86_Cmd_Enum cmd); // Send one of a list of commands to the AT86RF233.
 
 void AT86_enablePhase(bool enable); // Enable or disable phase measurement by the AT86RF233.
@@ -92,16 +144,40 @@ void AT86_prepareTx(void); // Put the AT86RF233 in a state from which it can tra
 
 void AT86_loadTx(const uint8_t * src, uint8_t len, uint8_t offset); // Configure the next payload to be transmitted.
 
-void AT86_execTx(void); // Transmit the payload that has been loaded into the buffer of the AT86RF233.
+void AT86_patchTx(const uint8_t * src, uint8_t len, uint8_t offset); // Rewrite part of the loaded payload, which may already be on its way out.
+
+bool AT86_txLoaded(void); // Find out whether the buffer of the AT86RF233 still holds the payload last loaded.
+
+void AT86_forgetTx(void); // Record that the buffer of the AT86RF233 has been written other than through the driver.
+
+void AT86_execTx(AT86_Handler done); // Start transmitting the payload that has been loaded into the buffer of the AT86RF233; done is called once it is on the air.
+
+bool AT86_execTxAt(uint16_t count, AT86_Handler done); // Start transmitting the loaded payload through SLP_TR when the driver's timer reaches count; done is called once it is on the air.
+
+void AT86_prepareRx(AT86_Handler started, AT86_Handler done); // Put the AT86RF233 in reception mode; started and done are called when a payload starts and finishes arriving.
 
-void AT86_prepareRx(void); // Put the AT86RF233 in reception mode.
+void AT86_setRetries(uint8_t frame_retries, uint8_t csma_retries); // Configure how many times the extended operating mode retries a frame that is not acknowledged, and a busy channel.
 
-void AT86_execRx(void); // Acknowledge interrupt indicating that the AT86RF233 has finished receiving a payload.
+void AT86_setBackoff(uint8_t min_be, uint8_t max_be); // Configure the range of backoff exponents of the CSMA-CA algorithm of the extended operating mode.
+
+void AT86_setCsmaSeed(uint16_t seed); // Seed the random backoff of the CSMA-CA algorithm of the extended operating mode.
+
+void AT86_prepareTxAret(void); // Put the AT86RF233 in a state from which it transmits when prompted with CSMA-CA, retransmissions and ACK reception (TX_ARET_ON).
+
+void AT86_prepareRxAack(AT86_Handler started, AT86_Handler done); // Put the AT86RF233 in reception mode with address filtering and automatic acknowledgement (RX_AACK_ON).
+
+AT86_Trac_Enum AT86_getTrac(void); // Retrieve the outcome of the latest transmission or reception in the extended operating mode.
+
+uint8_t AT86_getAretRetries(void); // Retrieve how many times the latest transmission in the extended operating mode was retried.
+
+bool AT86_getRxStart(uint16_t * count); // Retrieve the timer count captured from DIG2 when the AT86RF233 detected the SFD of the payload being received.
 
 void AT86_readRx(uint8_t * dest, uint8_t len, uint8_t offset); // Retrieve the latest payload received by the AT86RF233.
 
-AT86_Irq_Enum AT86_readIstat(void); // Read the interrupt status register to determine which AT86RF233 interrupt has happened.
+void AT86_cancel(void); // Give up on a transmission or reception that has not completed, and put the AT86RF233 in PLL_ON.
+
+bool AT86_busy(void); // Determine whether a transmission or reception started by AT86_execTx or AT86_prepareRx has not completed yet.
 
-bool AT86_irqPending(void); // Determine whether the AT86RF233 has issued an interrupt that has not yet been dealt with.
+bool AT86_getEvent(AT86_Irq_Enum * event); // Retrieve the oldest AT86RF233 interrupt queued by the IRQ interrupt handler, if there is one.
 
 #endif /* AT86RF233_HEADERS_AT86_H_ */
@@ -32,7 +32,7 @@
 #define REG__TRX_STATE                        (0x02)
 #define RST__TRX_STATE                        (0x00)
 #define MASK__TRX_STATE__TRX_CMD              (0x1F)
-#define MASK__TRX_STATE__TRX_STATUS           (0xE0)
+#define MASK__TRX_STATE__TRAC_STATUS          (0xE0)
 #define SHIFT__TRX_STATE__TRX_CMD             (0x00)
 #define SHIFT__TRX_STATE__TRAC_STATUS         (0x05)
 
@@ -113,9 +113,9 @@
 
 #define REG__TRX_CTRL_2                       (0x0C)
 #define RST__TRX_CTRL_2                       (0x20)
-#define MASK__TX_CTRL_2__OQPSK_DATA_RATE      (0x07)
-#define MASK__TX_CTRL_2__OQPSK_SCRAM_EN       (0x20)
-#define MASK__TX_CTRL_2__RX_SAFE_MODE         (0x80)
+#define MASK__TRX_CTRL_2__OQPSK_DATA_RATE     (0x07)
+#define MASK__TRX_CTRL_2__OQPSK_SCRAM_EN      (0x20)
+#define MASK__TRX_CTRL_2__RX_SAFE_MODE        (0x80)
 #define SHIFT__TRX_CTRL_2__OQPSK_DATA_RATE    (0x00)
 #define SHIFT__TRX_CTRL_2__OQPSK_SCRAM_EN     (0x05)
 #define SHIFT__TRX_CTRL_2__RX_SAFE_MODE       (0x07)
@@ -340,7 +340,7 @@
 #define RST__XAH_CTRL_0                       (0x38)
 #define MASK__XAH_CTRL_0__SLOTTED_OPERATION   (0x01)
 #define MASK__XAH_CTRL_0__MAX_CSMA_RETRIES    (0x0E)
-#define MASK__XAH_CTRL_0__MAX_FRAME_RETRIES   (0xF)
+#define MASK__XAH_CTRL_0__MAX_FRAME_RETRIES   (0xF0)
 #define SHIFT__XAH_CTRL_0__SLOTTED_OPERATION  (0x00)
 #define SHIFT__XAH_CTRL_0__MAX_CSMA_RETRIES   (0x01)
 #define SHIFT__XAH_CTRL_0__MAX_FRAME_RETRIES  (0x04)
@@ -415,11 +415,20 @@ void    REG_write(uint8_t address, uint8_t value); // Writes a value to one of t
 
 uint8_t REG_read(uint8_t address); // Reads the value of one of the AT86RF233 registers.
 
+void    REG_invalidate(void); // Forgets the cached values of the AT86RF233 configuration registers.
+
+uint8_t REG_status(void); // Fetches the PHY_STATUS byte with a one-byte SPI transaction.
+
+uint8_t REG_lastStatus(void); // Returns the PHY_STATUS byte of the latest SPI transaction.
+
 void    SRAM_read(uint8_t offset, uint8_t * dest, uint8_t len); // Reads part of the TRX buffer in the AT86RF233.
 
 void    SRAM_write(uint8_t offset, const uint8_t * src, uint8_t len); // Writes to part of the TRX buffer in the AT86RF233.
 
 void    FB_read(uint8_t * dest, uint8_t len); // Reads from the beginning of the TRX buffer in the AT86RF233.
 
+void    REG_lendBus(void (*reclaim)(void)); // Lets another module drive the SPI bus until the next access through these functions.
+bool    REG_serviceDma(void); // Checks the DMA channel that ends bursts, from the DMA interrupt handler (AT86_SPI_DMA = 1 only).
+
 
 #endif /* AT86RF233_HEADERS_REGISTERS_H_ */
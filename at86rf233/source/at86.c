@@ -5,12 +5,85 @@
  *      Author: jgamm
  */
 
+#include <stddef.h>
 #include "at86.h"
 #include "registers.h"
 #include "gpio.h"
+#include "timer_a.h"
 #include "hal.h"
 
-volatile bool irq_pending = false; // Variable that will be true whenever the AT86RF233 has sent an interrupt that has not yet been addressed by higher-level code.
+#define IRQ_EVENTS      (irqPLL_LOCK|irqRX_START|irqTRX_END|irqTRX_UR) // AT86RF233 interrupts the driver keeps enabled and follows
+#define EVENT_QUEUE_LEN (16U) // Number of interrupts the event queue holds (a power of 2); once it is full the oldest ones are dropped
+#define TIMER_R         HWREG16(AT86_TIMER_BASE + OFS_TAxR) // Count of the timer radio events are timed with
+#define WAKEUP_TIMER_R  HWREG16(AT86_WAKEUP_TIMER_BASE + OFS_TAxR) // Count of the timer that raises SLP_TR for scheduled transmissions
+#define CC_BAND_CHANNEL (0x00) // CC_CTRL_1.CC_BAND that leaves the frequency to PHY_CC_CCA.CHANNEL
+#define CC_BAND_2_4GHZ  (0x08) // CC_CTRL_1.CC_BAND that tunes to CC_BAND_BASE + CC_CTRL_0.CC_NUMBER MHz
+#define CC_BAND_BASE    (2306U) // Frequency (MHz) of CC_NUMBER 0 in CC_BAND_2_4GHZ
+
+static volatile uint8_t event_queue[EVENT_QUEUE_LEN]; // Interrupts decoded by the IRQ interrupt handler, oldest first
+static volatile uint8_t event_head = 0; // Index at which the next interrupt will be queued
+static volatile uint8_t event_tail = 0; // Index of the oldest queued interrupt
+static AT86_Handler volatile start_handler = NULL; // Called on RX_START during an ongoing reception
+static AT86_Handler volatile done_handler = NULL; // Called on TRX_END or TRX_UR to complete an ongoing transmission or reception
+static volatile bool busy = false; // Whether a transmission or reception has been started and has not completed yet
+static volatile bool wakeup_raised = false; // Whether SLP_TR has been raised, or handed to its timer, to start a transmission
+static volatile bool pll_locked = false; // Set by the IRQ interrupt handler on PLL_LOCK
+static bool extended = false; // Whether the AT86RF233 was last put in a state of the extended operating mode (TX_ARET_ON or RX_AACK_ON)
+static bool tx_loaded = false; // Whether the frame buffer still holds the payload last loaded by AT86_loadTx
+
+// This function sets TRX_CTRL_1.SPI_CMD_MODE so that the first byte the AT86RF233 sends back in every SPI transaction is the content of
+// TRX_STATUS. The state of the radio can then be followed for free on the SPI traffic we already do (see AT86_lastStatus).
+static void _configSpiStatus(void)
+{
+    uint8_t tmp = REG_read(REG__TRX_CTRL_1); // Read register containing the SPI_CMD_MODE field
+    tmp &= ~MASK__TRX_CTRL_1__SPI_CMD_MODE; // Modify SPI_CMD_MODE field without changing other fields
+    tmp |= (1<<SHIFT__TRX_CTRL_1__SPI_CMD_MODE); // 1: PHY_STATUS is TRX_STATUS
+    REG_write(REG__TRX_CTRL_1, tmp); // Update register value
+}
+
+// This function sets TRX_CTRL_1.IRQ_2_EXT_EN so that the AT86RF233 raises DIG2 when it detects the SFD of a frame it receives, at the same
+// time as RX_START, and lowers it once the frame has ended. The pin is wired to a capture input of the timestamp timer (see AT86_getRxStart).
+static void _configTimestamp(void)
+{
+    uint8_t tmp = REG_read(REG__TRX_CTRL_1); // Read register containing the IRQ_2_EXT_EN field
+    tmp |= MASK__TRX_CTRL_1__IRQ_2_EXT_EN; // 1: frame timestamp on DIG2
+    REG_write(REG__TRX_CTRL_1, tmp); // Update register value
+}
+
+// This function lowers SLP_TR again after it has started a transmission, taking the pin back from its timer, so that the next transmission or
+// sleep gets a new rising edge.
+static void _releaseWakeup(void)
+{
+    if(!wakeup_raised)
+        return;
+    GPIO_setOutputLowOnPin(AT86_WAKEUP_PORT, AT86_WAKEUP_PIN);
+    GPIO_setAsOutputPin(AT86_WAKEUP_PORT, AT86_WAKEUP_PIN); // Back from the timer output to the (low) output latch
+    Timer_A_stop(AT86_WAKEUP_TIMER_BASE);
+    wakeup_raised = false;
+}
+
+// This function forgets the ongoing transmission or reception, if any, without calling its completion callback. It is called when a state
+// change cuts the operation short.
+static void _abandon(void)
+{
+    _releaseWakeup();
+    start_handler = NULL;
+    done_handler = NULL;
+    busy = false;
+}
+
+// This function enables the AT86RF233 interrupts the driver follows and the MSP430 interrupt on the IRQ pin. The pin interrupt stays enabled
+// from then on: the interrupt handler reads IRQ_STATUS, which releases the pin so that the next interrupt produces a new edge.
+static void _configIrq(void)
+{
+    GPIO_disableInterrupt(AT86_IRQ_PORT, AT86_IRQ_PIN); // Don't take the interrupt while reconfiguring it
+    REG_write(REG__IRQ_MASK, IRQ_EVENTS); // Enable AT86RF233 interrupts the driver follows
+    GPIO_clearInterrupt(AT86_IRQ_PORT, AT86_IRQ_PIN); // Clear stale edges before releasing the pin, so a new edge is not lost
+    REG_read(REG__IRQ_STATUS); // Clear pending AT86RF233 interrupts
+    event_head = event_tail = 0; // Forget queued interrupts
+    _abandon(); // Nothing is in progress anymore
+    GPIO_enableInterrupt(AT86_IRQ_PORT, AT86_IRQ_PIN);
+}
 
 // This function initializes the MSP430 peripherals used to interact with the AT86RF233, then puts the AT86RF233 in an idle state.
 void AT86_init(void)
@@ -25,16 +98,59 @@ void AT86_init(void)
     GPIO_disableInterrupt(AT86_IRQ_PORT, AT86_IRQ_PIN);
     GPIO_selectInterruptEdge(AT86_IRQ_PORT, AT86_IRQ_PIN, GPIO_LOW_TO_HIGH_TRANSITION);
     GPIO_clearInterrupt(AT86_IRQ_PORT, AT86_IRQ_PIN);
+    GPIO_setAsPeripheralModuleFunctionInputPin(AT86_DIG2_PORT, AT86_DIG2_PIN); // Initialize GPIO pin going to AT86RF233 DIG2 pin as a timer capture input
+    Timer_A_initCaptureModeParam capture_settings = // Capture the count of the timestamp timer on the rising edge of DIG2, without an interrupt
+    {
+     .captureRegister = AT86_DIG2_TIMER_REG,
+     .captureMode = TIMER_A_CAPTUREMODE_RISING_EDGE,
+     .captureInputSelect = TIMER_A_CAPTURE_INPUTSELECT_CCIxA,
+     .synchronizeCaptureSource = TIMER_A_CAPTURE_SYNCHRONOUS,
+     .captureInterruptEnable = TIMER_A_CAPTURECOMPARE_INTERRUPT_DISABLE,
+     .captureOutputMode = TIMER_A_OUTPUTMODE_OUTBITVALUE
+    };
+    Timer_A_initCaptureMode(AT86_TIMER_BASE, &capture_settings);
     SPI_init(); // Initialize SPI module used to talk to AT86RF233
     GPIO_setOutputHighOnPin(AT86_PWR_PORT, AT86_PWR_PIN); // Supply power to the AT86RF233
+    REG_invalidate(); // Registers start at their reset values
     volatile uint32_t delay_idx;
     for(delay_idx=100000; delay_idx>0; --delay_idx); // Delay to give AT86RF233 time to turn on
-    REG_write(REG__IRQ_MASK, 0); // Disable interrupts from AT86RF233
-    REG_read(REG__IRQ_STATUS); // Clear pending AT86RF233 interrupts
+    _configSpiStatus(); // Have every SPI transaction report the AT86RF233 state
+    _configTimestamp(); // Have DIG2 mark the start of received frames
+    _configIrq(); // Follow AT86RF233 interrupts from the IRQ pin interrupt handler
     AT86_sendCmd(cmdFORCE_TRX_OFF); // Put AT86RF233 in idle state
-    AT86_Status_Enum status = AT86_getStatus();
-    while(status != statusTRX_OFF) // Wait until AT86RF233 has transitioned to idle state
-        status = AT86_getStatus();
+    AT86_waitStatus(statusTRX_OFF); // Wait until AT86RF233 has transitioned to idle state
+}
+
+// This function resets the AT86RF233 through its RESET pin, which returns every register to its reset value, and waits until it is idle.
+void AT86_reset(void)
+{
+    GPIO_setOutputLowOnPin(AT86_RESET_PORT, AT86_RESET_PIN); // Pull RESET low for at least 625 ns
+    volatile uint8_t delay_idx;
+    for(delay_idx=10; delay_idx>0; --delay_idx);
+    GPIO_setOutputHighOnPin(AT86_RESET_PORT, AT86_RESET_PIN);
+    REG_invalidate(); // Registers are back to their reset values
+    tx_loaded = false; // The frame buffer is not kept through a reset.
+    _configSpiStatus(); // Have every SPI transaction report the AT86RF233 state again
+    _configTimestamp(); // Have DIG2 mark the start of received frames again
+    _configIrq(); // Interrupts are back to their reset configuration as well
+    AT86_waitStatus(statusTRX_OFF); // Wait until AT86RF233 is in the idle state
+}
+
+// This function puts the AT86RF233 to sleep by raising its SLP_TR (WAKEUP) pin. It is first put in the idle state, from which it can sleep.
+void AT86_sleep(void)
+{
+    _abandon(); // Whatever was in progress is cut short
+    AT86_sendCmd(cmdFORCE_TRX_OFF); // Put AT86RF233 in idle state
+    AT86_waitStatus(statusTRX_OFF);
+    GPIO_setOutputHighOnPin(AT86_WAKEUP_PORT, AT86_WAKEUP_PIN); // Go to sleep
+    REG_invalidate(); // Don't trust cached register values once it has slept
+}
+
+// This function wakes the AT86RF233 from sleep and waits until it is back in the idle state.
+void AT86_wakeup(void)
+{
+    GPIO_setOutputLowOnPin(AT86_WAKEUP_PORT, AT86_WAKEUP_PIN); // Start the crystal oscillator again
+    AT86_waitStatus(statusTRX_OFF); // Wait until AT86RF233 is awake
 }
 
 // This function reads and returns the AT86RF233 part number.
@@ -88,7 +204,8 @@ void AT86_setAddrShort(uint16_t address)
     REG_write(REG__SHORT_ADDR_1, address>>8); // Write MSB of short address to register
 }
 
-// This function reads the current channel on which the AT86RF233 is receiving and transmitting.
+// This function reads the current channel on which the AT86RF233 is receiving and transmitting. It only applies while CC_CTRL_1.CC_BAND is
+// 0; AT86_setFreq tunes elsewhere.
 uint8_t AT86_getChan(void)
 {
     uint8_t rv = REG_read(REG__PHY_CC_CCA); // Read register containing channel
@@ -97,13 +214,133 @@ uint8_t AT86_getChan(void)
     return rv; // Return channel
 }
 
-// This function sets the channel on which the AT86RF233 will receive and transmit.
+// This function returns whether the frequency of the AT86RF233 is set by its channel (CC_CTRL_1.CC_BAND is 0) rather than by AT86_setFreq.
+static bool _chanMode(void)
+{
+    return ((REG_read(REG__CC_CTRL_1) & MASK__CC_CTRL_1__CC_BAND) >> SHIFT__CC_CTRL_1__CC_BAND) == CC_BAND_CHANNEL;
+}
+
+// This function sets the channel on which the AT86RF233 will receive and transmit, tuning back to it if AT86_setFreq tuned elsewhere.
 void AT86_setChan(uint8_t channel)
 {
     uint8_t tmp = REG_read(REG__PHY_CC_CCA); // Read register containing channel field
     tmp &= ~MASK__PHY_CC_CCA__CHANNEL; // Modify channel field without changing other fields
     tmp |= (channel<<SHIFT__PHY_CC_CCA__CHANNEL);
     REG_write(REG__PHY_CC_CCA, tmp); // Update register value
+    if(!_chanMode()) // The channel only takes effect once CC_BAND is 0 again; setting it last retunes once.
+        REG_write(REG__CC_CTRL_1, CC_BAND_CHANNEL<<SHIFT__CC_CTRL_1__CC_BAND);
+}
+
+// This function reads the center frequency at which the AT86RF233 is receiving and transmitting, whether it comes from the channel or from
+// AT86_setFreq.
+//  returns: frequency (MHz).
+uint16_t AT86_getFreq(void)
+{
+    if(_chanMode())
+        return AT86_CHAN_FREQ(AT86_getChan());
+    return CC_BAND_BASE + ((REG_read(REG__CC_CTRL_0) & MASK__CC_CTRL_0__CC_NUMBER) >> SHIFT__CC_CTRL_0__CC_NUMBER);
+}
+
+// This function tunes the AT86RF233 to any center frequency of the 2.4 GHz band in 1 MHz steps through CC_CTRL_0 and CC_CTRL_1, in place of
+// the 5 MHz grid of the channels. It lasts until AT86_setChan.
+//  freq: frequency (MHz), limited to AT86_FREQ_MIN to AT86_FREQ_MAX.
+void AT86_setFreq(uint16_t freq)
+{
+    if(freq < AT86_FREQ_MIN)
+        freq = AT86_FREQ_MIN;
+    else if(freq > AT86_FREQ_MAX)
+        freq = AT86_FREQ_MAX;
+    REG_write(REG__CC_CTRL_0, (freq - CC_BAND_BASE)<<SHIFT__CC_CTRL_0__CC_NUMBER);
+    if(_chanMode()) // Already in the band otherwise
+        REG_write(REG__CC_CTRL_1, CC_BAND_2_4GHZ<<SHIFT__CC_CTRL_1__CC_BAND);
+}
+
+// This function returns whether the PLL of the AT86RF233 is running in a given state, so that it has to lock again after a channel change.
+static bool _pllRunning(AT86_Status_Enum status)
+{
+    return (status != statusP_ON) && (status != statusTRX_OFF) && (status != statusSLEEP) && (status != statusPREP_DEEP_SLEEP);
+}
+
+// This function waits until the IRQ interrupt handler has seen PLL_LOCK since pll_locked was cleared, for at most AT86_PLL_LOCK_TIMEOUT.
+// It polls the timer rather than sleeping, as nothing would wake us up if PLL_LOCK never came.
+//  returns: whether the PLL locked in time.
+static bool _waitPllLock(void)
+{
+    uint16_t start = TIMER_R; // Count the wait is timed from
+    while(!pll_locked) // The IRQ interrupt handler sets it
+    {
+        if((uint16_t) (TIMER_R - start) >= AT86_PLL_LOCK_TIMEOUT) // Failed to lock, or PLL_LOCK was lost
+            return false;
+    }
+    return true;
+}
+
+// This function moves the AT86RF233 to another center frequency as fast as it can. Outside TRX_OFF (and sleep), a frequency change has the
+// PLL lock again, after the center frequency calibration the radio runs by itself (up to 35 us). The function waits for the PLL_LOCK
+// interrupt, rather than for a fixed worst-case time, so the radio is ready as soon as it returns. Interrupts must be enabled.
+//  freq: frequency (MHz), AT86_FREQ_MIN to AT86_FREQ_MAX.
+//  chan: channel to tune to through PHY_CC_CCA, whose frequency is freq, or 0 to tune to freq through CC_CTRL_0 and CC_CTRL_1.
+//  returns: false if the PLL did not lock on the frequency in time.
+static bool _hop(uint16_t freq, uint8_t chan)
+{
+    uint16_t from = AT86_getFreq();
+    bool chan_mode = _chanMode();
+    if((freq == from) && ((chan == 0) ? !chan_mode : (chan_mode && (chan == AT86_getChan())))) // No relock without a change
+        return true;
+    bool relock = (freq != from) && _pllRunning(AT86_getStatus()); // Moving between a channel and its own frequency doesn't retune.
+    pll_locked = false;
+    if(chan != 0)
+        AT86_setChan(chan);
+    else
+        AT86_setFreq(freq);
+    if(!relock) // The PLL calibrates and locks once it is turned on.
+        return true;
+    return _waitPllLock();
+}
+
+// This function moves the AT86RF233 to another channel as fast as it can (see _hop). Interrupts must be enabled.
+//  chan: channel, AT86_CHAN_MIN to AT86_CHAN_MAX; others are ignored.
+//  returns: false if the PLL did not lock on the channel in time.
+bool AT86_hopChan(uint8_t chan)
+{
+    if((chan < AT86_CHAN_MIN) || (chan > AT86_CHAN_MAX))
+        return true;
+    return _hop(AT86_CHAN_FREQ(chan), chan);
+}
+
+// This function moves the AT86RF233 to another center frequency as fast as it can (see _hop). Interrupts must be enabled.
+//  freq: frequency (MHz), limited to AT86_FREQ_MIN to AT86_FREQ_MAX.
+//  returns: false if the PLL did not lock on the frequency in time.
+bool AT86_hopFreq(uint16_t freq)
+{
+    if(freq < AT86_FREQ_MIN)
+        freq = AT86_FREQ_MIN;
+    else if(freq > AT86_FREQ_MAX)
+        freq = AT86_FREQ_MAX;
+    return _hop(freq, 0);
+}
+
+// This function has the AT86RF233 calibrate its PLL at the current frequency: the delay cell (PLL_DCU) and the center frequency (PLL_CF).
+// The datasheet recommends it when the PLL has been running for minutes or the temperature has changed. Does nothing to a PLL that is not
+// running: it is calibrated when turned on. Gives up if the calibrations don't end within AT86_PLL_LOCK_TIMEOUT, e.g. because the radio
+// left the PLL state.
+void AT86_calibratePll(void)
+{
+    if(!_pllRunning(AT86_getStatus()))
+        return;
+    REG_write(REG__PLL_DCU, RST__PLL_DCU | MASK__PLL_DCU__PLL_DCU_START); // Start both calibrations
+    REG_write(REG__PLL_CF, REG_read(REG__PLL_CF) | MASK__PLL_CF__PLL_CF_START);
+    uint16_t start = TIMER_R; // Count the calibrations are timed from
+    while(REG_read(REG__PLL_CF) & MASK__PLL_CF__PLL_CF_START) // START bits clear once done; the CF one takes longer.
+    {
+        if((uint16_t) (TIMER_R - start) >= AT86_PLL_LOCK_TIMEOUT)
+            return;
+    }
+    while(REG_read(REG__PLL_DCU) & MASK__PLL_DCU__PLL_DCU_START)
+    {
+        if((uint16_t) (TIMER_R - start) >= AT86_PLL_LOCK_TIMEOUT)
+            return;
+    }
 }
 
 // This function reads the PAN ID of the AT86RF233.
@@ -146,15 +383,66 @@ void AT86_setTxPower(int16_t power)
     REG_write(REG__PHY_TX_PWR, dbm_to_tx_pow[power]); // set register to value of array corresponding to input power
 }
 
-// This function reads the AT86 status register to determine its current state.
+// This function reads the data rate at which the AT86RF233 transmits and receives the PSDU of a frame.
+AT86_Rate_Enum AT86_getDataRate(void)
+{
+    uint8_t tmp = REG_read(REG__TRX_CTRL_2); // Read register containing data rate
+    tmp &= MASK__TRX_CTRL_2__OQPSK_DATA_RATE; // Extract data rate
+    tmp >>= SHIFT__TRX_CTRL_2__OQPSK_DATA_RATE;
+    return (AT86_Rate_Enum) tmp; // Return data rate
+}
+
+// This function sets the data rate at which the AT86RF233 transmits and receives the PSDU of a frame. Both ends of a link need the same
+// rate: a receiver only finds frames sent at its own.
+//  rate: data rate.
+//  scrambler: whether the PSDU is scrambled at the rates above 250 kb/s, which avoids long runs of one chip sequence (1 after reset).
+void AT86_setDataRate(AT86_Rate_Enum rate, bool scrambler)
+{
+    uint8_t tmp = REG_read(REG__TRX_CTRL_2); // Read register containing data rate and scrambler fields
+    tmp &= ~(MASK__TRX_CTRL_2__OQPSK_DATA_RATE|MASK__TRX_CTRL_2__OQPSK_SCRAM_EN); // Modify them without changing RX_SAFE_MODE
+    tmp |= (rate<<SHIFT__TRX_CTRL_2__OQPSK_DATA_RATE) & MASK__TRX_CTRL_2__OQPSK_DATA_RATE;
+    tmp |= scrambler<<SHIFT__TRX_CTRL_2__OQPSK_SCRAM_EN;
+    REG_write(REG__TRX_CTRL_2, tmp); // Update register value
+}
+
+// This function computes how long a frame spends on the air at the current data rate: preamble, SFD and PHR (6 bytes) at 250 kb/s, then the
+// PSDU at the selected rate. It doesn't count the 16 us from TX_START to the start of the preamble.
+//  len: bytes in the PSDU, FCS included.
+// Returns the airtime in us.
+uint16_t AT86_getAirtime(uint8_t len)
+{
+    return 32U*6U + ((32U*len) >> AT86_getDataRate()); // 32 us per byte at 250 kb/s
+}
+
+// This function reads the AT86 status register to determine its current state. The register content arrives as the PHY_STATUS byte, so only
+// the command byte of a register read is exchanged.
 AT86_Status_Enum AT86_getStatus(void)
 {
-    uint8_t tmp = REG_read(REG__TRX_STATUS); // Read register containing status
+    uint8_t tmp = REG_status(); // Retrieve content of register containing status
+    tmp &= MASK__TRX_STATUS__TRX_STATUS; // Extract status from value
+    tmp >>= SHIFT__TRX_STATUS__TRX_STATUS;
+    return (AT86_Status_Enum) tmp; // Return status
+}
+
+// This function returns the state the AT86RF233 reported at the start of the latest SPI transaction, whatever that transaction was. It costs
+// no SPI traffic, but may be out of date: the state can have changed since, and a transaction that sends a command reports the state from
+// before the command.
+AT86_Status_Enum AT86_lastStatus(void)
+{
+    uint8_t tmp = REG_lastStatus(); // Retrieve PHY_STATUS byte of the latest transaction
     tmp &= MASK__TRX_STATUS__TRX_STATUS; // Extract status from value
     tmp >>= SHIFT__TRX_STATUS__TRX_STATUS;
     return (AT86_Status_Enum) tmp; // Return status
 }
 
+// This function waits until the AT86RF233 is in the given state, which must be one it stays in until it is commanded to leave (TRX_OFF,
+// PLL_ON, RX_ON, ...). If the latest SPI transaction already reported that state, no SPI traffic is needed.
+void AT86_waitStatus(AT86_Status_Enum status)
+{
+    while(AT86_lastStatus() != status)
+        AT86_getStatus();
+}
+
 // This function sends one of a list of commands to the AT86RF233 to cause it to perform some action -- e.g. transmit a payload, or change state.
 void AT86_sendCmd(AT86_Cmd_Enum cmd)
 {
@@ -176,77 +464,320 @@ uint8_t AT86_getPhase(void)
     return REG_read(REG__PHY_PMU_VALUE); // Retrieve latest measurement from appropriate register
 }
 
-// This function sets the AT86RF233 to a state from which it can transmit a payload.
-void AT86_prepareTx(void)
+// This function sets how many times a transmission in TX_ARET_ON is retried: the frame, when it is not acknowledged, and the CSMA-CA
+// algorithm, when the channel is busy.
+//  frame_retries: retransmissions of a frame that is not acknowledged, 0 to 15.
+//  csma_retries: further CSMA-CA attempts after the channel was found busy, 0 to 5; 7 transmits at once, without CSMA-CA.
+void AT86_setRetries(uint8_t frame_retries, uint8_t csma_retries)
+{
+    uint8_t tmp = REG_read(REG__XAH_CTRL_0); // Read register containing the retry fields
+    tmp &= ~(MASK__XAH_CTRL_0__MAX_FRAME_RETRIES|MASK__XAH_CTRL_0__MAX_CSMA_RETRIES); // Modify them without changing SLOTTED_OPERATION
+    tmp |= (frame_retries<<SHIFT__XAH_CTRL_0__MAX_FRAME_RETRIES) & MASK__XAH_CTRL_0__MAX_FRAME_RETRIES;
+    tmp |= (csma_retries<<SHIFT__XAH_CTRL_0__MAX_CSMA_RETRIES) & MASK__XAH_CTRL_0__MAX_CSMA_RETRIES;
+    REG_write(REG__XAH_CTRL_0, tmp); // Update register value
+}
+
+// This function sets the backoff exponents of the CSMA-CA algorithm of TX_ARET_ON. Before each clear channel assessment, the AT86RF233 waits
+// a random number of 320 us backoff periods below 2^BE; BE starts at min_be and grows by one after every busy channel, up to max_be.
+//  min_be: first backoff exponent, 0 to max_be; 0 skips the backoff of the first attempt.
+//  max_be: largest backoff exponent, 3 to 8.
+void AT86_setBackoff(uint8_t min_be, uint8_t max_be)
+{
+    REG_write(REG__CSMA_BE, ((max_be<<SHIFT__CSMA_BE__MAX_BE) & MASK__CSMA_BE__MAX_BE) | ((min_be<<SHIFT__CSMA_BE__MIN_BE) & MASK__CSMA_BE__MIN_BE));
+}
+
+// This function seeds the random number generator of the CSMA-CA algorithm. Boards that share a channel should use different seeds, e.g.
+// their short addresses, so that their backoffs differ.
+//  seed: 11-bit seed.
+void AT86_setCsmaSeed(uint16_t seed)
+{
+    REG_write(REG__CSMA_SEED_0, seed&0xFF); // Write the low 8 bits of the seed to the register
+    uint8_t tmp = REG_read(REG__CSMA_SEED_1); // Read register containing the high 3 bits, shared with RX_AACK_ON settings
+    tmp &= ~MASK__CSMA_SEED_1__CSMA_SEED_1; // Modify them without changing the other fields
+    tmp |= ((seed>>8)<<SHIFT__CSMA_SEED_1__CSMA_SEED_1) & MASK__CSMA_SEED_1__CSMA_SEED_1;
+    REG_write(REG__CSMA_SEED_1, tmp); // Update register value
+}
+
+// This function reads the outcome of the latest transaction in the extended operating mode from TRX_STATE.TRAC_STATUS: for TX_ARET_ON, whether
+// the frame was acknowledged, or the channel was never clear, or no ACK came; for RX_AACK_ON, whether a requested ACK was sent.
+AT86_Trac_Enum AT86_getTrac(void)
+{
+    uint8_t tmp = REG_read(REG__TRX_STATE); // Read register containing TRAC_STATUS
+    tmp &= MASK__TRX_STATE__TRAC_STATUS; // Extract it from value
+    tmp >>= SHIFT__TRX_STATE__TRAC_STATUS;
+    return (AT86_Trac_Enum) tmp; // Return outcome
+}
+
+// This function reads how many times the latest transmission in TX_ARET_ON was sent again because it was not acknowledged.
+uint8_t AT86_getAretRetries(void)
+{
+    uint8_t tmp = REG_read(REG__XAH_CTRL_2); // Read register containing ARET_FRAME_RETRIES
+    tmp &= MASK__XAH_CTRL_2__ARET_FRAME_RETRIES; // Extract it from value
+    tmp >>= SHIFT__XAH_CTRL_2__ARET_FRAME_RETRIES;
+    return tmp; // Return retries
+}
+
+// This function puts the AT86RF233 in a state from which it can transmit, once it is done transmitting. A reception in progress is cut
+// short, but the ACK of a frame that has been received in RX_AACK_ON is let out first.
+//  cmd: command of the state, cmdPLL_ON or cmdTX_ARET_ON.
+//  ext: whether that state belongs to the extended operating mode.
+static void _prepareTx(AT86_Cmd_Enum cmd, bool ext)
 {
     AT86_Status_Enum status;
     do // Wait until the AT86RF233 is not transmitting anything
     {
         status = AT86_getStatus();
-    } while(status == statusBUSY_TX);
+    } while((status == statusBUSY_TX) || (status == statusBUSY_TX_ARET) || ((status == statusBUSY_RX_AACK) && !busy));
 
-    if(status == statusBUSY_RX) // Disable reception, if currently in receive mode
+    uint16_t gie = __get_interrupt_state(); // Interrupt state to return to.
+    __disable_interrupt(); // Don't let the reception complete while it is being forgotten.
+    _abandon(); // A reception in progress is cut short
+    __set_interrupt_state(gie);
+    if((status == statusBUSY_RX) || (status == statusBUSY_RX_AACK)) // Disable reception, if currently in receive mode
         AT86_sendCmd(cmdFORCE_TRX_OFF);
-    AT86_sendCmd(cmdPLL_ON); // Put in mode from which it can transmit a payload
+    else if(ext && ((status == statusRX_ON) || (status == statusRX_AACK_ON))) // TX_ARET_ON can't be reached from a receive state directly
+    {
+        AT86_sendCmd(cmdPLL_ON);
+        AT86_waitStatus(statusPLL_ON);
+    }
+    extended = ext;
+    AT86_sendCmd(cmd); // Put in mode from which it can transmit a payload
+}
+
+// This function sets the AT86RF233 to a state from which it can transmit a payload.
+void AT86_prepareTx(void)
+{
+    _prepareTx(cmdPLL_ON, false);
 }
 
-// This function loads a payload into the AT86RF233 TRX buffer, so that it can transmit it when commanded to.
+// This function sets the AT86RF233 to TX_ARET_ON, from which a payload is transmitted in the extended operating mode: TX_START (or SLP_TR)
+// starts the CSMA-CA algorithm, the frame goes out once the channel is clear, and if its frame control field requests an ACK it is sent again
+// until one arrives or the retries run out (see AT86_setRetries). TRX_END only comes at the end of the whole transaction, whose outcome is
+// then read with AT86_getTrac. The frame must start with an IEEE 802.15.4 MAC header.
+void AT86_prepareTxAret(void)
+{
+    _prepareTx(cmdTX_ARET_ON, true);
+}
+
+// This function loads a payload into the AT86RF233 TRX buffer, so that it can transmit it when commanded to. The buffer is not cleared by a
+// transmission, so the same payload can be sent again without loading it again, until a reception overwrites it (see AT86_txLoaded).
 void AT86_loadTx(const uint8_t * src, uint8_t len, uint8_t offset)
 {
     SRAM_write(0, &len, 1); // Write length of payload into TRX register
     SRAM_write(offset+1, src, len); // Write payload into TRX register
+    tx_loaded = true;
 }
 
-// This function commands the AT86RF233 to transmit the payload it currently has in its TRX buffer.
-void AT86_execTx(void)
+// This function rewrites part of the payload loaded by AT86_loadTx, leaving its length and the rest of it as they are. The AT86RF233 reads
+// the PSDU from the buffer as it transmits it, so the bytes can be written after the transmission has been started, as long as each is written
+// before it goes on the air: the SHR and PHR give 192 us. A byte written too late is reported by TRX_UR together with TRX_END.
+//  src: new bytes.
+//  len: number of them.
+//  offset: position of the first of them in the payload.
+void AT86_patchTx(const uint8_t * src, uint8_t len, uint8_t offset)
 {
+    SRAM_write(offset+1, src, len); // Write the bytes into TRX register
+}
+
+// This function returns whether the TRX buffer still holds the payload last loaded by AT86_loadTx, so that it can be transmitted again or
+// patched (AT86_patchTx) rather than loaded in full. Receptions and resets overwrite it; so does writing the buffer other than through this
+// driver, after which AT86_forgetTx must be called.
+bool AT86_txLoaded(void)
+{
+    return tx_loaded;
+}
+
+// This function records that the TRX buffer no longer holds the payload last loaded by AT86_loadTx.
+void AT86_forgetTx(void)
+{
+    tx_loaded = false;
+}
+
+// This function commands the AT86RF233 to transmit the payload it currently has in its TRX buffer, and returns without waiting for it to be sent.
+//  done: called from the IRQ interrupt handler once the payload has been sent (TRX_END) or could not be (TRX_UR), or NULL.
+void AT86_execTx(AT86_Handler done)
+{
+    start_handler = NULL;
+    done_handler = done; // Completes on the next TRX_END
+    busy = true;
     AT86_sendCmd(cmdTX_START); // Send AT86RF233 command to transmit payload currently in its buffer
 }
 
-// This function puts the AT86RF233 in a state from which it will receive payloads.
-void AT86_prepareRx(void)
+// This function has the AT86RF233 transmit the payload it currently has in its TRX buffer at a set time, and returns without waiting for it
+// to be sent. A compare output of AT86_WAKEUP_TIMER_BASE raises SLP_TR when the count of AT86_TIMER_BASE reaches the given value, which
+// starts the transmission from PLL_ON without the SPI and CPU jitter of a TX_START command. AT86_WAKEUP_TIMER_BASE is started here, from the
+// same clock, and its offset from AT86_TIMER_BASE read back, so the edge is within a tick (200 ns) of the requested time. The AT86RF233 must
+// already be in PLL_ON, or in TX_ARET_ON, where the edge starts the CSMA-CA algorithm rather than the frame itself.
+//  count: count of AT86_TIMER_BASE at which to start, less than half a turn of the timer (6.5 ms) ahead. If it is fewer than
+//   AT86_TX_AT_MIN_LEAD ticks ahead, or has passed, SLP_TR is raised at once instead.
+//  done: called from the IRQ interrupt handler once the payload has been sent (TRX_END) or could not be (TRX_UR), or NULL.
+// Returns false if the transmission was started at once rather than at count.
+bool AT86_execTxAt(uint16_t count, AT86_Handler done)
 {
-    irq_pending = false; // Indicate that we are addressing the payload received interrupt.
-    AT86_readIstat(); // Clear pending interrupts in the AT86RF233.
-    REG_write(REG__IRQ_MASK, irqRX_START|irqTRX_END); // Enable AT86RF233 interrupts when reception starts or ends.
-    GPIO_clearInterrupt(AT86_IRQ_PORT, AT86_IRQ_PIN); // Reset MSP430 interrupt on the IRQ GPIO pin, so we can receive the next interrupt
-    GPIO_enableInterrupt(AT86_IRQ_PORT, AT86_IRQ_PIN);
-    AT86_sendCmd(cmdRX_ON); // Send command to enable reception
+    Timer_A_initContinuousModeParam timera_settings = // Same clock as AT86_TIMER_BASE
+    {
+     .clockSource = TIMER_A_CLOCKSOURCE_SMCLK,
+     .clockSourceDivider = AT86_TIMER_DIVIDER,
+     .timerInterruptEnable_TAIE = TIMER_A_TAIE_INTERRUPT_DISABLE,
+     .timerClear = TIMER_A_DO_CLEAR,
+     .startTimer = true
+    };
+    Timer_A_initCompareModeParam compare_settings = // Output set when the count reaches the start time
+    {
+     .compareRegister = AT86_WAKEUP_TIMER_REG,
+     .compareInterruptEnable = TIMER_A_CAPTURECOMPARE_INTERRUPT_DISABLE,
+     .compareOutputMode = TIMER_A_OUTPUTMODE_SET,
+     .compareValue = 0
+    };
+    start_handler = NULL;
+    done_handler = done; // Completes on the next TRX_END
+    busy = true;
+    wakeup_raised = true;
+    uint16_t gie = __get_interrupt_state(); // Interrupt state to return to.
+    __disable_interrupt(); // An interrupt handler must not delay the set-up past the start time.
+    bool on_time = ((int16_t) (count - TIMER_R) >= (int16_t) AT86_TX_AT_MIN_LEAD);
+    if(on_time)
+    {
+        Timer_A_initContinuousMode(AT86_WAKEUP_TIMER_BASE, &timera_settings);
+        compare_settings.compareValue = count + (uint16_t) (WAKEUP_TIMER_R - TIMER_R); // Start time in the count of the wakeup timer
+        Timer_A_setOutputMode(AT86_WAKEUP_TIMER_BASE, AT86_WAKEUP_TIMER_REG, TIMER_A_OUTPUTMODE_OUTBITVALUE); // Output low until then
+        Timer_A_setOutputForOutputModeOutBitValue(AT86_WAKEUP_TIMER_BASE, AT86_WAKEUP_TIMER_REG, TIMER_A_OUTPUTMODE_OUTBITVALUE_LOW);
+        Timer_A_initCompareMode(AT86_WAKEUP_TIMER_BASE, &compare_settings);
+        GPIO_setAsPeripheralModuleFunctionOutputPin(AT86_WAKEUP_PORT, AT86_WAKEUP_PIN); // Hand SLP_TR to the timer
+    }
+    else
+        GPIO_setOutputHighOnPin(AT86_WAKEUP_PORT, AT86_WAKEUP_PIN); // Too late to schedule: start now
+    __set_interrupt_state(gie);
+    return on_time;
 }
 
-// This function is called to reset interrupts after we get the RX complete interrupt.
-void AT86_execRx(void)
+// This function puts the AT86RF233 in a receive state and sets up the completion of the reception.
+//  cmd: command of the state, cmdRX_ON or cmdRX_AACK_ON.
+//  ext: whether that state belongs to the extended operating mode.
+//  started, done: as for AT86_prepareRx.
+static void _prepareRx(AT86_Cmd_Enum cmd, bool ext, AT86_Handler started, AT86_Handler done)
 {
-    irq_pending = false; // Indicate that we have addressed the interrupt
-    GPIO_clearInterrupt(AT86_IRQ_PORT, AT86_IRQ_PIN); // Clear interrupt on GPIO pin so we can get the next AT86RF233 interrupt
-    GPIO_enableInterrupt(AT86_IRQ_PORT, AT86_IRQ_PIN);
+    if(ext || extended) // RX_AACK_ON is only reached from PLL_ON, and only left for RX_ON through it. Once an ACK is out, if one is being sent.
+    {
+        AT86_sendCmd(cmdPLL_ON);
+        AT86_waitStatus(statusPLL_ON);
+    }
+    extended = ext;
+    tx_loaded = false; // A received frame overwrites the buffer
+    start_handler = started;
+    done_handler = done; // Completes on the next TRX_END
+    busy = true;
+    Timer_A_clearCaptureCompareInterrupt(AT86_TIMER_BASE, AT86_DIG2_TIMER_REG); // Forget the timestamp of an earlier frame
+    AT86_sendCmd(cmd); // Send command to enable reception
+}
+
+// This function puts the AT86RF233 in a state from which it will receive a payload, and returns without waiting for one.
+//  started: called from the IRQ interrupt handler when the AT86RF233 starts receiving a payload (RX_START), or NULL.
+//  done: called from the IRQ interrupt handler once the payload has been received (TRX_END), or NULL. The payload can then be read with AT86_readRx.
+void AT86_prepareRx(AT86_Handler started, AT86_Handler done)
+{
+    _prepareRx(cmdRX_ON, false, started, done);
+}
+
+// This function puts the AT86RF233 in RX_AACK_ON, in which it only completes the reception of frames with a valid FCS that are addressed to
+// its PAN ID and short address (or broadcast), and answers those that request it with an ACK on its own, 192 us after the frame. Returns
+// without waiting for a frame.
+//  started: called from the IRQ interrupt handler when the AT86RF233 starts receiving a payload (RX_START), or NULL. It is called again for
+//   the next frame if the AT86RF233 drops this one.
+//  done: called from the IRQ interrupt handler once a frame that passed the filter has been received (TRX_END), or NULL. Its ACK is still
+//   being sent; AT86_prepareTx and AT86_cancel let it out.
+void AT86_prepareRxAack(AT86_Handler started, AT86_Handler done)
+{
+    _prepareRx(cmdRX_AACK_ON, true, started, done);
+}
+
+// This function retrieves the time at which the AT86RF233 detected the SFD of the payload it is receiving, as captured from its DIG2 pin by
+// the timestamp timer. It is meant to be called from the started callback of AT86_prepareRx, and only reports each capture once.
+//  count: where to store the count of the timestamp timer at the SFD (the low 16 bits of a TS_now timestamp).
+// Returns false if no frame has started since AT86_prepareRx, or the capture was already retrieved.
+bool AT86_getRxStart(uint16_t * count)
+{
+    if(!Timer_A_getCaptureCompareInterruptStatus(AT86_TIMER_BASE, AT86_DIG2_TIMER_REG, TIMER_A_CAPTURECOMPARE_INTERRUPT_FLAG))
+        return false;
+    *count = Timer_A_getCaptureCompareCount(AT86_TIMER_BASE, AT86_DIG2_TIMER_REG); // Count latched by the rising edge
+    Timer_A_clearCaptureCompareInterrupt(AT86_TIMER_BASE, AT86_DIG2_TIMER_REG);
+    return true;
 }
 
 // This function retrieves the latest payload received by the AT86RF233.
 void AT86_readRx(uint8_t * dest, uint8_t len, uint8_t offset)
 {
-    REG_write(REG__IRQ_MASK, 0); // Disable AT86RF233 interrupts, as we are done transmitting
     SRAM_read(offset, dest, len); // Read the payload that the AT86RF233 received
 }
 
-// This function reads the AT86RF233 interrupt status register so that we can tell which interrupt happened, since an IRQ pin level change indicates 1 of up to 8 possibilities.
-AT86_Irq_Enum AT86_readIstat(void)
+// This function gives up on a transmission or reception started with AT86_execTx or AT86_prepareRx that has not completed, without calling
+// its completion callback, and leaves the AT86RF233 in PLL_ON. A payload partly received is lost. If the operation has completed, the ACK
+// the AT86RF233 may still be sending for a frame received in RX_AACK_ON goes out first.
+void AT86_cancel(void)
+{
+    uint16_t gie = __get_interrupt_state(); // Interrupt state to return to.
+    __disable_interrupt(); // Don't let the operation complete while it is being forgotten.
+    bool was_busy = busy;
+    _abandon();
+    __set_interrupt_state(gie);
+    AT86_sendCmd(was_busy ? cmdFORCE_PLL_ON : cmdPLL_ON); // Stop receiving or transmitting; a TRX_END that follows finds no callback.
+}
+
+// This function indicates whether a transmission or reception started with AT86_execTx or AT86_prepareRx is still going on (true = yes).
+bool AT86_busy(void)
 {
-    irq_pending = false; // Indicate that we have dealt with the interrupt
-    return (AT86_Irq_Enum) REG_read(REG__IRQ_STATUS); // Return interrupt status register
+    return busy;
 }
 
-// This function indicates whether the AT86RF233 has issued an interrupt that has not yet been addressed (true = yes).
-bool AT86_irqPending(void)
+// This function retrieves the oldest interrupt the IRQ interrupt handler has queued. Each queued entry is a single AT86_Irq_Enum value, even
+// when several interrupts were flagged at once.
+//  event: where to store the interrupt.
+// Returns false if the queue is empty.
+bool AT86_getEvent(AT86_Irq_Enum * event)
 {
-    return irq_pending;
+    bool rv = false;
+    uint16_t gie = __get_interrupt_state(); // Interrupt state to return to.
+    __disable_interrupt(); // The interrupt handler may drop the oldest entry while we read it.
+    if(event_tail != event_head)
+    {
+        *event = (AT86_Irq_Enum) event_queue[event_tail];
+        event_tail = (event_tail+1) & (EVENT_QUEUE_LEN-1);
+        rv = true;
+    }
+    __set_interrupt_state(gie);
+    return rv;
 }
 
 // This interrupt happens whenever the IRQ pin has a rising edge. The AT86RF233 controls this pin, and sends a rising edge when one of its interrupts happens.
+// The handler reads IRQ_STATUS, which releases the pin, queues each interrupt it contains, and completes the ongoing transmission or reception.
 #pragma vector=PORT2_VECTOR
 void __attribute__ ((interrupt)) _pinIrqHandler(void)
 {
-    irq_pending = true; // Indicate that there is an unaddressed interrupt
-    GPIO_clearInterrupt(AT86_IRQ_PORT, AT86_IRQ_PIN); // Clear this interrupt
-    GPIO_disableInterrupt(AT86_IRQ_PORT, AT86_IRQ_PIN); // Disable subsequent interrupts until this one can be addressed
+    GPIO_clearInterrupt(AT86_IRQ_PORT, AT86_IRQ_PIN); // Clear this interrupt before reading IRQ_STATUS, so that a later edge is not lost
+    uint8_t irqs = REG_read(REG__IRQ_STATUS); // Find out which interrupts happened
+    uint8_t irq;
+    for(irq=0x01; irq!=0; irq<<=1) // Queue each of them
+    {
+        if(!(irqs & irq))
+            continue;
+        event_queue[event_head] = irq;
+        event_head = (event_head+1) & (EVENT_QUEUE_LEN-1);
+        if(event_head == event_tail) // Queue is full: drop the oldest interrupt
+            event_tail = (event_tail+1) & (EVENT_QUEUE_LEN-1);
+    }
+    if(irqs & irqPLL_LOCK) // _hop may be waiting for it
+        pll_locked = true;
+    if((irqs & irqRX_START) && (start_handler != NULL))
+        start_handler((AT86_Irq_Enum) irqs);
+    if(busy && (irqs & (irqTRX_END|irqTRX_UR))) // The ongoing operation is over
+    {
+        AT86_Handler handler = done_handler;
+        _releaseWakeup(); // SLP_TR low again, if it started a transmission
+        start_handler = NULL;
+        done_handler = NULL;
+        busy = false;
+        if(handler != NULL)
+            handler((AT86_Irq_Enum) irqs);
+    }
+    __bic_SR_register_on_exit(LPM0_bits); // Wake up code sleeping until a radio event
 }
@@ -7,11 +7,46 @@
 
 // This file contains basic functions to communicate with the AT86RF233 as described in the datasheet.
 
+#include <stddef.h>
 #include "hal.h"
 #include "registers.h"
 #include "usci_b_spi.h"
 #include "gpio.h"
 #include "ucs.h"
+#include "dma.h"
+
+#define REG_SHADOW_SIZE (0x40U) // Number of register addresses (6-bit)
+
+// Registers whose value only changes when we write them, so that reads can be served from a shadow copy. Status, measurement and calibration
+// registers (TRX_STATUS, TRX_STATE, PHY_RSSI, PHY_ED_LEVEL, ANT_DIV, IRQ_STATUS, VREG_CTRL, BATMON, XAH_CTRL_2, FTN_CTRL, PLL_CF, PLL_DCU,
+// PHY_PMU_VALUE) are left out and always read over SPI; XAH_CTRL_2 holds the ARET_FRAME_RETRIES count the radio updates. Bit n of entry k
+// covers register 8k+n.
+static const uint8_t shadow_cacheable[REG_SHADOW_SIZE/8] =
+{
+ 0x38, // TRX_CTRL_0, TRX_CTRL_1, PHY_TX_PWR
+ 0x5F, // PHY_CC_CCA, CCA_THRES, RX_CTRL, SFD_VALUE, TRX_CTRL_2, IRQ_MASK
+ 0xFC, // XOSC_CTRL, CC_CTRL_0, CC_CTRL_1, RX_SYN, TRX_RPC, XAH_CTRL_1
+ 0xF0, // PART_NUM, VERSION_NUM, MAN_ID_0, MAN_ID_1
+ 0xFF, // SHORT_ADDR_0 to IEEE_ADDR_3
+ 0xFF, // IEEE_ADDR_4 to CSMA_BE
+ 0x00,
+ 0x00
+};
+static uint8_t shadow[REG_SHADOW_SIZE]; // Last value read from or written to each cacheable register
+static uint8_t shadow_valid[REG_SHADOW_SIZE/8]; // Which entries of shadow are up to date, same layout as shadow_cacheable
+static volatile uint8_t phy_status = 0x00; // PHY_STATUS byte sent by the AT86RF233 at the start of the latest SPI transaction
+static void (* volatile bus_reclaim)(void) = NULL; // Function that takes the SPI bus back from the module it has been lent to, or NULL
+
+#define SPI_IFG   HWREG8(AT86_SPI_BASE + OFS_UCBxIFG) // SPI module registers used directly by the streaming loop in _stream
+#define SPI_TXBUF HWREG8(AT86_SPI_BASE + OFS_UCBxTXBUF)
+#define SPI_RXBUF HWREG8(AT86_SPI_BASE + OFS_UCBxRXBUF)
+
+#if AT86_SPI_DMA
+static volatile bool burst_done = true; // Set by the DMA interrupt once the last byte of a burst has been received
+static uint8_t burst_dummy; // Source of the filler bytes clocked out during reads, and sink for the bytes clocked in during writes
+
+static void _dmaInit(void);
+#endif
 
 // This function initializes the MSP430 SPI module and GPIO pins that will be used to talk to the AT86RF233.
 void    SPI_init(void)
@@ -33,68 +68,248 @@ void    SPI_init(void)
     GPIO_setAsPeripheralModuleFunctionInputPin(AT86_MOSI_PORT, AT86_MOSI_PIN); // Initialize the MOSI GPIO pin.
     GPIO_setAsPeripheralModuleFunctionInputPin(AT86_SCK_PORT, AT86_SCK_PIN); // Initialize the SPI clock GPIO pin.
     GPIO_setAsPeripheralModuleFunctionInputPin(AT86_MISO_PORT, AT86_MISO_PIN); // Initialize the MISO GPIO pin.
+#if AT86_SPI_DMA
+    _dmaInit(); // Set up the DMA channels used for long transfers.
+#endif
+}
+
+// This function exchanges the bytes of a transaction with the AT86RF233, keeping the SPI transmit buffer loaded so that consecutive bytes go
+// out back to back: the next byte is written as soon as the previous one has moved into the shift register, and each response is collected
+// while the following byte is on the bus. At most two bytes are in flight, so each response has to be read within one byte time (about 1.2 us)
+// of its arrival; the loop accesses the USCI registers directly to stay well within that. Must be called with SS low and interrupts disabled.
+//  hdr: command bytes (command, then address if there is one).
+//  hdr_len: number of command bytes (at least 1).
+//  src: data bytes to transmit after the command bytes, or NULL to transmit zeros.
+//  dest: where to store the responses to the data bytes, or NULL to discard them.
+//  len: number of data bytes.
+// Returns the byte the AT86RF233 sent back during the first command byte.
+static uint8_t _stream(const uint8_t * hdr, uint8_t hdr_len, const uint8_t * src, uint8_t * dest, uint8_t len)
+{
+    uint16_t total = hdr_len + len; // Bytes in the transaction
+    uint16_t tx_idx = 0; // Next byte to load into the transmit buffer
+    uint16_t rx_idx = 0; // Next byte whose response we are waiting for
+    uint8_t first = 0; // Response to the first command byte
+    while(rx_idx < total)
+    {
+        if((tx_idx < total) && ((tx_idx-rx_idx) < 2) && (SPI_IFG & UCTXIFG)) // Transmit buffer is free: load the next byte.
+        {
+            if(tx_idx < hdr_len)
+                SPI_TXBUF = hdr[tx_idx];
+            else
+                SPI_TXBUF = (src != NULL) ? src[tx_idx-hdr_len] : 0x00;
+            ++tx_idx;
+        }
+        if(SPI_IFG & UCRXIFG) // A byte has been exchanged: collect the response.
+        {
+            uint8_t value = SPI_RXBUF;
+            if(rx_idx == 0)
+                first = value;
+            else if((rx_idx >= hdr_len) && (dest != NULL))
+                dest[rx_idx-hdr_len] = value;
+            ++rx_idx;
+        }
+    }
+    return first;
+}
+
+#if AT86_SPI_DMA
+// This function configures the two DMA channels that carry out bursts: one moves each received byte out of the SPI receive buffer as soon as
+// it arrives, the other refills the transmit buffer as soon as it empties. Addresses and lengths are filled in for each burst by _burst.
+static void _dmaInit(void)
+{
+    DMA_initParam rx_settings =
+    {
+     .channelSelect = AT86_SPI_DMA_RX_CHANNEL,
+     .transferModeSelect = DMA_TRANSFER_SINGLE,
+     .transferSize = 0,
+     .triggerSourceSelect = AT86_SPI_DMA_RX_TRIGGER,
+     .transferUnitSelect = DMA_SIZE_SRCBYTE_DSTBYTE,
+     .triggerTypeSelect = DMA_TRIGGER_RISINGEDGE
+    };
+    DMA_init(&rx_settings);
+    DMA_setSrcAddress(AT86_SPI_DMA_RX_CHANNEL, USCI_B_SPI_getReceiveBufferAddressForDMA(AT86_SPI_BASE), DMA_DIRECTION_UNCHANGED);
+    DMA_enableInterrupt(AT86_SPI_DMA_RX_CHANNEL); // The last received byte marks the end of a burst.
+
+    DMA_initParam tx_settings =
+    {
+     .channelSelect = AT86_SPI_DMA_TX_CHANNEL,
+     .transferModeSelect = DMA_TRANSFER_SINGLE,
+     .transferSize = 0,
+     .triggerSourceSelect = AT86_SPI_DMA_TX_TRIGGER,
+     .transferUnitSelect = DMA_SIZE_SRCBYTE_DSTBYTE,
+     .triggerTypeSelect = DMA_TRIGGER_RISINGEDGE
+    };
+    DMA_init(&tx_settings);
+    DMA_setDstAddress(AT86_SPI_DMA_TX_CHANNEL, USCI_B_SPI_getTransmitBufferAddressForDMA(AT86_SPI_BASE), DMA_DIRECTION_UNCHANGED);
+}
+
+// This function exchanges a block of bytes with the AT86RF233 using DMA. The CPU sleeps in LPM0 with interrupts enabled while the block is
+// transferred, so UART and timer interrupts are still serviced. Interrupt handlers must not start SPI transactions of their own: the
+// AT86RF233 IRQ pin interrupt, which AT86_init leaves enabled and whose handler reads IRQ_STATUS, is held off for the duration of the burst
+// and taken afterwards. Must be called with SS low and interrupts disabled, and not from an interrupt handler; returns with interrupts
+// disabled.
+//  src: bytes to transmit, or NULL to transmit zeros.
+//  dest: where to store the bytes received, or NULL to discard them.
+//  len: number of bytes to exchange (at least 1).
+static void _burst(const uint8_t * src, uint8_t * dest, uint8_t len)
+{
+    burst_dummy = 0x00;
+    if(dest != NULL) // Receive channel: RXBUF to memory, one byte per received byte
+        DMA_setDstAddress(AT86_SPI_DMA_RX_CHANNEL, (uintptr_t) dest, DMA_DIRECTION_INCREMENT);
+    else
+        DMA_setDstAddress(AT86_SPI_DMA_RX_CHANNEL, (uintptr_t) &burst_dummy, DMA_DIRECTION_UNCHANGED);
+    DMA_setTransferSize(AT86_SPI_DMA_RX_CHANNEL, len);
+    DMA_enableTransfers(AT86_SPI_DMA_RX_CHANNEL);
+    if(len > 1) // Transmit channel: memory to TXBUF. TXIFG is already high, so the first byte has to be written by the CPU to produce an edge.
+    {
+        if(src != NULL)
+            DMA_setSrcAddress(AT86_SPI_DMA_TX_CHANNEL, (uintptr_t) (src+1), DMA_DIRECTION_INCREMENT);
+        else
+            DMA_setSrcAddress(AT86_SPI_DMA_TX_CHANNEL, (uintptr_t) &burst_dummy, DMA_DIRECTION_UNCHANGED);
+        DMA_setTransferSize(AT86_SPI_DMA_TX_CHANNEL, len-1);
+        DMA_enableTransfers(AT86_SPI_DMA_TX_CHANNEL);
+    }
+    burst_done = false;
+    GPIO_disableInterrupt(AT86_IRQ_PORT, AT86_IRQ_PIN); // An IRQ edge during the burst stays flagged until it is over.
+    USCI_B_SPI_transmitData(AT86_SPI_BASE, (src != NULL) ? src[0] : 0x00); // Start the burst.
+    while(!burst_done)
+    {
+        __bis_SR_register(LPM0_bits + GIE); // Sleep until the DMA interrupt wakes us up; other interrupts may run meanwhile.
+        __disable_interrupt();
+    }
+    GPIO_enableInterrupt(AT86_IRQ_PORT, AT86_IRQ_PIN); // A flagged IRQ edge is taken once the caller lets interrupts happen again.
 }
+#endif
 
-// This function transmits a byte to the AT86RF233 over SPI.
-//  value: byte to be transmitted.
-static void _tx(uint8_t value)
+// This function lends the SPI bus, and the DMA channels used for bursts, to another module that drives them without the CPU (see phase.c).
+// The next access through the functions in this file first calls reclaim, which must stop all traffic and leave SS high, and then sets the
+// DMA channels up again. Must be called with interrupts disabled.
+//  reclaim: function that takes the bus back.
+void    REG_lendBus(void (*reclaim)(void))
 {
-    while(!USCI_B_SPI_getInterruptStatus(AT86_SPI_BASE, USCI_B_SPI_TRANSMIT_INTERRUPT)); // Wait until the SPI module is not transmitting.
-    USCI_B_SPI_transmitData(AT86_SPI_BASE, value); // Transmit a byte over SPI.
-    while(!USCI_B_SPI_getInterruptStatus(AT86_SPI_BASE, USCI_B_SPI_RECEIVE_INTERRUPT)); // Ensure we get a byte in return.
-    USCI_B_SPI_receiveData(AT86_SPI_BASE); // Retrieve but do not record the byte, as it does not contain useful data.
+    bus_reclaim = reclaim;
 }
 
-// This function receives a byte from the AT86RF233 over SPI, and returns the byte.
-static uint8_t _rx(void)
+// This function takes the SPI bus back after it has been lent out. Must be called with interrupts disabled.
+static void _reclaimBus(void)
 {
-    while(!USCI_B_SPI_getInterruptStatus(AT86_SPI_BASE, USCI_B_SPI_TRANSMIT_INTERRUPT)); // Wait until the SPI module is not transmitting.
-    USCI_B_SPI_transmitData(AT86_SPI_BASE, 0x00); // Transmit a byte (doesn't matter what the byte is).
-    while(!USCI_B_SPI_getInterruptStatus(AT86_SPI_BASE, USCI_B_SPI_RECEIVE_INTERRUPT)); // Ensure we receive a byte in return.
-    return USCI_B_SPI_receiveData(AT86_SPI_BASE); // Retrieve and return the byte we get.
+    void (*reclaim)(void) = bus_reclaim;
+    bus_reclaim = NULL;
+    reclaim(); // Stop the borrower.
+#if AT86_SPI_DMA
+    _dmaInit(); // It may have reconfigured the DMA channels.
+#endif
 }
 
-// This function sets the value of an AT86RF233 register, as described in the datasheet.
+// This function sets the value of an AT86RF233 register, as described in the datasheet. The shadow copy of configuration registers is updated
+// as well, so read-only registers (PART_NUM, VERSION_NUM, MAN_ID_x) must not be written. Like REG_read and REG_status, it leaves the interrupt
+// state as it found it, so it may be called from interrupt handlers.
 //  address: Address of the register we want to write.
 //  value: Value to set the register to.
 void    REG_write(uint8_t address, uint8_t value)
 {
-    __disable_interrupt(); // An interrupt here could cause us to try to read the status register in the middle of another read operation -- problematic.
+    const uint8_t cmd[2] = {address|0xC0, value}; // Address with 2 MSBs active to denote we want to write to this register, then the value to set the register to.
+    uint8_t bit = 1U<<(address&0x07); // Position of this register in the shadow bitmaps
+    uint8_t byte = (address&0x3F)>>3;
+    uint16_t gie = __get_interrupt_state(); // Interrupt state to return to.
+    __disable_interrupt(); // Make sure we don't have other SPI operations until this operation finishes.
+    if(bus_reclaim != NULL) // Take the bus back if it has been lent out.
+        _reclaimBus();
     GPIO_setOutputLowOnPin(AT86_SS_PORT, AT86_SS_PIN); // Activate slave select pin
-    _tx(address|0xC0); // Transmit address with 2 MSBs active to denote we want to write to this register
-    _tx(value); // Transmit the value to set the register to.
+    phy_status = _stream(cmd, 2, NULL, NULL, 0); // Transmit the address and value.
     GPIO_setOutputHighOnPin(AT86_SS_PORT, AT86_SS_PIN); // Unselect the AT86RF233 as an SPI slave.
-    __enable_interrupt(); // Turn interrupts back on.
+    if(shadow_cacheable[byte] & bit) // Keep the shadow copy in step with the register.
+    {
+        shadow[address&0x3F] = (address == REG__PHY_CC_CCA) ? (value & ~MASK__PHY_CC_CCA__CCA_REQUEST) : value; // CCA_REQUEST always reads back as 0
+        shadow_valid[byte] |= bit;
+    }
+    __set_interrupt_state(gie); // Interrupts can happen again, if they could before.
+}
+
+// This function forgets the shadow copies of the AT86RF233 configuration registers, so that the next read of each goes over SPI, as well as the
+// last PHY_STATUS byte. It must be called whenever the registers may have changed behind our back: after power-up, reset and sleep.
+void    REG_invalidate(void)
+{
+    uint8_t idx;
+    for(idx=0; idx<sizeof(shadow_valid); ++idx)
+        shadow_valid[idx] = 0;
+    phy_status = 0x00;
 }
 
-// This funciton reads the value of an AT86RF233 register, as described in the datasheet.
+// This funciton reads the value of an AT86RF233 register, as described in the datasheet. Configuration registers are only read over SPI the
+// first time after a reset or sleep; later reads return the shadow copy kept by REG_read and REG_write.
 //  address: Address of the register we want to read.
 uint8_t REG_read(uint8_t address)
 {
+    uint8_t bit = 1U<<(address&0x07); // Position of this register in the shadow bitmaps
+    uint8_t byte = (address&0x3F)>>3;
+    if(shadow_valid[byte] & bit) // We already know the value.
+        return shadow[address&0x3F];
+    const uint8_t cmd = address|0x80; // Address with MSB high to denote we want to read the register.
+    uint8_t rv;
+    uint16_t gie = __get_interrupt_state(); // Interrupt state to return to.
     __disable_interrupt(); // Make sure we don't have other SPI operations until this operation finishes.
+    if(bus_reclaim != NULL) // Take the bus back if it has been lent out.
+        _reclaimBus();
     GPIO_setOutputLowOnPin(AT86_SS_PORT, AT86_SS_PIN); // Select the AT86RF233 as SPI slave.
-    _tx(address|0x80); // Transmit address with MSB high to denote we want to read the register.
-    uint8_t rv = _rx(); // Receive the register value sent by the AT86RF233.
+    phy_status = _stream(&cmd, 1, NULL, &rv, 1); // Transmit the address and receive the register value sent by the AT86RF233.
     GPIO_setOutputHighOnPin(AT86_SS_PORT, AT86_SS_PIN); // Unselect the AT86RF233 as SPI slave.
-    __enable_interrupt(); // Interrupts can happen again.
+    if(shadow_cacheable[byte] & bit) // Remember the value of configuration registers.
+    {
+        shadow[address&0x3F] = rv;
+        shadow_valid[byte] |= bit;
+    }
+    __set_interrupt_state(gie); // Interrupts can happen again, if they could before.
     return rv; // Return register value.
 }
 
+// This function fetches a fresh PHY_STATUS byte from the AT86RF233 with a transaction that is ended after its first byte. The first byte is the
+// command of a TRX_STATUS read, so the aborted access has no side effects. This costs half as much bus time as a full register read.
+uint8_t REG_status(void)
+{
+    const uint8_t cmd = REG__TRX_STATUS|0x80; // Read command, dropped once the status byte has been clocked in.
+    uint16_t gie = __get_interrupt_state(); // Interrupt state to return to.
+    __disable_interrupt(); // Make sure we don't have other SPI operations until this operation finishes.
+    if(bus_reclaim != NULL) // Take the bus back if it has been lent out.
+        _reclaimBus();
+    GPIO_setOutputLowOnPin(AT86_SS_PORT, AT86_SS_PIN); // Select the AT86RF233 as SPI slave.
+    phy_status = _stream(&cmd, 1, NULL, NULL, 0); // Transmit the command byte and keep the status byte sent back during it.
+    GPIO_setOutputHighOnPin(AT86_SS_PORT, AT86_SS_PIN); // Unselect the AT86RF233 as SPI slave, ending the access.
+    __set_interrupt_state(gie); // Interrupts can happen again, if they could before.
+    return phy_status;
+}
+
+// This function returns the PHY_STATUS byte the AT86RF233 sent at the start of the latest SPI transaction, without any SPI traffic. What it
+// contains is selected by TRX_CTRL_1.SPI_CMD_MODE; it is 0 until the first transaction after REG_invalidate. Register reads served from the
+// shadow copy do not refresh it.
+uint8_t REG_lastStatus(void)
+{
+    return phy_status;
+}
+
 // This function reads a subset of the AT86RF233 TRX buffer.
 //  offset: byte number at which we want to start reading.
 //  dest: address in MSP430 memory at which to store the bytes we read.
 //  len: number of bytes to read.
 void    SRAM_read(uint8_t offset, uint8_t * dest, uint8_t len)
 {
+    const uint8_t cmd[2] = {0x00, offset}; // 0 to indicate we want to do an SRAM read, then the offset value.
+    uint16_t gie = __get_interrupt_state(); // Interrupt state to return to.
     __disable_interrupt(); // Make sure we don't have other SPI operations until this operation finishes.
+    if(bus_reclaim != NULL) // Take the bus back if it has been lent out.
+        _reclaimBus();
     GPIO_setOutputLowOnPin(AT86_SS_PORT, AT86_SS_PIN); // Select the AT86RF233 as SPI slave.
-    _tx(0x00); // Transmit 0 to indicate we want to do an SRAM read.
-    _tx(offset); // Transmit the offset value.
-    uint8_t idx; // Receive the desired number of bytes.
-    for(idx=0; idx<len; ++idx)
-        dest[idx] = _rx();
+#if AT86_SPI_DMA
+    if(len >= AT86_SPI_DMA_MIN_LEN) // Receive the desired number of bytes using DMA.
+    {
+        phy_status = _stream(cmd, 2, NULL, NULL, 0);
+        _burst(NULL, dest, len);
+    }
+    else
+#endif
+        phy_status = _stream(cmd, 2, NULL, dest, len); // Transmit the command and receive the desired number of bytes.
     GPIO_setOutputHighOnPin(AT86_SS_PORT, AT86_SS_PIN); // Unselect the AT86RF233 as SPI slave.
-    __enable_interrupt();  // Interrupts can happen again.
+    __set_interrupt_state(gie); // Interrupts can happen again, if they could before.
 }
 
 // This function writes data to a subset of the AT86RF233 TRX buffer.
@@ -103,15 +318,23 @@ void    SRAM_read(uint8_t offset, uint8_t * dest, uint8_t len)
 //  len: number of bytes we want to write.
 void    SRAM_write(uint8_t offset, const uint8_t * src, uint8_t len)
 {
+    const uint8_t cmd[2] = {0x40, offset}; // Indicate that we want to do an SRAM write, then the offset.
+    uint16_t gie = __get_interrupt_state(); // Interrupt state to return to.
     __disable_interrupt(); // Make sure we don't have other SPI operations until this operation finishes.
+    if(bus_reclaim != NULL) // Take the bus back if it has been lent out.
+        _reclaimBus();
     GPIO_setOutputLowOnPin(AT86_SS_PORT, AT86_SS_PIN); // Select the AT86RF233 as SPI slave.
-    _tx(0x40); // Inticate that we want to do an SRAM write.
-    _tx(offset); // Transmit the offset.
-    uint8_t idx; // Transmit the desired number of bytes.
-    for(idx=0; idx<len; ++idx)
-        _tx(src[idx]);
+#if AT86_SPI_DMA
+    if(len >= AT86_SPI_DMA_MIN_LEN) // Transmit the desired number of bytes using DMA.
+    {
+        phy_status = _stream(cmd, 2, NULL, NULL, 0);
+        _burst(src, NULL, len);
+    }
+    else
+#endif
+        phy_status = _stream(cmd, 2, src, NULL, len); // Transmit the command and the desired number of bytes.
     GPIO_setOutputHighOnPin(AT86_SS_PORT, AT86_SS_PIN); // Unselect the AT86RF233 as SPI slave.
-    __enable_interrupt(); // Interrupts can happen again.
+    __set_interrupt_state(gie); // Interrupts can happen again, if they could before.
 }
 
 // This function reads from the beginning of the AT86RF233 TRX buffer, as described in the datasheet. It is redundant with the SRAM_read functionality, but is a separate functionality implemented in the AT86RF233.
@@ -119,12 +342,37 @@ void    SRAM_write(uint8_t offset, const uint8_t * src, uint8_t len)
 //  len: number of bytes we want to retrieve.
 void    FB_read(uint8_t * dest, uint8_t len)
 {
+    const uint8_t cmd = 0x20; // Indicate that we want to do an FB_read operation.
+    uint16_t gie = __get_interrupt_state(); // Interrupt state to return to.
     __disable_interrupt(); // Make sure we don't have other SPI operations until this operation finishes.
+    if(bus_reclaim != NULL) // Take the bus back if it has been lent out.
+        _reclaimBus();
     GPIO_setOutputLowOnPin(AT86_SS_PORT, AT86_SS_PIN); // Select the AT86RF233 as SPI slave.
-    _tx(0x20); // Indicate that we want to do an FB_read operation.
-    uint8_t idx; // Read the desired number of bytes.
-    for(idx=0; idx<len; ++idx)
-        dest[idx] = _rx();
+#if AT86_SPI_DMA
+    if(len >= AT86_SPI_DMA_MIN_LEN) // Read the desired number of bytes using DMA.
+    {
+        phy_status = _stream(&cmd, 1, NULL, NULL, 0);
+        _burst(NULL, dest, len);
+    }
+    else
+#endif
+        phy_status = _stream(&cmd, 1, NULL, dest, len); // Transmit the command and read the desired number of bytes.
     GPIO_setOutputHighOnPin(AT86_SS_PORT, AT86_SS_PIN); // Unselect the AT86RF233 as SPI slave.
-    __enable_interrupt(); // Interrupts can happen again.
+    __set_interrupt_state(gie); // Interrupts can happen again, if they could before.
+}
+
+#if AT86_SPI_DMA
+// This function is called from the DMA interrupt handler (DMA_VECTOR, which other modules share) to see whether the receive DMA channel has
+// stored the last byte of a burst.
+// Returns true if the CPU should be woken up on exit from the interrupt, for _burst to return.
+bool    REG_serviceDma(void)
+{
+    if(DMA_getInterruptStatus(AT86_SPI_DMA_RX_CHANNEL) == DMA_INT_ACTIVE)
+    {
+        DMA_clearInterrupt(AT86_SPI_DMA_RX_CHANNEL); // Clear this interrupt
+        burst_done = true; // Indicate that the burst is complete
+        return true; // Wake up _burst
+    }
+    return false;
 }
+#endif
@@ -0,0 +1,118 @@
+/*
+ * fit.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// This file fits a straight line to the phase measurements taken during a reception, so that the computer can be sent the slope, intercept
+// and coefficient of determination instead of every measurement. Measurements are unwrapped and added to running sums one at a time, so the
+// memory needed does not depend on how many there are, and the line can be computed at any point. Everything is done in fixed point: the
+// products that go into the sums and the final computation are taken with the MPY32 hardware multiplier, 32 x 32 bits into 64.
+// With x the time of a measurement in timer ticks, y its unwrapped phase in steps of 2*pi/256 rad and n the number of measurements:
+//  slope = (n*Sxy - Sx*Sy)/(n*Sxx - Sx*Sx), intercept = (Sy - slope*Sx)/n, r2 = (n*Sxy - Sx*Sy)^2/((n*Sxx - Sx*Sx)*(n*Syy - Sy*Sy)).
+
+#include "fit.h" // Declarations of functions/macros in this file
+#include "hal.h" // Definitions of pins, peripheral initialization details, etc.
+#include "mpy32.h" // TI-provided file to control MSP430 hardware multiplier
+
+#define FIT_URAD_PER_STEP (24544L) // Phase step of PHY_PMU_VALUE, 2*pi/256 rad, in urad
+#define FIT_FRACTION_BITS (24U) // Fractional bits of the slope while the line is computed
+#define FIT_PPM           (1000000UL) // Parts per million in a whole
+#define FIT_PPM_DIRECT    (1ULL << 40) // Products below which r2 can be scaled up before dividing without overflowing
+
+static uint16_t count = 0; // Number of phase measurements added
+static uint8_t last_phase = 0; // Last phase measurement added, before unwrapping
+static int32_t unwrapped = 0; // Last phase measurement added, after unwrapping (phase steps)
+static uint32_t sum_x = 0; // Sum of the times of the measurements (timer ticks)
+static int32_t sum_y = 0; // Sum of the unwrapped measurements (phase steps)
+static int64_t sum_xx = 0; // Sum of the squares of the times
+static int64_t sum_xy = 0; // Sum of the products of times and unwrapped measurements
+static int64_t sum_yy = 0; // Sum of the squares of the unwrapped measurements
+
+// This function multiplies two signed 32-bit numbers with the hardware multiplier. Must be called with interrupts disabled.
+//  a, b: numbers to multiply.
+//  returns: their product.
+static int64_t _multiply(int32_t a, int32_t b)
+{
+    MPY32_setOperandOne32Bit(MPY32_MULTIPLY_SIGNED, a);
+    MPY32_setOperandTwo32Bit(b); // Writing the second operand starts the multiplication.
+    return (int64_t) MPY32_getResult();
+}
+
+// This function forgets the phase measurements added so far, so that a new line can be fitted.
+void FIT_reset(void)
+{
+    count = 0;
+    sum_x = 0;
+    sum_y = 0;
+    sum_xx = 0;
+    sum_xy = 0;
+    sum_yy = 0;
+}
+
+// This function unwraps a phase measurement and adds it to the running sums. Measurements must be added in the order they were taken, and
+// consecutive ones must be less than half a turn apart, i.e. taken at least twice per period of the phase.
+//  phase: value of PHY_PMU_VALUE.
+//  time: time at which it was read (timer ticks).
+void FIT_add(uint8_t phase, uint16_t time)
+{
+    if(count >= FIT_MAX_SAMPLES) // Sums could overflow beyond this.
+        return;
+    if(count == 0)
+        unwrapped = phase; // The first measurement is taken as it is.
+    else
+        unwrapped += (int8_t) (phase - last_phase); // Steps of more than half a turn are taken to be the phase wrapping around.
+    last_phase = phase;
+    uint16_t gie = __get_interrupt_state(); // Interrupt state to return to.
+    __disable_interrupt(); // The multiplier keeps its operands and result between accesses, so nothing else may use it meanwhile.
+    MPY32_setOperandOne32Bit(MPY32_MULTIPLY_SIGNED, time); // The time stays loaded for both products it is part of.
+    MPY32_setOperandTwo32Bit(time);
+    sum_xx += (int64_t) MPY32_getResult();
+    MPY32_setOperandTwo32Bit(unwrapped);
+    sum_xy += (int64_t) MPY32_getResult();
+    sum_yy += _multiply(unwrapped, unwrapped);
+    __set_interrupt_state(gie); // Interrupts can happen again, if they could before.
+    sum_x += time;
+    sum_y += unwrapped;
+    ++count;
+}
+
+// This function computes the line that best fits the phase measurements added so far, in the least-squares sense. The slope, intercept and
+// coefficient of determination are all zero if there are fewer than two measurements or they were all taken at the same time.
+//  line: where to store the line.
+void FIT_get(FIT_Line * line)
+{
+    line->count = count;
+    line->slope = 0;
+    line->intercept = 0;
+    line->r2 = 0;
+    if(count < 2)
+        return;
+    uint16_t gie = __get_interrupt_state(); // Interrupt state to return to.
+    __disable_interrupt(); // Nothing else may use the multiplier meanwhile.
+    int64_t dxx = count*sum_xx - _multiply(sum_x, sum_x); // n^2 times the variance of the times
+    int64_t dxy = count*sum_xy - _multiply(sum_x, sum_y); // n^2 times the covariance
+    int64_t dyy = count*sum_yy - _multiply(sum_y, sum_y); // n^2 times the variance of the unwrapped measurements
+    __set_interrupt_state(gie);
+    while((dxx > INT32_MAX) || (dyy > INT32_MAX) || (dxy > INT32_MAX) || (dxy < -INT32_MAX)) // Scaling all three alike changes neither the
+    {                                                                                        // slope nor r2, and keeps products within 64 bits.
+        dxx /= 2;
+        dxy /= 2;
+        dyy /= 2;
+    }
+    if(dxx <= 0)
+        return;
+    int64_t slope = (dxy*((int64_t) 1 << FIT_FRACTION_BITS))/dxx; // Phase steps per timer tick, fixed point
+    int64_t intercept = ((int64_t) sum_y*((int64_t) 1 << FIT_FRACTION_BITS) - slope*sum_x)/count; // Phase steps, fixed point
+    line->slope = (slope*FIT_URAD_PER_STEP*(int64_t) (PHASE_TIMER_FREQ/1000000UL))/((int64_t) 1 << FIT_FRACTION_BITS); // urad/us is rad/s
+    line->intercept = ((intercept*FIT_URAD_PER_STEP)/1000)/((int64_t) 1 << FIT_FRACTION_BITS);
+    gie = __get_interrupt_state();
+    __disable_interrupt();
+    uint64_t explained = (uint64_t) _multiply(dxy, dxy);
+    uint64_t total = (uint64_t) _multiply(dxx, dyy);
+    __set_interrupt_state(gie);
+    if(total == 0) // The phase did not change: no part of its variation to explain.
+        return;
+    uint64_t r2 = (total < FIT_PPM_DIRECT) ? (explained*FIT_PPM)/total : explained/(total/FIT_PPM);
+    line->r2 = (r2 > FIT_PPM) ? FIT_PPM : r2; // Rounding can take it just past 1.
+}
@@ -0,0 +1,28 @@
+/*
+ * fit.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// File with function declarations for fit.c. Specific details in this file.
+
+#ifndef FIT_H_
+#define FIT_H_
+
+#include <stdint.h> // Specific definitions of integers
+
+#define FIT_MAX_SAMPLES (1024U) // Most phase measurements a line can be fitted to; further ones are ignored. Keeps every sum within 64 bits.
+
+typedef struct // Straight line fitted to unwrapped phase measurements
+{
+    uint16_t count; // Number of phase measurements fitted
+    int32_t  slope; // Rate of change of phase (rad/s)
+    int32_t  intercept; // Phase at time 0 (mrad), between 0 and 2*pi for the first measurement before unwrapping
+    uint32_t r2; // Coefficient of determination (parts per million)
+} FIT_Line;
+
+void FIT_reset(void); // Forget the phase measurements fitted so far.
+void FIT_add(uint8_t phase, uint16_t time); // Unwrap a phase measurement and add it to the fit.
+void FIT_get(FIT_Line * line); // Compute the line that best fits the phase measurements added so far.
+
+#endif /* FIT_H_ */
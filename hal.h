@@ -23,6 +23,28 @@
 #define MCU_BCUATX_PORT  (GPIO_PORT_P4) // UART TX pin we will be using on the MSP-EXP430F5529LP
 #define MCU_BCUATX_PIN   (GPIO_PIN4)
 #define MCU_BCUA_UCA     (USCI_A1_BASE) // Base address of the memory-mapped control registers for the UART we will be using
+#define VCOM_BAUD_DEFAULT (115200UL) // Baud rate of the VCOM UART after reset, and after a failed change of rate
+#define VCOM_BAUD_MIN_DIVIDER (3U) // Fewest SMCLK cycles per bit the UART can be set up with (20 MHz / 3 = 6.67 Mbaud)
+#define VCOM_BAUD_CONFIRM_MS (250U) // How long (ms) the computer has to confirm a new baud rate before we go back to VCOM_BAUD_DEFAULT
+#define VCOM_RX_SLOTS (4U) // Frames from the computer (a power of two) that can wait to be read, so that commands sent while one is carried out are not lost
+#define VCOM_RX_SLOT_LEN (32U) // Longest frame (bytes, with its delimiter) that can be received; the largest command frame (SWEEP) takes 21
+#define VCOM_TX_BUFFER_LEN (1024U) // Size (bytes, a power of two) of the VCOM transmit ring buffer. Holds every frame about a reception.
+#define VCOM_TX_MAX_SPAN (256U) // Most bytes handed to the DMA channel or USB module at once. Room in the ring buffer is only freed at the end of a span.
+#ifndef VCOM_USB
+#define VCOM_USB         (0) // Set to 1 to talk to the computer as a CDC-ACM device through the MSP430 USB module, or 0 through the UART bridge of the debug probe
+#endif
+#define VCOM_USB_INTF    (CDC0_INTFNUM) // CDC interface, from USB_config/descriptors.h. The stack must be configured with USB_DMA_CHAN 0xFF (no DMA):
+                                        // all three channels are in use during DMA phase measurements.
+#define VCOM_USB_PACKET_LEN (64U) // Size (bytes) of a full-speed bulk packet
+#ifndef VCOM_DMA
+#define VCOM_DMA         (!VCOM_USB) // Set to 1 to have a DMA channel feed the VCOM UART a span of the ring buffer at a time, or 0 to feed it a byte per interrupt
+#endif
+#if VCOM_DMA && VCOM_USB
+#error "VCOM_DMA only applies to the UART"
+#endif
+#define VCOM_DMA_CHANNEL (DMA_CHANNEL_2) // DMA channel that feeds the UART transmit buffer. Lent to phase.c while it takes DMA phase measurements.
+#define VCOM_DMA_TRIGGER (DMA_TRIGGERSOURCE_21) // UCA1TXIFG
+#define PROTO_CRC_BASE   (CRC_BASE) // Base address of the CRC module that checks the frames exchanged with the computer
 
 #define AT86_DIG1_PORT   (GPIO_PORT_P1) // MSP-EXP430F5529LP GPIO pin we will attach to DIG1 pin of the AT86RF233
 #define AT86_DIG1_PIN    (GPIO_PIN2)
@@ -38,8 +60,17 @@
 #define AT86_WAKEUP_PIN  (GPIO_PIN5)
 #define AT86_SPI_BASE    (USCI_B0_BASE) // Base address of the memory-mapped control registers of the MSP430F5529LP SPI module we will be using
 #define AT86_SPI_FREQ    (6500000U) // Frequency (Hz) at which we will run the SPI module
+#ifndef AT86_SPI_DMA
+#define AT86_SPI_DMA     (1) // Set to 1 to move long SRAM/frame buffer transfers with the DMA controller, or 0 to move every byte with the CPU
+#endif
+#define AT86_SPI_DMA_MIN_LEN    (16U) // Shortest data phase (bytes) handed to the DMA controller. The CPU streams shorter ones at the same bus rate with less setup.
+#define AT86_SPI_DMA_RX_CHANNEL (DMA_CHANNEL_0) // DMA channel that empties the SPI receive buffer. It must have a higher priority (lower number) than the TX channel.
+#define AT86_SPI_DMA_RX_TRIGGER (DMA_TRIGGERSOURCE_18) // UCB0RXIFG
+#define AT86_SPI_DMA_TX_CHANNEL (DMA_CHANNEL_1) // DMA channel that feeds the SPI transmit buffer
+#define AT86_SPI_DMA_TX_TRIGGER (DMA_TRIGGERSOURCE_19) // UCB0TXIFG
 #define AT86_SS_PORT     (GPIO_PORT_P2) // MSP-EXP430F5529LP GPIO pin we will attach to the SS pin of the AT86RF233
 #define AT86_SS_PIN      (GPIO_PIN3)
+#define AT86_SS_OUT_ADDR (__MSP430_BASEADDRESS_PORT2_R__ + OFS_P2OUT) // Output register of that port, which the DMA controller writes during phase measurements
 #define AT86_MOSI_PORT   (GPIO_PORT_P3) // MSP-EXP430F5529LP MOSI pin we will attach to the MOSI pin of the AT86RF233
 #define AT86_MOSI_PIN    (GPIO_PIN0)
 #define AT86_MISO_PORT   (GPIO_PORT_P3) // MSP-EXP430F5529LP MISO pin we will attach to the MISO pin of the AT86RF233
@@ -48,6 +79,44 @@
 #define AT86_SCK_PIN     (GPIO_PIN2)
 #define AT86_PWR_PORT    (GPIO_PORT_P2) // MSP-EXP430F5529LP GPIO pin we will use to toggle power to the AT86RF233
 #define AT86_PWR_PIN     (GPIO_PIN6)
+#define AT86_TIMER_BASE        (TS_TIMER_BASE) // Timer whose count the driver times radio events with: the low 16 bits of TS_now timestamps
+#define AT86_TIMER_DIVIDER     (TS_TIMER_DIVIDER) // Divider applied to SMCLK (20 MHz) to clock it
+#define AT86_DIG2_TIMER_REG    (TIMER_A_CAPTURECOMPARE_REGISTER_3) // P1.4 (DIG2) is also TA0.3 (CCI3A): the register that captures the frame timestamp DIG2 gives at RX_START
+#define AT86_WAKEUP_TIMER_BASE (TIMER_A2_BASE) // P2.5 (WAKEUP, i.e. SLP_TR) is also TA2.2: the timer whose compare output raises it to start a scheduled transmission.
+                                               // Shared with PHASE_TX_TIMER_BASE, which only runs during receptions.
+#define AT86_WAKEUP_TIMER_REG  (TIMER_A_CAPTURECOMPARE_REGISTER_2) // Compare register driving that output
+#define AT86_TX_AT_MIN_LEAD    (50U) // Fewest AT86_TIMER_BASE ticks (10 us) ahead that a scheduled transmission can be set up in time; closer ones start at once
+#define AT86_PLL_LOCK_TIMEOUT  (1000U) // Most AT86_TIMER_BASE ticks (200 us) a hop waits for PLL_LOCK, or a PLL calibration for its end: twice the longest the PLL takes to settle (tTR4, 110 us)
+
+#define TS_TIMER_BASE    (TIMER_A0_BASE) // Timer that runs continuously from SMCLK as the time base of timestamps; its overflow interrupt extends the count
+#define TS_TIMER_DIVIDER (TIMER_A_CLOCKSOURCE_DIVIDER_4) // Divider applied to SMCLK (20 MHz) to clock it
+#define TS_FREQ          (5000000UL) // Resulting frequency (Hz): timestamps are in 200 ns ticks, and 32-bit ones wrap around after 859 s
+
+#ifndef PHASE_DMA
+#define PHASE_DMA        (1) // Set to 1 to take phase measurements with timers and the DMA controller, or 0 to take them from a timer interrupt
+#endif
+#define PHASE_TIMER_BASE     (TS_TIMER_BASE) // Base address of the timer that paces phase measurements when PHASE_DMA is 0; its CCR0 interrupt takes each one
+#define PHASE_TIMER_DIVIDER  (TS_TIMER_DIVIDER) // Divider applied to SMCLK (20 MHz) to clock the phase measurement timers, which tick with the timestamps
+#define PHASE_TIMER_FREQ     (TS_FREQ) // Resulting frequency (Hz) of those timers: the unit of phase measurement periods and timestamps
+#if PHASE_DMA
+#define PHASE_PERIOD_DEFAULT (40U) // Default time (timer ticks) between phase measurements: 8 us, every PHY_PMU_VALUE update
+#define PHASE_PERIOD_MIN     (32U) // Shortest time (timer ticks) between phase measurements: a 2-byte register read and the SS edges around it take about 5 us
+#define PHASE_PERIOD_HDR     (40U) // Time (timer ticks) between phase measurements at the data rates above 250 kb/s, whose shorter frames carry fewer
+                                   // PHY_PMU_VALUE updates: 8 us, every update
+#else
+#define PHASE_PERIOD_DEFAULT (80U) // Default time (timer ticks) between phase measurements: 16 us, every other PHY_PMU_VALUE update
+#define PHASE_PERIOD_MIN     (60U) // Shortest time (timer ticks) between phase measurements: entering and running the interrupt handler takes about 11 us
+#define PHASE_PERIOD_HDR     (60U) // Time (timer ticks) between phase measurements at the data rates above 250 kb/s, whose shorter frames carry fewer
+                                   // PHY_PMU_VALUE updates: 12 us, as often as the interrupt handler allows
+#endif
+#define PHASE_SS_TIMER_BASE  (TIMER_A1_BASE) // Timer (up/down mode) whose CCR2 matches select and unselect the AT86RF233 around each DMA phase measurement
+#define PHASE_SS_DMA_CHANNEL (VCOM_DMA_CHANNEL) // DMA channel that writes the SS port on those matches. There are only three, so VCOM lends us its own.
+#define PHASE_SS_DMA_TRIGGER (DMA_TRIGGERSOURCE_4) // TA1CCR2 CCIFG
+#define PHASE_TX_TIMER_BASE  (TIMER_A2_BASE) // Timer (up/down mode) whose CCR2 matches write the command and filler byte of each DMA phase measurement
+#define PHASE_TX_DMA_CHANNEL (AT86_SPI_DMA_TX_CHANNEL) // DMA channel that writes the SPI transmit buffer on those matches
+#define PHASE_TX_DMA_TRIGGER (DMA_TRIGGERSOURCE_6) // TA2CCR2 CCIFG
+#define PHASE_RX_DMA_CHANNEL (AT86_SPI_DMA_RX_CHANNEL) // DMA channel that stores the bytes received during DMA phase measurements
+#define PHASE_RX_DMA_TRIGGER (AT86_SPI_DMA_RX_TRIGGER) // UCB0RXIFG
 
 
 #endif /* HAL_H_ */
@@ -0,0 +1,27 @@
+/*
+ * UsbCdc.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// Host stand-in for the CDC part of the TI MSP430 USB API, implemented by host/sim/usb_sim.c. The event handlers are defined by the firmware.
+
+#ifndef HOST_USBCDC_H_
+#define HOST_USBCDC_H_
+
+#include "msp430.h"
+
+#define kUSBCDC_sendStarted      (0x01)
+#define kUSBCDC_sendComplete     (0x02)
+#define kUSBCDC_intfBusyError    (0x03)
+#define kUSBCDC_generalError     (0x07)
+#define kUSBCDC_busNotAvailable  (0x08)
+
+uint8_t  USBCDC_sendData(const uint8_t * data, uint16_t size, uint8_t intfNum);
+uint16_t USBCDC_receiveDataInBuffer(uint8_t * data, uint16_t size, uint8_t intfNum);
+uint16_t USBCDC_getBytesInUSBBuffer(uint8_t intfNum);
+
+uint8_t  USBCDC_handleDataReceived(uint8_t intfNum); // Called from the USB interrupt when bytes arrive and no receive operation is open
+uint8_t  USBCDC_handleSendCompleted(uint8_t intfNum); // Called from the USB interrupt when a send operation has completed
+
+#endif /* HOST_USBCDC_H_ */
@@ -0,0 +1,23 @@
+/*
+ * usb.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// Host stand-in for the common part of the TI MSP430 USB API, implemented by host/sim/usb_sim.c.
+
+#ifndef HOST_USB_H_
+#define HOST_USB_H_
+
+#include "msp430.h"
+
+#define kUSB_succeed          (0x00)
+#define kUSB_generalError     (0x17)
+
+#define ST_USB_DISCONNECTED   (0x80)
+#define ST_ENUM_ACTIVE        (0x93)
+
+uint8_t USB_setup(uint8_t connectEnable, uint8_t eventsEnable);
+uint8_t USB_getConnectionState(void);
+
+#endif /* HOST_USB_H_ */
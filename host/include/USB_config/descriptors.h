@@ -0,0 +1,15 @@
+/*
+ * descriptors.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// Host stand-in for the USB_config/descriptors.h generated by the TI descriptor tool, for a device with a single CDC-ACM interface.
+
+#ifndef HOST_DESCRIPTORS_H_
+#define HOST_DESCRIPTORS_H_
+
+#define CDC_NUM_INTERFACES (1)
+#define CDC0_INTFNUM       (0)
+
+#endif /* HOST_DESCRIPTORS_H_ */
@@ -0,0 +1,18 @@
+/*
+ * crc.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// Host stand-in for the driverlib CRC module, implemented by host/sim/crc_sim.c.
+
+#ifndef HOST_CRC_H_
+#define HOST_CRC_H_
+
+#include "msp430.h"
+
+void     CRC_setSeed(uint16_t baseAddress, uint16_t seed);
+void     CRC_set8BitDataReversed(uint16_t baseAddress, uint8_t dataIn);
+uint16_t CRC_getResult(uint16_t baseAddress);
+
+#endif /* HOST_CRC_H_ */
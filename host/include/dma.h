@@ -0,0 +1,81 @@
+/*
+ * dma.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// Host stand-in for the driverlib DMA module, implemented by host/sim/dma_sim.c. Addresses below 0x10000 refer to the simulated memory map;
+// any other address is a pointer into host memory.
+
+#ifndef HOST_DMA_H_
+#define HOST_DMA_H_
+
+#include "msp430.h"
+
+typedef struct DMA_initParam {
+    uint8_t channelSelect;
+    uint16_t transferModeSelect;
+    uint16_t transferSize;
+    uint8_t triggerSourceSelect;
+    uint8_t transferUnitSelect;
+    uint8_t triggerTypeSelect;
+} DMA_initParam;
+
+#define DMA_TRIGGERSOURCE_0          (0x00)
+#define DMA_TRIGGERSOURCE_1          (0x01)
+#define DMA_TRIGGERSOURCE_2          (0x02)
+#define DMA_TRIGGERSOURCE_3          (0x03)
+#define DMA_TRIGGERSOURCE_4          (0x04)
+#define DMA_TRIGGERSOURCE_5          (0x05)
+#define DMA_TRIGGERSOURCE_6          (0x06)
+#define DMA_TRIGGERSOURCE_7          (0x07)
+#define DMA_TRIGGERSOURCE_8          (0x08)
+#define DMA_TRIGGERSOURCE_16         (0x10)
+#define DMA_TRIGGERSOURCE_17         (0x11)
+#define DMA_TRIGGERSOURCE_18         (0x12)
+#define DMA_TRIGGERSOURCE_19         (0x13)
+#define DMA_TRIGGERSOURCE_20         (0x14)
+#define DMA_TRIGGERSOURCE_21         (0x15)
+#define DMA_TRIGGERSOURCE_22         (0x16)
+#define DMA_TRIGGERSOURCE_23         (0x17)
+#define DMA_TRIGGERSOURCE_29         (0x1D)
+#define DMA_TRIGGERSOURCE_30         (0x1E)
+#define DMA_TRIGGERSOURCE_31         (0x1F)
+
+#define DMA_TRANSFER_SINGLE          (DMADT_0)
+#define DMA_TRANSFER_BLOCK           (DMADT_1)
+#define DMA_TRANSFER_REPEATED_SINGLE (DMADT_4)
+
+#define DMA_CHANNEL_0                (0x00)
+#define DMA_CHANNEL_1                (0x10)
+#define DMA_CHANNEL_2                (0x20)
+
+#define DMA_TRIGGER_RISINGEDGE       (!(DMALEVEL))
+#define DMA_TRIGGER_HIGH             (DMALEVEL)
+
+#define DMA_SIZE_SRCWORD_DSTWORD     (!(DMASRCBYTE + DMADSTBYTE))
+#define DMA_SIZE_SRCBYTE_DSTWORD     (DMASRCBYTE)
+#define DMA_SIZE_SRCWORD_DSTBYTE     (DMADSTBYTE)
+#define DMA_SIZE_SRCBYTE_DSTBYTE     (DMASRCBYTE + DMADSTBYTE)
+
+#define DMA_DIRECTION_UNCHANGED      (DMASRCINCR_0)
+#define DMA_DIRECTION_DECREMENT      (DMASRCINCR_2)
+#define DMA_DIRECTION_INCREMENT      (DMASRCINCR_3)
+
+#define DMA_INT_INACTIVE             (0x0)
+#define DMA_INT_ACTIVE               (DMAIFG)
+
+void     DMA_init(DMA_initParam *param);
+void     DMA_setTransferSize(uint8_t channelSelect, uint16_t transferSize);
+uint16_t DMA_getTransferSize(uint8_t channelSelect);
+void     DMA_setSrcAddress(uint8_t channelSelect, uintptr_t srcAddress, uint16_t directionSelect);
+void     DMA_setDstAddress(uint8_t channelSelect, uintptr_t dstAddress, uint16_t directionSelect);
+void     DMA_enableTransfers(uint8_t channelSelect);
+void     DMA_disableTransfers(uint8_t channelSelect);
+void     DMA_startTransfer(uint8_t channelSelect);
+void     DMA_enableInterrupt(uint8_t channelSelect);
+void     DMA_disableInterrupt(uint8_t channelSelect);
+uint16_t DMA_getInterruptStatus(uint8_t channelSelect);
+void     DMA_clearInterrupt(uint8_t channelSelect);
+
+#endif /* HOST_DMA_H_ */
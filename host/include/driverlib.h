@@ -0,0 +1,25 @@
+/*
+ * driverlib.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// Host stand-in for the driverlib umbrella header. Only the modules the firmware uses are simulated.
+
+#ifndef HOST_DRIVERLIB_H_
+#define HOST_DRIVERLIB_H_
+
+#include "msp430.h"
+#include "crc.h"
+#include "dma.h"
+#include "gpio.h"
+#include "mpy32.h"
+#include "pmm.h"
+#include "timer_a.h"
+#include "timer_b.h"
+#include "ucs.h"
+#include "usci_a_uart.h"
+#include "usci_b_spi.h"
+#include "wdt_a.h"
+
+#endif /* HOST_DRIVERLIB_H_ */
@@ -0,0 +1,56 @@
+/*
+ * gpio.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// Host stand-in for the driverlib GPIO module. Only the calls made by the firmware are declared; they are implemented by host/sim/gpio_sim.c.
+
+#ifndef HOST_GPIO_H_
+#define HOST_GPIO_H_
+
+#include "msp430.h"
+
+#define GPIO_PORT_P1                        1
+#define GPIO_PORT_P2                        2
+#define GPIO_PORT_P3                        3
+#define GPIO_PORT_P4                        4
+#define GPIO_PORT_P5                        5
+#define GPIO_PORT_P6                        6
+#define GPIO_PORT_P7                        7
+#define GPIO_PORT_P8                        8
+
+#define GPIO_PIN0                           (0x0001)
+#define GPIO_PIN1                           (0x0002)
+#define GPIO_PIN2                           (0x0004)
+#define GPIO_PIN3                           (0x0008)
+#define GPIO_PIN4                           (0x0010)
+#define GPIO_PIN5                           (0x0020)
+#define GPIO_PIN6                           (0x0040)
+#define GPIO_PIN7                           (0x0080)
+
+#define GPIO_INPUT_PIN_HIGH                 (0x01)
+#define GPIO_INPUT_PIN_LOW                  (0x00)
+
+#define GPIO_HIGH_TO_LOW_TRANSITION         (0x01)
+#define GPIO_LOW_TO_HIGH_TRANSITION         (0x00)
+
+#define GPIO_REDUCED_OUTPUT_DRIVE_STRENGTH  0x00
+#define GPIO_FULL_OUTPUT_DRIVE_STRENGTH     0x01
+
+void     GPIO_setAsOutputPin(uint8_t selectedPort, uint16_t selectedPins);
+void     GPIO_setAsInputPin(uint8_t selectedPort, uint16_t selectedPins);
+void     GPIO_setAsPeripheralModuleFunctionOutputPin(uint8_t selectedPort, uint16_t selectedPins);
+void     GPIO_setAsPeripheralModuleFunctionInputPin(uint8_t selectedPort, uint16_t selectedPins);
+void     GPIO_setOutputHighOnPin(uint8_t selectedPort, uint16_t selectedPins);
+void     GPIO_setOutputLowOnPin(uint8_t selectedPort, uint16_t selectedPins);
+void     GPIO_toggleOutputOnPin(uint8_t selectedPort, uint16_t selectedPins);
+uint8_t  GPIO_getInputPinValue(uint8_t selectedPort, uint16_t selectedPins);
+void     GPIO_enableInterrupt(uint8_t selectedPort, uint16_t selectedPins);
+void     GPIO_disableInterrupt(uint8_t selectedPort, uint16_t selectedPins);
+uint16_t GPIO_getInterruptStatus(uint8_t selectedPort, uint16_t selectedPins);
+void     GPIO_clearInterrupt(uint8_t selectedPort, uint16_t selectedPins);
+void     GPIO_selectInterruptEdge(uint8_t selectedPort, uint16_t selectedPins, uint8_t edgeSelect);
+void     GPIO_setDriveStrength(uint8_t selectedPort, uint16_t selectedPins, uint8_t driveStrength);
+
+#endif /* HOST_GPIO_H_ */
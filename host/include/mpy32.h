@@ -0,0 +1,27 @@
+/*
+ * mpy32.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// Host stand-in for the driverlib MPY32 module, implemented by host/sim/mpy32_sim.c. Multiply and multiply-accumulate of 16- and 32-bit
+// operands are simulated; saturation and fractional modes are not.
+
+#ifndef HOST_MPY32_H_
+#define HOST_MPY32_H_
+
+#include "msp430.h"
+
+#define MPY32_MULTIPLY_UNSIGNED           (0x00)
+#define MPY32_MULTIPLY_SIGNED             (0x02)
+#define MPY32_MULTIPLYACCUMULATE_UNSIGNED (0x04)
+#define MPY32_MULTIPLYACCUMULATE_SIGNED   (0x06)
+
+void     MPY32_setOperandOne16Bit(uint8_t multiplicationType, uint16_t operand);
+void     MPY32_setOperandOne32Bit(uint8_t multiplicationType, uint32_t operand);
+void     MPY32_setOperandTwo16Bit(uint16_t operand);
+void     MPY32_setOperandTwo32Bit(uint32_t operand);
+uint64_t MPY32_getResult(void);
+void     MPY32_preloadResult(uint64_t result);
+
+#endif /* HOST_MPY32_H_ */
@@ -0,0 +1,158 @@
+/*
+ * msp430.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// Host stand-in for the TI device header. It provides the base addresses, register offsets, bit names and compiler intrinsics that the firmware
+// and the simulated driverlib headers in this folder use, so that main.c, vcom.c and the AT86RF233 driver compile unchanged with gcc on Linux.
+// Register accesses made through HWREG8/HWREG16 land in the simulated memory map in host/sim/sim.c instead of absolute addresses.
+
+#ifndef HOST_MSP430_H_
+#define HOST_MSP430_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define __MSP430_HAS_USCI_Bx__
+#define __MSP430_HAS_USCI_Ax__
+
+volatile uint8_t  * sim_hwreg8(uint16_t address); // Returns simulated register backing a memory-mapped address (see sim.c)
+volatile uint16_t * sim_hwreg16(uint16_t address);
+
+#define HWREG8(x)  (*sim_hwreg8((uint16_t)(x)))
+#define HWREG16(x) (*sim_hwreg16((uint16_t)(x)))
+
+#define STATUS_SUCCESS 0x01
+#define STATUS_FAIL    0x00
+
+// Peripheral base addresses of the MSP430F5529
+#define WDT_A_BASE     (0x015C)
+#define PMM_BASE       (0x0120)
+#define UCS_BASE       (0x0160)
+#define TIMER_A0_BASE  (0x0340)
+#define TIMER_A1_BASE  (0x0380)
+#define TIMER_A2_BASE  (0x0400)
+#define TIMER_B0_BASE  (0x03C0)
+#define USCI_B0_BASE   (0x05E0)
+#define USCI_A1_BASE   (0x0600)
+#define DMA_BASE       (0x0500)
+#define CRC_BASE       (0x0150)
+
+#define __MSP430_BASEADDRESS_PORT2_R__ (0x0200)
+
+// Digital I/O register offsets
+#define OFS_P2OUT      (0x0003)
+
+// Timer_A register offsets
+#define OFS_TAxCTL     (0x0000)
+#define OFS_TAxCCTL0   (0x0002)
+#define OFS_TAxR       (0x0010)
+#define OFS_TAxCCR0    (0x0012)
+
+// Timer_B register offsets
+#define OFS_TBxCTL     (0x0000)
+#define OFS_TBxR       (0x0010)
+
+// USCI register offsets
+#define OFS_UCAxCTL1   (0x0000)
+#define OFS_UCAxBRW    (0x0006)
+#define OFS_UCAxMCTL   (0x0008)
+#define OFS_UCAxSTAT   (0x000A)
+#define OFS_UCAxRXBUF  (0x000C)
+#define OFS_UCAxTXBUF  (0x000E)
+#define OFS_UCAxIE     (0x001C)
+#define OFS_UCAxIFG    (0x001D)
+#define OFS_UCBxCTL1   (0x0000)
+#define OFS_UCBxBRW    (0x0006)
+#define OFS_UCBxSTAT   (0x000A)
+#define OFS_UCBxRXBUF  (0x000C)
+#define OFS_UCBxTXBUF  (0x000E)
+#define OFS_UCBxIE     (0x001C)
+#define OFS_UCBxIFG    (0x001D)
+
+// USCI bits
+#define UCRXIE         (0x01)
+#define UCTXIE         (0x02)
+#define UCRXIFG        (0x01)
+#define UCTXIFG        (0x02)
+#define UCBUSY         (0x01)
+#define UCOE           (0x20)
+#define UCMSB          (0x20)
+#define UCCKPH         (0x80)
+#define UCCKPL         (0x40)
+#define UCSSEL__ACLK   (0x40)
+#define UCSSEL__SMCLK  (0x80)
+#define UCMODE_0       (0x00)
+
+// Timer bits
+#define MC_0           (0x0000)
+#define MC_1           (0x0010)
+#define MC_2           (0x0020)
+#define MC_3           (0x0030)
+#define MC__UP         (MC_1)
+#define MC__CONTINUOUS (MC_2)
+#define MC__UPDOWN     (MC_3)
+#define TBCLR          (0x0004)
+#define TBIE           (0x0002)
+#define CCIE           (0x0010)
+#define TBSSEL__ACLK   (0x0100)
+#define TBSSEL__SMCLK  (0x0200)
+#define TACLR          (0x0004)
+#define TAIE           (0x0002)
+#define TAIFG          (0x0001)
+#define TASSEL__ACLK   (0x0100)
+#define TASSEL__SMCLK  (0x0200)
+#define CCIFG          (0x0001)
+#define COV            (0x0002)
+#define CAP            (0x0100)
+#define SCS            (0x0800)
+#define CCIS_0         (0x0000)
+#define CCIS_1         (0x1000)
+#define CCIS_MASK      (0x3000)
+#define CM_0           (0x0000)
+#define CM_1           (0x4000)
+#define CM_2           (0x8000)
+#define CM_3           (0xC000)
+#define OUT            (0x0004)
+#define OUTMOD_0       (0x0000)
+#define OUTMOD_1       (0x0020)
+#define OUTMOD_5       (0x00A0)
+#define OUTMOD_7       (0x00E0)
+
+// DMA bits
+#define DMADT_0        (0x0000)
+#define DMADT_1        (0x1000)
+#define DMADT_4        (0x4000)
+#define DMADT_MASK     (0x7000)
+#define DMADSTINCR_3   (0x0C00)
+#define DMASRCINCR_0   (0x0000)
+#define DMASRCINCR_2   (0x0200)
+#define DMASRCINCR_3   (0x0300)
+#define DMADSTBYTE     (0x0080)
+#define DMASRCBYTE     (0x0040)
+#define DMALEVEL       (0x0020)
+#define DMAEN          (0x0010)
+#define DMAIFG         (0x0008)
+#define DMAIE          (0x0004)
+
+// Status register bits
+#define GIE            (0x0008)
+#define CPUOFF         (0x0010)
+#define LPM0_bits      (CPUOFF)
+
+// Compiler intrinsics. Interrupts are dispatched by the simulator whenever the firmware re-enables them or calls into a function, and entering
+// a low-power mode lets virtual time run until an interrupt handler clears the mode bits.
+void sim_setGie(bool enable);
+uint16_t sim_getSr(void);
+void sim_bisSr(uint16_t bits);
+void sim_bicSrOnExit(uint16_t bits);
+#define __disable_interrupt()            sim_setGie(false)
+#define __enable_interrupt()             sim_setGie(true)
+#define __get_interrupt_state()          (sim_getSr() & GIE)
+#define __set_interrupt_state(x)         sim_setGie(((x) & GIE) != 0)
+#define __bis_SR_register(x)             sim_bisSr(x)
+#define __bic_SR_register_on_exit(x)     sim_bicSrOnExit(x)
+#define __no_operation()      ((void)0)
+
+#endif /* HOST_MSP430_H_ */
@@ -0,0 +1,18 @@
+/*
+ * pmm.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// Host stand-in for the driverlib PMM module.
+
+#ifndef HOST_PMM_H_
+#define HOST_PMM_H_
+
+#include "msp430.h"
+
+#define PMM_CORE_LEVEL_3 (0x0003)
+
+bool PMM_setVCore(uint8_t level);
+
+#endif /* HOST_PMM_H_ */
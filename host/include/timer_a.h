@@ -0,0 +1,109 @@
+/*
+ * timer_a.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// Host stand-in for the driverlib Timer_A module, implemented by host/sim/timer_a_sim.c. Timer_A0 to Timer_A2 are simulated.
+
+#ifndef HOST_TIMER_A_H_
+#define HOST_TIMER_A_H_
+
+#include "msp430.h"
+
+typedef struct Timer_A_initContinuousModeParam {
+    uint16_t clockSource;
+    uint16_t clockSourceDivider;
+    uint16_t timerInterruptEnable_TAIE;
+    uint16_t timerClear;
+    bool startTimer;
+} Timer_A_initContinuousModeParam;
+
+typedef struct Timer_A_initUpDownModeParam {
+    uint16_t clockSource;
+    uint16_t clockSourceDivider;
+    uint16_t timerPeriod;
+    uint16_t timerInterruptEnable_TAIE;
+    uint16_t captureCompareInterruptEnable_CCR0_CCIE;
+    uint16_t timerClear;
+    bool startTimer;
+} Timer_A_initUpDownModeParam;
+
+typedef struct Timer_A_initCompareModeParam {
+    uint16_t compareRegister;
+    uint16_t compareInterruptEnable;
+    uint16_t compareOutputMode;
+    uint16_t compareValue;
+} Timer_A_initCompareModeParam;
+
+typedef struct Timer_A_initCaptureModeParam {
+    uint16_t captureRegister;
+    uint16_t captureMode;
+    uint16_t captureInputSelect;
+    uint16_t synchronizeCaptureSource;
+    uint16_t captureInterruptEnable;
+    uint16_t captureOutputMode;
+} Timer_A_initCaptureModeParam;
+
+#define TIMER_A_CLOCKSOURCE_DIVIDER_1            0x00
+#define TIMER_A_CLOCKSOURCE_DIVIDER_2            0x08
+#define TIMER_A_CLOCKSOURCE_DIVIDER_4            0x10
+#define TIMER_A_STOP_MODE                        MC_0
+#define TIMER_A_UP_MODE                          MC_1
+#define TIMER_A_CONTINUOUS_MODE                  MC_2
+#define TIMER_A_UPDOWN_MODE                      MC_3
+#define TIMER_A_DO_CLEAR                         TACLR
+#define TIMER_A_SKIP_CLEAR                       0x00
+#define TIMER_A_CLOCKSOURCE_ACLK                 TASSEL__ACLK
+#define TIMER_A_CLOCKSOURCE_SMCLK                TASSEL__SMCLK
+#define TIMER_A_TAIE_INTERRUPT_ENABLE            TAIE
+#define TIMER_A_TAIE_INTERRUPT_DISABLE           0x00
+#define TIMER_A_CCIE_CCR0_INTERRUPT_ENABLE       CCIE
+#define TIMER_A_CCIE_CCR0_INTERRUPT_DISABLE      0x00
+#define TIMER_A_CAPTURECOMPARE_INTERRUPT_ENABLE  CCIE
+#define TIMER_A_CAPTURECOMPARE_INTERRUPT_DISABLE 0x00
+#define TIMER_A_CAPTURECOMPARE_INTERRUPT_FLAG    CCIFG
+#define TIMER_A_OUTPUTMODE_OUTBITVALUE           OUTMOD_0
+#define TIMER_A_OUTPUTMODE_SET                   OUTMOD_1
+#define TIMER_A_OUTPUTMODE_RESET                 OUTMOD_5
+#define TIMER_A_OUTPUTMODE_OUTBITVALUE_HIGH      OUT
+#define TIMER_A_OUTPUTMODE_OUTBITVALUE_LOW       0x00
+#define TIMER_A_CAPTURECOMPARE_REGISTER_0        0x02
+#define TIMER_A_CAPTURECOMPARE_REGISTER_1        0x04
+#define TIMER_A_CAPTURECOMPARE_REGISTER_2        0x06
+#define TIMER_A_CAPTURECOMPARE_REGISTER_3        0x08
+#define TIMER_A_CAPTURECOMPARE_REGISTER_4        0x0A
+#define TIMER_A_CAPTUREMODE_NO_CAPTURE           CM_0
+#define TIMER_A_CAPTUREMODE_RISING_EDGE          CM_1
+#define TIMER_A_CAPTUREMODE_FALLING_EDGE         CM_2
+#define TIMER_A_CAPTUREMODE_RISING_AND_FALLING_EDGE CM_3
+#define TIMER_A_CAPTURE_INPUTSELECT_CCIxA        CCIS_0
+#define TIMER_A_CAPTURE_INPUTSELECT_CCIxB        CCIS_1
+#define TIMER_A_CAPTURE_ASYNCHRONOUS             0x00
+#define TIMER_A_CAPTURE_SYNCHRONOUS              SCS
+#define TIMER_A_CAPTURE_OVERFLOW                 COV
+#define TIMER_A_INTERRUPT_NOT_PENDING            0x00
+#define TIMER_A_INTERRUPT_PENDING                0x01
+
+void     Timer_A_initContinuousMode(uint16_t baseAddress, Timer_A_initContinuousModeParam *param);
+void     Timer_A_initUpDownMode(uint16_t baseAddress, Timer_A_initUpDownModeParam *param);
+void     Timer_A_initCompareMode(uint16_t baseAddress, Timer_A_initCompareModeParam *param);
+void     Timer_A_initCaptureMode(uint16_t baseAddress, Timer_A_initCaptureModeParam *param);
+void     Timer_A_startCounter(uint16_t baseAddress, uint16_t timerMode);
+void     Timer_A_stop(uint16_t baseAddress);
+void     Timer_A_clear(uint16_t baseAddress);
+uint16_t Timer_A_getCounterValue(uint16_t baseAddress);
+void     Timer_A_setCompareValue(uint16_t baseAddress, uint16_t compareRegister, uint16_t compareValue);
+uint16_t Timer_A_getCaptureCompareCount(uint16_t baseAddress, uint16_t captureCompareRegister);
+void     Timer_A_enableCaptureCompareInterrupt(uint16_t baseAddress, uint16_t captureCompareRegister);
+void     Timer_A_disableCaptureCompareInterrupt(uint16_t baseAddress, uint16_t captureCompareRegister);
+uint32_t Timer_A_getCaptureCompareInterruptStatus(uint16_t baseAddress, uint16_t captureCompareRegister, uint16_t mask);
+void     Timer_A_clearCaptureCompareInterrupt(uint16_t baseAddress, uint16_t captureCompareRegister);
+void     Timer_A_setOutputMode(uint16_t baseAddress, uint16_t compareRegister, uint16_t compareOutputMode);
+void     Timer_A_setOutputForOutputModeOutBitValue(uint16_t baseAddress, uint16_t captureCompareRegister, uint8_t outputModeOutBitValue);
+void     Timer_A_enableInterrupt(uint16_t baseAddress);
+void     Timer_A_disableInterrupt(uint16_t baseAddress);
+uint32_t Timer_A_getInterruptStatus(uint16_t baseAddress);
+void     Timer_A_clearTimerInterrupt(uint16_t baseAddress);
+
+#endif /* HOST_TIMER_A_H_ */
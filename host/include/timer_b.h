@@ -0,0 +1,52 @@
+/*
+ * timer_b.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// Host stand-in for the driverlib Timer_B module, implemented by host/sim/timer_sim.c.
+
+#ifndef HOST_TIMER_B_H_
+#define HOST_TIMER_B_H_
+
+#include "msp430.h"
+
+typedef struct Timer_B_initUpModeParam {
+    uint16_t clockSource;
+    uint16_t clockSourceDivider;
+    uint16_t timerPeriod;
+    uint16_t timerInterruptEnable_TBIE;
+    uint16_t captureCompareInterruptEnable_CCR0_CCIE;
+    uint16_t timerClear;
+    bool startTimer;
+} Timer_B_initUpModeParam;
+
+typedef struct Timer_B_initContinuousModeParam {
+    uint16_t clockSource;
+    uint16_t clockSourceDivider;
+    uint16_t timerInterruptEnable_TBIE;
+    uint16_t timerClear;
+    bool startTimer;
+} Timer_B_initContinuousModeParam;
+
+#define TIMER_B_CLOCKSOURCE_DIVIDER_1      0x00
+#define TIMER_B_STOP_MODE                  MC_0
+#define TIMER_B_UP_MODE                    MC_1
+#define TIMER_B_CONTINUOUS_MODE            MC_2
+#define TIMER_B_DO_CLEAR                   TBCLR
+#define TIMER_B_SKIP_CLEAR                 0x00
+#define TIMER_B_CLOCKSOURCE_ACLK           TBSSEL__ACLK
+#define TIMER_B_CLOCKSOURCE_SMCLK          TBSSEL__SMCLK
+#define TIMER_B_TBIE_INTERRUPT_ENABLE      TBIE
+#define TIMER_B_TBIE_INTERRUPT_DISABLE     0x00
+#define TIMER_B_CCIE_CCR0_INTERRUPT_ENABLE CCIE
+#define TIMER_B_CCIE_CCR0_INTERRUPT_DISABLE 0x00
+
+void     Timer_B_initUpMode(uint16_t baseAddress, Timer_B_initUpModeParam *param);
+void     Timer_B_initContinuousMode(uint16_t baseAddress, Timer_B_initContinuousModeParam *param);
+void     Timer_B_startCounter(uint16_t baseAddress, uint16_t timerMode);
+void     Timer_B_stop(uint16_t baseAddress);
+void     Timer_B_clear(uint16_t baseAddress);
+uint16_t Timer_B_getCounterValue(uint16_t baseAddress);
+
+#endif /* HOST_TIMER_B_H_ */
@@ -0,0 +1,28 @@
+/*
+ * ucs.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// Host stand-in for the driverlib UCS module. The simulated MCU always runs MCLK and SMCLK at 20MHz and ACLK at 32.768kHz.
+
+#ifndef HOST_UCS_H_
+#define HOST_UCS_H_
+
+#include "msp430.h"
+
+#define UCS_REFOCLK_FREQUENCY 32768
+#define UCS_ACLK              0x01
+#define UCS_MCLK              0x02
+#define UCS_SMCLK             0x04
+#define UCS_FLLREF            0x08
+#define UCS_REFOCLK_SELECT    0x0020
+#define UCS_CLOCK_DIVIDER_1   0x0000
+
+void     UCS_initClockSignal(uint8_t selectedClockSignal, uint16_t clockSource, uint16_t clockSourceDivider);
+void     UCS_initFLLSettle(uint16_t fsystem, uint16_t ratio);
+uint32_t UCS_getSMCLK(void);
+uint32_t UCS_getMCLK(void);
+uint32_t UCS_getACLK(void);
+
+#endif /* HOST_UCS_H_ */
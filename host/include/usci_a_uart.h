@@ -0,0 +1,53 @@
+/*
+ * usci_a_uart.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// Host stand-in for the driverlib USCI_A_UART module, implemented by host/sim/uart_sim.c.
+
+#ifndef HOST_USCI_A_UART_H_
+#define HOST_USCI_A_UART_H_
+
+#include "msp430.h"
+
+typedef struct USCI_A_UART_initParam {
+    uint8_t selectClockSource;
+    uint16_t clockPrescalar;
+    uint8_t firstModReg;
+    uint8_t secondModReg;
+    uint8_t parity;
+    uint8_t msborLsbFirst;
+    uint8_t numberofStopBits;
+    uint8_t uartMode;
+    uint8_t overSampling;
+} USCI_A_UART_initParam;
+
+#define USCI_A_UART_NO_PARITY                         0x00
+#define USCI_A_UART_MSB_FIRST                         UCMSB
+#define USCI_A_UART_LSB_FIRST                         0x00
+#define USCI_A_UART_MODE                              UCMODE_0
+#define USCI_A_UART_CLOCKSOURCE_SMCLK                 UCSSEL__SMCLK
+#define USCI_A_UART_CLOCKSOURCE_ACLK                  UCSSEL__ACLK
+#define USCI_A_UART_ONE_STOP_BIT                      0x00
+#define USCI_A_UART_OVERSAMPLING_BAUDRATE_GENERATION  0x01
+#define USCI_A_UART_LOW_FREQUENCY_BAUDRATE_GENERATION 0x00
+#define USCI_A_UART_RECEIVE_INTERRUPT                 UCRXIE
+#define USCI_A_UART_TRANSMIT_INTERRUPT                UCTXIE
+#define USCI_A_UART_RECEIVE_INTERRUPT_FLAG            UCRXIFG
+#define USCI_A_UART_TRANSMIT_INTERRUPT_FLAG           UCTXIFG
+#define USCI_A_UART_BUSY                              UCBUSY
+
+bool     USCI_A_UART_init(uint16_t baseAddress, USCI_A_UART_initParam *param);
+void     USCI_A_UART_enable(uint16_t baseAddress);
+void     USCI_A_UART_disable(uint16_t baseAddress);
+void     USCI_A_UART_transmitData(uint16_t baseAddress, uint8_t transmitData);
+uint8_t  USCI_A_UART_receiveData(uint16_t baseAddress);
+void     USCI_A_UART_enableInterrupt(uint16_t baseAddress, uint8_t mask);
+void     USCI_A_UART_disableInterrupt(uint16_t baseAddress, uint8_t mask);
+uint8_t  USCI_A_UART_getInterruptStatus(uint16_t baseAddress, uint8_t mask);
+void     USCI_A_UART_clearInterrupt(uint16_t baseAddress, uint8_t mask);
+uint8_t  USCI_A_UART_queryStatusFlags(uint16_t baseAddress, uint8_t mask);
+uint32_t USCI_A_UART_getTransmitBufferAddressForDMA(uint16_t baseAddress);
+
+#endif /* HOST_USCI_A_UART_H_ */
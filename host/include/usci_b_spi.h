@@ -0,0 +1,49 @@
+/*
+ * usci_b_spi.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// Host stand-in for the driverlib USCI_B_SPI module, implemented by host/sim/spi_sim.c.
+
+#ifndef HOST_USCI_B_SPI_H_
+#define HOST_USCI_B_SPI_H_
+
+#include "msp430.h"
+
+typedef struct USCI_B_SPI_initMasterParam {
+    uint8_t selectClockSource;
+    uint32_t clockSourceFrequency;
+    uint32_t desiredSpiClock;
+    uint8_t msbFirst;
+    uint8_t clockPhase;
+    uint8_t clockPolarity;
+} USCI_B_SPI_initMasterParam;
+
+#define USCI_B_SPI_PHASE_DATA_CHANGED_ONFIRST_CAPTURED_ON_NEXT 0x00
+#define USCI_B_SPI_PHASE_DATA_CAPTURED_ONFIRST_CHANGED_ON_NEXT UCCKPH
+#define USCI_B_SPI_MSB_FIRST                                   UCMSB
+#define USCI_B_SPI_LSB_FIRST                                   0x00
+#define USCI_B_SPI_CLOCKPOLARITY_INACTIVITY_HIGH               UCCKPL
+#define USCI_B_SPI_CLOCKPOLARITY_INACTIVITY_LOW                0x00
+#define USCI_B_SPI_CLOCKSOURCE_ACLK                            UCSSEL__ACLK
+#define USCI_B_SPI_CLOCKSOURCE_SMCLK                           UCSSEL__SMCLK
+#define USCI_B_SPI_TRANSMIT_INTERRUPT                          UCTXIE
+#define USCI_B_SPI_RECEIVE_INTERRUPT                           UCRXIE
+#define USCI_B_SPI_BUSY                                        UCBUSY
+#define USCI_B_SPI_NOT_BUSY                                    0x00
+
+bool     USCI_B_SPI_initMaster(uint16_t baseAddress, USCI_B_SPI_initMasterParam *param);
+void     USCI_B_SPI_enable(uint16_t baseAddress);
+void     USCI_B_SPI_disable(uint16_t baseAddress);
+void     USCI_B_SPI_transmitData(uint16_t baseAddress, uint8_t transmitData);
+uint8_t  USCI_B_SPI_receiveData(uint16_t baseAddress);
+void     USCI_B_SPI_enableInterrupt(uint16_t baseAddress, uint8_t mask);
+void     USCI_B_SPI_disableInterrupt(uint16_t baseAddress, uint8_t mask);
+uint8_t  USCI_B_SPI_getInterruptStatus(uint16_t baseAddress, uint8_t mask);
+void     USCI_B_SPI_clearInterrupt(uint16_t baseAddress, uint8_t mask);
+uint32_t USCI_B_SPI_getReceiveBufferAddressForDMA(uint16_t baseAddress);
+uint32_t USCI_B_SPI_getTransmitBufferAddressForDMA(uint16_t baseAddress);
+uint8_t  USCI_B_SPI_isBusy(uint16_t baseAddress);
+
+#endif /* HOST_USCI_B_SPI_H_ */
@@ -0,0 +1,16 @@
+/*
+ * wdt_a.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// Host stand-in for the driverlib WDT_A module.
+
+#ifndef HOST_WDT_A_H_
+#define HOST_WDT_A_H_
+
+#include "msp430.h"
+
+void WDT_A_hold(uint16_t baseAddress);
+
+#endif /* HOST_WDT_A_H_ */
@@ -0,0 +1,652 @@
+/*
+ * at86_model.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// This file is a register-level behavioral model of the AT86RF233 as seen over SPI by the firmware. It covers the register file, the TRX_STATE
+// state machine with datasheet transition times (including SLEEP, and TX_START from PLL_ON, through SLP_TR), IRQ_STATUS and the IRQ pin, the
+// frame buffer, the O-QPSK data rates (the SHR and PHR at 250 kb/s, the PSDU at the rate of TRX_CTRL_2), PHY_PMU_VALUE during reception, the
+// frame timestamp on DIG2 (high from RX_START to the end of a received frame, while TRX_CTRL_1.IRQ_2_EXT_EN is set), and the PLL: a change
+// of frequency, by channel or by CC_CTRL_0/CC_CTRL_1, with the PLL running has it lock again (PLL_LOCK), after a center frequency
+// calibration, and PLL_CF_START / PLL_DCU_START run the calibrations by hand.
+// The PSDU is read from the frame buffer as it goes on the air, so a byte written after its turn is a frame buffer underrun (TRX_UR).
+// The extended operating mode is covered as far as the firmware sees it: TX_ARET_ON runs a CSMA-CA backoff drawn from CSMA_SEED and CSMA_BE
+// on a channel that is always clear, and waits for the ACK the other board always sends when one is requested; RX_AACK_ON receives data
+// frames addressed to our PAN ID and short address, and acknowledges them.
+// The "air" is a second board that transmits the same frame as transmitPayload() a short time after the model enters RX_ON, or the same
+// frame behind a MAC header, requesting an ACK, in RX_AACK_ON.
+
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+#include "gpio.h"
+#include "hal.h"
+#include "at86.h"
+#include "registers.h"
+
+#define FB_SIZE            (128U) // Frame buffer size (PHR followed by up to 127 PSDU bytes)
+#define SYMBOL_CYCLES      SIM_US(16) // One O-QPSK symbol at 250kb/s; two symbols per octet
+#define OCTET_CYCLES       (2U*SYMBOL_CYCLES)
+#define SHR_OCTETS         (5U) // Preamble and SFD
+#define PMU_PERIOD         SIM_US(8) // PHY_PMU_VALUE update period
+#define T_P_ON_TRX_OFF     SIM_US(330) // Crystal start-up
+#define T_TRX_OFF_PLL_ON   SIM_US(80) // PLL settling
+#define T_FAST             SIM_US(1) // PLL_ON <-> RX_ON, FORCE_TRX_OFF, ...
+#define T_PLL_CH           SIM_US(11) // PLL lock after a channel change, once the center frequency calibration is over
+#define T_PLL_CF           SIM_US(35) // Center frequency calibration
+#define T_PLL_DCU          SIM_US(6) // Delay cell calibration
+#define T_TX_START         SIM_US(16) // TX_START to start of preamble
+#define T_SLEEP_TRX_OFF    SIM_US(210) // Wake-up from SLEEP (crystal start-up)
+#define AIR_DELAY          SIM_US(500) // Time after entering RX_ON at which the other board starts transmitting
+#define AIR_FRAME_LEN      (64U) // PHR of the frame on the air
+#define AIR_ADDRESS        (0xAA) // First PSDU byte of the frame on the air, or first byte after the MAC header in RX_AACK_ON
+#define AIR_SHORT_ADDR     (0xBEEF) // Short address of the other board, the source of its MAC frames
+#define MAC_HEADER_LEN     (9U) // Frame control, sequence number, destination PAN ID, destination and source short addresses
+#define FCF_ACK_REQUEST    (0x20) // ACK request bit of the first frame control byte
+#define T_BACKOFF          SIM_US(320) // Unit backoff period of CSMA-CA (20 symbols)
+#define T_CCA              SIM_US(128) // Clear channel assessment (8 symbols)
+#define T_ACK_TURNAROUND   SIM_US(192) // End of a frame to start of its ACK (12 symbols)
+#define ACK_OCTETS         (5U) // PSDU of an ACK: frame control, sequence number and FCS
+
+static uint8_t regs[0x40]; // Register file
+static uint8_t fb[FB_SIZE]; // Frame buffer; fb[0] is the PHR
+static bool powered = false;
+static bool slp_tr = false; // Level of the SLP_TR pin
+static AT86_Status_Enum state = statusP_ON;
+static AT86_Status_Enum target; // State being entered while in STATE_TRANSITION_IN_PROGRESS
+static AT86_Status_Enum origin; // State the current transition started from
+static AT86_Cmd_Enum deferred = cmdNOP; // Command received while busy, executed at the end of the frame
+static sim_event_t transition; // End of a state transition
+static sim_event_t frame_start; // Other board starts transmitting (RX) / preamble goes out (TX)
+static sim_event_t rx_start; // PHR received
+static sim_event_t frame_end; // Last PSDU octet
+static sim_event_t ack_end; // End of the ACK that follows a frame in the extended operating mode
+static sim_event_t pll_lock; // PLL locked again after a channel change
+static sim_event_t pll_cal; // End of the calibrations started through PLL_CF_START and PLL_DCU_START
+static sim_time_t rx_start_time; // When the current reception started, for PHY_PMU_VALUE
+static sim_time_t tx_backoff; // CSMA-CA backoff and CCA of the current transmission in BUSY_TX_ARET
+static bool tx_on_air = false; // Whether the PSDU of the current transmission is being read from the frame buffer
+static sim_time_t tx_psdu_start; // When the first PSDU byte of the current transmission goes on the air
+static bool tx_underrun = false; // Whether a byte of the current transmission was written after it had gone on the air
+static uint16_t csma_rand = 0; // State of the random number generator of CSMA-CA
+static uint8_t air_seq = 0; // Sequence number of the next MAC frame of the other board
+
+static uint8_t spi_idx; // Byte index within the current SPI transaction
+static uint8_t spi_cmd; // Command byte of the current transaction
+static uint8_t spi_addr; // Register or SRAM address of the current transaction
+
+static uint32_t num_cmds = 0; // TRX_STATE commands received
+static uint32_t num_tx = 0; // Frames transmitted
+static uint32_t num_pin_tx = 0; // Transmissions started by SLP_TR rather than TX_START
+static uint32_t num_rx = 0; // Frames received
+static uint32_t num_acks = 0; // ACKs received in BUSY_TX_ARET or sent in BUSY_RX_AACK
+static uint32_t num_fb_bytes = 0; // Frame buffer bytes written over SPI
+static uint32_t num_underruns = 0; // Transmissions that ended with TRX_UR
+static uint32_t num_hops = 0; // Frequency changes with the PLL running
+static uint32_t num_cf_cals = 0; // Center frequency calibrations, automatic or started through PLL_CF_START
+static uint32_t num_irq_edges = 0; // Rising edges on the IRQ pin
+static uint32_t num_pmu_reads = 0; // PHY_PMU_VALUE reads during reception
+static sim_time_t tx_cycles = 0; // Time spent in BUSY_TX
+static sim_time_t rx_cycles = 0; // Time spent in BUSY_RX
+
+// This function puts the register file in its reset state.
+static void _reset(void)
+{
+    memset(regs, 0, sizeof(regs));
+    regs[REG__TRX_CTRL_0] = RST__TRX_CTRL_0;
+    regs[REG__TRX_CTRL_1] = RST__TRX_CTRL_1;
+    regs[REG__PHY_TX_PWR] = RST__PHY_TX_PWR;
+    regs[REG__PHY_RSSI] = RST__PHY_RSSI;
+    regs[REG__PHY_ED_LEVEL] = RST__PHY_ED_LEVEL;
+    regs[REG__PHY_CC_CCA] = RST__PHY_CC_CCA;
+    regs[REG__CCA_THRES] = RST__CCA_THRES;
+    regs[REG__RX_CTRL] = RST__RX_CTRL;
+    regs[REG__SFD_VALUE] = RST__SFD_VALUE;
+    regs[REG__TRX_CTRL_2] = RST__TRX_CTRL_2;
+    regs[REG__BATMON] = RST__BATMON;
+    regs[REG__XOSC_CTRL] = RST__XOSC_CTRL;
+    regs[REG__TRX_RPC] = RST__TRX_RPC;
+    regs[REG__FTN_CTRL] = RST__FTN_CTRL;
+    regs[REG__PLL_CF] = RST__PLL_CF;
+    regs[REG__PLL_DCU] = RST__PLL_DCU;
+    regs[REG__PART_NUM] = RST__PART_NUM;
+    regs[REG__VERSION_NUM] = RST__VERSION_NUM_B;
+    regs[REG__MAN_ID_0] = RST__MAN_ID_0;
+    regs[REG__MAN_ID_1] = RST__MAN_ID_1;
+    regs[REG__SHORT_ADDR_0] = RST__SHORT_ADDR_0;
+    regs[REG__SHORT_ADDR_1] = RST__SHORT_ADDR_1;
+    regs[REG__PAN_ID_0] = RST__PAN_ID_0;
+    regs[REG__PAN_ID_1] = RST__PAN_ID_1;
+    regs[REG__XAH_CTRL_0] = RST__XAH_CTRL_0;
+    regs[REG__CSMA_SEED_0] = RST__CSMA_SEED_0;
+    regs[REG__CSMA_SEED_1] = RST__CSMA_SEED_1;
+    regs[REG__CSMA_BE] = RST__CSMA_BE;
+    sim_disarm(&transition);
+    sim_disarm(&frame_start);
+    sim_disarm(&rx_start);
+    sim_disarm(&frame_end);
+    sim_disarm(&ack_end);
+    sim_disarm(&pll_lock);
+    sim_disarm(&pll_cal);
+    deferred = cmdNOP;
+    tx_on_air = false;
+}
+
+// This function drives the IRQ pin from IRQ_STATUS and IRQ_MASK.
+static void _updateIrqPin(void)
+{
+    bool level = powered && ((regs[REG__IRQ_STATUS] & regs[REG__IRQ_MASK]) != 0);
+    if(regs[REG__TRX_CTRL_1] & MASK__TRX_CTRL_1__IRQ_POLARITY)
+        level = !level;
+    if(level && !gpio_sim_outputHigh(AT86_IRQ_PORT, AT86_IRQ_PIN))
+        ++num_irq_edges;
+    gpio_sim_drivePin(AT86_IRQ_PORT, AT86_IRQ_PIN, level);
+}
+
+// This function returns whether a frame is being received, in either operating mode.
+static bool _receiving(void)
+{
+    return ((state == statusBUSY_RX) || (state == statusBUSY_RX_AACK)) && frame_end.armed;
+}
+
+// This function drives the DIG2 pin, which follows the received frame while TRX_CTRL_1.IRQ_2_EXT_EN is set and is low otherwise.
+static void _updateDig2Pin(bool receiving)
+{
+    gpio_sim_drivePin(AT86_DIG2_PORT, AT86_DIG2_PIN, powered && receiving && (regs[REG__TRX_CTRL_1] & MASK__TRX_CTRL_1__IRQ_2_EXT_EN));
+}
+
+// This function records an interrupt in IRQ_STATUS. Unless IRQ_MASK_MODE is set, masked interrupts are not recorded.
+static void _raise(AT86_Irq_Enum irq)
+{
+    if((regs[REG__TRX_CTRL_1] & MASK__TRX_CTRL_1__IRQ_MASK_MODE) || (regs[REG__IRQ_MASK] & irq))
+        regs[REG__IRQ_STATUS] |= irq;
+    _updateIrqPin();
+}
+
+// This function starts a transition to another state.
+static void _goTo(AT86_Status_Enum next, sim_time_t duration)
+{
+    origin = (state == statusSTATE_TRANSITION_IN_PROGRESS) ? origin : state;
+    target = next;
+    state = statusSTATE_TRANSITION_IN_PROGRESS;
+    sim_arm(&transition, sim_now + duration);
+}
+
+// This function stops any frame in progress.
+static void _abortFrame(void)
+{
+    sim_disarm(&frame_start);
+    sim_disarm(&rx_start);
+    sim_disarm(&frame_end);
+    sim_disarm(&ack_end);
+    deferred = cmdNOP;
+    _updateDig2Pin(false);
+}
+
+// This function starts sending the frame buffer, on TX_START or a rising edge of SLP_TR in PLL_ON or TX_ARET_ON. In TX_ARET_ON the frame
+// follows a random backoff of up to 2^MIN_BE - 1 periods and a CCA, unless MAX_CSMA_RETRIES is 7.
+static void _startTx(void)
+{
+    tx_backoff = 0;
+    if(state == statusTX_ARET_ON)
+    {
+        state = statusBUSY_TX_ARET;
+        regs[REG__TRX_STATE] = tracINVALID << SHIFT__TRX_STATE__TRAC_STATUS; // Until the transaction is over
+        if(((regs[REG__XAH_CTRL_0] & MASK__XAH_CTRL_0__MAX_CSMA_RETRIES) >> SHIFT__XAH_CTRL_0__MAX_CSMA_RETRIES) != 7U)
+        {
+            uint16_t seed = regs[REG__CSMA_SEED_0] | ((regs[REG__CSMA_SEED_1] & MASK__CSMA_SEED_1__CSMA_SEED_1) << 8);
+            uint8_t min_be = (regs[REG__CSMA_BE] & MASK__CSMA_BE__MIN_BE) >> SHIFT__CSMA_BE__MIN_BE;
+            csma_rand = (uint16_t) (csma_rand*25173U + 13849U + seed);
+            tx_backoff = (sim_time_t) ((csma_rand >> 8) & ((1U << min_be) - 1U)) * T_BACKOFF + T_CCA;
+        }
+    }
+    else
+        state = statusBUSY_TX;
+    sim_arm(&frame_start, sim_now + tx_backoff + T_TX_START);
+}
+
+// This function executes a TRX_STATE command.
+static void _command(AT86_Cmd_Enum cmd)
+{
+    ++num_cmds;
+    AT86_Status_Enum from = (state == statusSTATE_TRANSITION_IN_PROGRESS) ? target : state;
+    if((cmd != cmdFORCE_TRX_OFF) && (cmd != cmdFORCE_PLL_ON) && ((from == statusBUSY_TX) || (from == statusBUSY_RX) ||
+                                                                  (from == statusBUSY_TX_ARET) || (from == statusBUSY_RX_AACK)))
+    {
+        deferred = cmd; // Executed once the frame is finished
+        return;
+    }
+    switch(cmd)
+    {
+    case cmdFORCE_TRX_OFF:
+    case cmdTRX_OFF:
+        _abortFrame();
+        _goTo(statusTRX_OFF, (from == statusP_ON) ? T_P_ON_TRX_OFF : T_FAST);
+        break;
+    case cmdFORCE_PLL_ON:
+    case cmdPLL_ON:
+        if(from == statusP_ON)
+            break;
+        _abortFrame();
+        _goTo(statusPLL_ON, (from == statusTRX_OFF) ? T_TRX_OFF_PLL_ON : T_FAST);
+        break;
+    case cmdRX_ON:
+    case cmdRX_AACK_ON:
+    {
+        AT86_Status_Enum listen = (cmd == cmdRX_ON) ? statusRX_ON : statusRX_AACK_ON;
+        if((from == listen) && (state == listen) && !frame_start.armed) // Listening again: the other board sends its next frame.
+            sim_arm(&frame_start, sim_now + AIR_DELAY);
+        if((from != statusTRX_OFF) && (from != statusPLL_ON)) // Already there, or the other mode, which has to go through PLL_ON
+            break;
+        _abortFrame();
+        _goTo(listen, (from == statusTRX_OFF) ? T_TRX_OFF_PLL_ON : T_FAST);
+        break;
+    }
+    case cmdTX_ARET_ON:
+        if((from != statusTRX_OFF) && (from != statusPLL_ON))
+            break;
+        _abortFrame();
+        _goTo(statusTX_ARET_ON, (from == statusTRX_OFF) ? T_TRX_OFF_PLL_ON : T_FAST);
+        break;
+    case cmdTX_START:
+        if((from == statusPLL_ON) || (from == statusTX_ARET_ON))
+            _startTx();
+        break;
+    default:
+        break;
+    }
+}
+
+// This function returns the center frequency (MHz) the PLL is tuned to: that of the channel selected by PHY_CC_CCA while CC_CTRL_1.CC_BAND
+// is 0, or 2306 MHz + CC_CTRL_0.CC_NUMBER for CC_BAND 8.
+static uint16_t _freq(void)
+{
+    if(((regs[REG__CC_CTRL_1] & MASK__CC_CTRL_1__CC_BAND) >> SHIFT__CC_CTRL_1__CC_BAND) == 0x08)
+        return 2306U + ((regs[REG__CC_CTRL_0] & MASK__CC_CTRL_0__CC_NUMBER) >> SHIFT__CC_CTRL_0__CC_NUMBER);
+    return 2405U + 5U*(((regs[REG__PHY_CC_CCA] & MASK__PHY_CC_CCA__CHANNEL) >> SHIFT__PHY_CC_CCA__CHANNEL) - 11U);
+}
+
+// This function returns the PLL_CF calibration value the model finds at a frequency.
+static uint8_t _cfValue(uint16_t freq)
+{
+    return (uint8_t) ((freq*5U + 3U) & MASK__PLL_CF__PLL_CF);
+}
+
+// This function stores the result of a center frequency calibration on the current channel in PLL_CF.
+static void _calibrateCf(void)
+{
+    ++num_cf_cals;
+    regs[REG__PLL_CF] = (regs[REG__PLL_CF] & ~(MASK__PLL_CF__PLL_CF|MASK__PLL_CF__PLL_CF_START)) | _cfValue(_freq());
+}
+
+// This function returns whether the PLL is running, so that a channel change has it lock again.
+static bool _pllRunning(void)
+{
+    AT86_Status_Enum now = (state == statusSTATE_TRANSITION_IN_PROGRESS) ? target : state;
+    return (now != statusP_ON) && (now != statusTRX_OFF) && (now != statusSLEEP);
+}
+
+// This function has the PLL lock on a new frequency: like the AT86RF233, it calibrates the center frequency first, whatever PLL_CF holds.
+static void _hop(void)
+{
+    ++num_hops;
+    sim_arm(&pll_lock, sim_now + T_PLL_CF + T_PLL_CH);
+}
+
+// This function runs when the PLL has locked after a channel change.
+static void _pllLock(void)
+{
+    _calibrateCf();
+    _raise(irqPLL_LOCK);
+}
+
+// This function ends the calibrations started through PLL_CF_START and PLL_DCU_START.
+static void _pllCal(void)
+{
+    if(regs[REG__PLL_CF] & MASK__PLL_CF__PLL_CF_START)
+        _calibrateCf();
+    regs[REG__PLL_DCU] &= ~MASK__PLL_DCU__PLL_DCU_START;
+}
+
+// This function completes a state transition.
+static void _transitionDone(void)
+{
+    state = target;
+    if((state != statusTRX_OFF) && (origin == statusTRX_OFF)) // PLL had to lock, calibrating on the way
+    {
+        _calibrateCf();
+        _raise(irqPLL_LOCK);
+    }
+    if((state == statusRX_ON) || (state == statusRX_AACK_ON)) // The other board starts sending a little after we start listening
+        sim_arm(&frame_start, sim_now + AIR_DELAY);
+}
+
+// This function returns the airtime of a PSDU at the data rate selected by TRX_CTRL_2.OQPSK_DATA_RATE (250 kb/s to 2 Mb/s).
+static sim_time_t _psduCycles(uint8_t phr)
+{
+    uint8_t rate = (regs[REG__TRX_CTRL_2] & MASK__TRX_CTRL_2__OQPSK_DATA_RATE) >> SHIFT__TRX_CTRL_2__OQPSK_DATA_RATE;
+    return ((sim_time_t) (phr & 0x7F) * OCTET_CYCLES) >> (rate & 0x03);
+}
+
+static void _frameStart(void)
+{
+    if((state == statusBUSY_TX) || (state == statusBUSY_TX_ARET)) // Preamble, SFD and PHR go out, then the PSDU
+    {
+        tx_on_air = true;
+        tx_underrun = false;
+        tx_psdu_start = sim_now + (SHR_OCTETS+1U)*OCTET_CYCLES;
+        sim_arm(&frame_end, tx_psdu_start + _psduCycles(fb[0]));
+    }
+    else if((state == statusRX_ON) || (state == statusRX_AACK_ON)) // The PHR of the other board's frame is received after the SHR and the PHR itself
+        sim_arm(&rx_start, sim_now + (SHR_OCTETS+1U)*OCTET_CYCLES);
+}
+
+static void _rxStart(void)
+{
+    state = (state == statusRX_AACK_ON) ? statusBUSY_RX_AACK : statusBUSY_RX;
+    rx_start_time = sim_now;
+    regs[REG__PHY_RSSI] &= ~MASK__PHY_RSSI__RX_CRC_VALID;
+    _updateDig2Pin(true); // The timestamp edge comes with the interrupt.
+    _raise(irqRX_START);
+    sim_arm(&frame_end, sim_now + _psduCycles(AIR_FRAME_LEN));
+}
+
+// This function runs the command that arrived while busy, if any.
+static void _runDeferred(void)
+{
+    if(deferred != cmdNOP)
+    {
+        AT86_Cmd_Enum cmd = deferred;
+        deferred = cmdNOP;
+        _command(cmd);
+    }
+}
+
+// This function fills the frame buffer with the frame of the other board. In RX_AACK_ON, the frame carries a MAC header addressed to us.
+static void _airFrame(bool mac)
+{
+    uint8_t header = 0;
+    fb[0] = AIR_FRAME_LEN;
+    if(mac) // Data frame, ACK request, PAN ID compression, short addresses
+    {
+        fb[1] = 0x61;
+        fb[2] = 0x88;
+        fb[3] = air_seq++;
+        fb[4] = regs[REG__PAN_ID_0];
+        fb[5] = regs[REG__PAN_ID_1];
+        fb[6] = regs[REG__SHORT_ADDR_0];
+        fb[7] = regs[REG__SHORT_ADDR_1];
+        fb[8] = AIR_SHORT_ADDR & 0xFF;
+        fb[9] = AIR_SHORT_ADDR >> 8;
+        header = MAC_HEADER_LEN;
+    }
+    fb[1+header] = AIR_ADDRESS;
+    memset(&fb[2+header], 0xFF, AIR_FRAME_LEN-1-header);
+}
+
+// This function ends the frame on the air and runs any command that arrived while busy. In the extended operating mode, an ACK exchange
+// follows if the frame requested one, and the state only changes once it is over.
+static void _frameEnd(void)
+{
+    bool ack = false; // Whether an ACK follows
+    if((state == statusBUSY_TX) || (state == statusBUSY_TX_ARET))
+    {
+        ++num_tx;
+        tx_cycles += (SHR_OCTETS+1U)*OCTET_CYCLES + _psduCycles(fb[0]) + T_TX_START + tx_backoff;
+        ack = (state == statusBUSY_TX_ARET) && (fb[1] & FCF_ACK_REQUEST);
+        tx_on_air = false;
+        if(tx_underrun) // Reported along with the end of the frame
+        {
+            ++num_underruns;
+            _raise(irqTRX_UR);
+        }
+        if(state == statusBUSY_TX)
+            state = statusPLL_ON;
+        else if(!ack)
+        {
+            regs[REG__TRX_STATE] = tracSUCCESS << SHIFT__TRX_STATE__TRAC_STATUS;
+            state = statusTX_ARET_ON;
+        }
+    }
+    else if((state == statusBUSY_RX) || (state == statusBUSY_RX_AACK))
+    {
+        ++num_rx;
+        rx_cycles += sim_now - rx_start_time;
+        ack = (state == statusBUSY_RX_AACK);
+        _airFrame(ack);
+        regs[REG__PHY_RSSI] |= MASK__PHY_RSSI__RX_CRC_VALID;
+        if(ack)
+            regs[REG__TRX_STATE] = tracSUCCESS << SHIFT__TRX_STATE__TRAC_STATUS;
+        else
+            state = statusRX_ON;
+        _updateDig2Pin(false);
+    }
+    if(ack)
+        sim_arm(&ack_end, sim_now + T_ACK_TURNAROUND + (SHR_OCTETS+1U)*OCTET_CYCLES + _psduCycles(ACK_OCTETS));
+    if(!ack || (state == statusBUSY_RX_AACK)) // A transmission only ends once its ACK has arrived
+        _raise(irqTRX_END);
+    if(!ack)
+        _runDeferred();
+}
+
+// This function ends the ACK of the frame that has just gone out (BUSY_TX_ARET) or come in (BUSY_RX_AACK).
+static void _ackEnd(void)
+{
+    ++num_acks;
+    if(state == statusBUSY_TX_ARET)
+    {
+        regs[REG__TRX_STATE] = tracSUCCESS << SHIFT__TRX_STATE__TRAC_STATUS;
+        regs[REG__XAH_CTRL_2] &= ~MASK__XAH_CTRL_2__ARET_FRAME_RETRIES; // Acknowledged the first time
+        state = statusTX_ARET_ON;
+        _raise(irqTRX_END);
+    }
+    else
+        state = statusRX_AACK_ON;
+    _runDeferred();
+}
+
+// This function returns the phase the PMU reports at the current time: a clean tone whose slope depends on the frequency.
+static uint8_t _pmuValue(void)
+{
+    if(!(regs[REG__TRX_CTRL_0] & MASK__TRX_CTRL_0__PMU_EN) || !_receiving())
+        return regs[REG__PHY_PMU_VALUE];
+    uint16_t freq = _freq();
+    uint32_t sample = (uint32_t) ((sim_now - rx_start_time) / PMU_PERIOD);
+    regs[REG__PHY_PMU_VALUE] = (uint8_t) (17U*freq + sample*(3U + (freq & 0x07)));
+    ++num_pmu_reads;
+    return regs[REG__PHY_PMU_VALUE];
+}
+
+// This function returns the value of a register as read over SPI, applying read side effects.
+static uint8_t _readReg(uint8_t address)
+{
+    uint8_t value;
+    switch(address)
+    {
+    case REG__TRX_STATUS:
+        return (regs[REG__TRX_STATUS] & ~MASK__TRX_STATUS__TRX_STATUS) | state;
+    case REG__TRX_STATE:
+        return regs[REG__TRX_STATE] & MASK__TRX_STATE__TRAC_STATUS;
+    case REG__IRQ_STATUS: // Cleared by reading
+        value = regs[REG__IRQ_STATUS];
+        regs[REG__IRQ_STATUS] = 0;
+        _updateIrqPin();
+        return value;
+    case REG__PHY_PMU_VALUE:
+        return _pmuValue();
+    default:
+        return regs[address];
+    }
+}
+
+// This function writes a register over SPI.
+static void _writeReg(uint8_t address, uint8_t value)
+{
+    switch(address)
+    {
+    case REG__TRX_STATUS:
+    case REG__IRQ_STATUS:
+    case REG__PART_NUM:
+    case REG__VERSION_NUM:
+    case REG__MAN_ID_0:
+    case REG__MAN_ID_1:
+    case REG__PHY_PMU_VALUE:
+        break;
+    case REG__TRX_STATE:
+        _command((AT86_Cmd_Enum) (value & MASK__TRX_STATE__TRX_CMD));
+        break;
+    case REG__IRQ_MASK:
+        regs[address] = value;
+        _updateIrqPin();
+        break;
+    case REG__PHY_CC_CCA: // CCA_REQUEST starts a measurement and always reads back as 0
+    case REG__CC_CTRL_0: // The PLL retunes as soon as any of the three registers changes the frequency.
+    case REG__CC_CTRL_1:
+    {
+        uint16_t freq = _freq();
+        regs[address] = (address == REG__PHY_CC_CCA) ? (value & ~MASK__PHY_CC_CCA__CCA_REQUEST) : value;
+        if((_freq() != freq) && _pllRunning())
+            _hop();
+        break;
+    }
+    case REG__PLL_CF: // Setting PLL_CF_START (or PLL_DCU_START) starts a calibration, and the bit reads back as 1 until it is over
+    case REG__PLL_DCU:
+        regs[address] = value;
+        if((address == REG__PLL_CF) && (value & MASK__PLL_CF__PLL_CF_START))
+            sim_arm(&pll_cal, sim_now + T_PLL_CF);
+        else if((address == REG__PLL_DCU) && (value & MASK__PLL_DCU__PLL_DCU_START) && !pll_cal.armed)
+            sim_arm(&pll_cal, sim_now + T_PLL_DCU);
+        break;
+    default:
+        regs[address] = value;
+        break;
+    }
+}
+
+// This function writes a byte of the frame buffer over SPI. Writing a PSDU byte of the frame being transmitted after it has gone on the air
+// is an underrun: the frame ends with TRX_UR as well as TRX_END.
+static void _writeFb(uint8_t address, uint8_t value)
+{
+    ++num_fb_bytes;
+    if(tx_on_air && (address != 0) && (sim_now >= tx_psdu_start + _psduCycles(address - 1U)))
+        tx_underrun = true;
+    fb[address] = value;
+}
+
+// This function returns the status byte the radio sends while the command byte is clocked in, selected by TRX_CTRL_1.SPI_CMD_MODE.
+static uint8_t _phyStatus(void)
+{
+    switch((regs[REG__TRX_CTRL_1] & MASK__TRX_CTRL_1__SPI_CMD_MODE) >> SHIFT__TRX_CTRL_1__SPI_CMD_MODE)
+    {
+    case 1:
+        return _readReg(REG__TRX_STATUS);
+    case 2:
+        return regs[REG__PHY_RSSI];
+    case 3:
+        return regs[REG__IRQ_STATUS];
+    default:
+        return 0x00;
+    }
+}
+
+// This function exchanges one byte of an SPI transaction.
+uint8_t at86_model_exchange(uint8_t mosi)
+{
+    if(!powered || (state == statusSLEEP)) // The SPI interface is off while asleep
+        return 0x00;
+    uint8_t idx = spi_idx++;
+    if(idx == 0)
+    {
+        spi_cmd = mosi;
+        spi_addr = mosi & 0x3F;
+        return _phyStatus();
+    }
+    if((spi_cmd & 0xC0) == 0x80) // Register read
+        return (idx == 1) ? _readReg(spi_addr) : 0x00;
+    if((spi_cmd & 0xC0) == 0xC0) // Register write
+    {
+        if(idx == 1)
+            _writeReg(spi_addr, mosi);
+        return 0x00;
+    }
+    if((spi_cmd & 0xE0) == 0x20) // Frame buffer read, starting with the PHR
+        return fb[(idx-1U) % FB_SIZE];
+    if((spi_cmd & 0xE0) == 0x60) // Frame buffer write, starting with the PHR
+    {
+        _writeFb((idx-1U) % FB_SIZE, mosi);
+        return 0x00;
+    }
+    if(idx == 1) // SRAM access: second byte is the address
+    {
+        spi_addr = mosi & 0x7F;
+        return 0x00;
+    }
+    uint8_t address = spi_addr;
+    spi_addr = (spi_addr + 1U) % FB_SIZE;
+    if((spi_cmd & 0xE0) == 0x00) // SRAM read
+        return fb[address];
+    _writeFb(address, mosi); // SRAM write
+    return 0x00;
+}
+
+// This function is called on every SS edge.
+void at86_model_select(bool selected)
+{
+    if(selected)
+        spi_idx = 0;
+}
+
+// This function follows the power, reset and SLP_TR lines.
+void at86_model_pinChanged(void)
+{
+    static bool attached = false;
+    if(!attached)
+    {
+        transition.fire = _transitionDone;
+        frame_start.fire = _frameStart;
+        rx_start.fire = _rxStart;
+        frame_end.fire = _frameEnd;
+        ack_end.fire = _ackEnd;
+        pll_lock.fire = _pllLock;
+        pll_cal.fire = _pllCal;
+        attached = true;
+    }
+    bool power = gpio_sim_outputHigh(AT86_PWR_PORT, AT86_PWR_PIN);
+    bool reset = !gpio_sim_outputHigh(AT86_RESET_PORT, AT86_RESET_PIN);
+    if(power && !powered) // Power-on reset
+    {
+        _reset();
+        state = statusP_ON;
+    }
+    powered = power;
+    if(powered && reset) // RESET low: registers back to reset values, radio in TRX_OFF
+    {
+        _reset();
+        state = statusTRX_OFF;
+    }
+    bool slp = gpio_sim_outputHigh(AT86_WAKEUP_PORT, AT86_WAKEUP_PIN);
+    if(powered && slp && !slp_tr && (state == statusTRX_OFF)) // SLP_TR rising edge in TRX_OFF: go to sleep, keeping the registers
+        state = statusSLEEP;
+    else if(powered && slp && !slp_tr && ((state == statusPLL_ON) || (state == statusTX_ARET_ON))) // SLP_TR rising edge in PLL_ON or TX_ARET_ON: transmit
+    {
+        ++num_pin_tx;
+        _startTx();
+    }
+    else if(powered && !slp && slp_tr && (state == statusSLEEP)) // SLP_TR falling edge: wake up
+        _goTo(statusTRX_OFF, T_SLEEP_TRX_OFF);
+    slp_tr = slp;
+    _updateIrqPin();
+    _updateDig2Pin(_receiving()); // Low again after a reset or power-down
+}
+
+// This function prints the radio statistics.
+void at86_model_report(void)
+{
+    fprintf(stderr, "sim: at86 %u state commands, %u frames sent (%.1f us on air), %u frames received (%.1f us on air)\n",
+            num_cmds, num_tx, sim_us(tx_cycles), num_rx, sim_us(rx_cycles));
+    fprintf(stderr, "sim: at86 %u IRQ edges, %u PMU reads during reception, %u transmissions started by SLP_TR, %u ACKs\n", num_irq_edges,
+            num_pmu_reads, num_pin_tx, num_acks);
+    fprintf(stderr, "sim: at86 %u frame buffer bytes written, %u transmissions underrun\n", num_fb_bytes, num_underruns);
+    fprintf(stderr, "sim: at86 %u frequency hops with the PLL running, %u center frequency calibrations\n", num_hops, num_cf_cals);
+}
@@ -0,0 +1,55 @@
+/*
+ * clock_sim.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// This file provides the clock, power and watchdog calls made by init(). The simulated MCU always runs at the clock rates init() selects.
+
+#include "sim.h"
+#include "pmm.h"
+#include "ucs.h"
+#include "wdt_a.h"
+
+void WDT_A_hold(uint16_t baseAddress)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+}
+
+bool PMM_setVCore(uint8_t level)
+{
+    (void) level;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    return STATUS_SUCCESS;
+}
+
+void UCS_initClockSignal(uint8_t selectedClockSignal, uint16_t clockSource, uint16_t clockSourceDivider)
+{
+    (void) selectedClockSignal;
+    (void) clockSource;
+    (void) clockSourceDivider;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+}
+
+void UCS_initFLLSettle(uint16_t fsystem, uint16_t ratio)
+{
+    (void) fsystem;
+    (void) ratio;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+}
+
+uint32_t UCS_getSMCLK(void)
+{
+    return SIM_MCLK_FREQ;
+}
+
+uint32_t UCS_getMCLK(void)
+{
+    return SIM_MCLK_FREQ;
+}
+
+uint32_t UCS_getACLK(void)
+{
+    return SIM_ACLK_FREQ;
+}
@@ -0,0 +1,244 @@
+/*
+ * dma_sim.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// This file simulates the three-channel DMA controller of the MSP430F5529. Peripherals report rising edges of their trigger flags with
+// dma_sim_trigger(); each enabled channel selecting that trigger then moves one unit a couple of MCLK cycles later, through the simulated bus
+// so that reading RXBUF or writing TXBUF has the same side effects as a CPU access. Single and repeated single transfer modes are modelled.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+#include "dma.h"
+
+#define DMA_CHANNELS      (3U)
+#define DMA_XFER_CYCLES   (2U) // Cycles per transfer once a trigger has been synchronised
+#define DMA_SIM_ADDR_SPAN (0x10000U) // Addresses below this are in the simulated memory map, anything else is a host pointer
+
+static struct
+{
+    uint16_t ctl; // DMAxCTL
+    uint8_t trigger; // DMAxTSEL
+    uintptr_t sa; // DMAxSA
+    uintptr_t da; // DMAxDA
+    uintptr_t src; // Address of the next unit to read
+    uintptr_t dst; // Address of the next unit to write
+    uint16_t size; // DMAxSZ as written by the firmware
+    uint16_t remaining; // Transfers left in the current block
+    bool requested; // A trigger has been seen and not yet serviced
+    uint32_t transfers; // Units moved, for the report
+} channels[DMA_CHANNELS];
+
+static sim_event_t service;
+
+// This function returns the channel index encoded in a DMA_CHANNEL_x value.
+static uint8_t _idx(uint8_t channelSelect)
+{
+    uint8_t idx = channelSelect >> 4;
+    if(idx >= DMA_CHANNELS)
+    {
+        fprintf(stderr, "sim: DMA channel 0x%02x does not exist\n", channelSelect);
+        sim_finish(EXIT_FAILURE);
+    }
+    return idx;
+}
+
+static uint8_t _read(uintptr_t address)
+{
+    if(address < DMA_SIM_ADDR_SPAN)
+        return sim_busRead8((uint16_t) address);
+    return *(volatile uint8_t *) address;
+}
+
+static void _write(uintptr_t address, uint8_t value)
+{
+    if(address < DMA_SIM_ADDR_SPAN)
+        sim_busWrite8((uint16_t) address, value);
+    else
+        *(volatile uint8_t *) address = value;
+}
+
+// This function returns the address step for a DMASRCINCR/DMADSTINCR field (already shifted to the source position).
+static int _step(uint16_t incr)
+{
+    if(incr == DMASRCINCR_3)
+        return 1;
+    if(incr == DMASRCINCR_2)
+        return -1;
+    return 0;
+}
+
+// This function performs every requested transfer, channel 0 first as on the device.
+static void _service(void)
+{
+    uint8_t idx;
+    for(idx=0; idx<DMA_CHANNELS; ++idx)
+    {
+        if(!channels[idx].requested)
+            continue;
+        channels[idx].requested = false;
+        if(!(channels[idx].ctl & DMAEN))
+            continue;
+        _write(channels[idx].dst, _read(channels[idx].src));
+        ++channels[idx].transfers;
+        channels[idx].src += _step(channels[idx].ctl & 0x0300);
+        channels[idx].dst += _step((channels[idx].ctl >> 2) & 0x0300);
+        if(--channels[idx].remaining == 0) // End of the block: addresses and size are reloaded, and a repeated channel stays enabled
+        {
+            if((channels[idx].ctl & DMADT_MASK) != DMADT_4)
+                channels[idx].ctl &= ~DMAEN;
+            channels[idx].ctl |= DMAIFG;
+            channels[idx].remaining = channels[idx].size;
+            channels[idx].src = channels[idx].sa;
+            channels[idx].dst = channels[idx].da;
+        }
+    }
+}
+
+// This function is called by a peripheral when one of its DMA trigger flags goes high.
+//  source: trigger number (DMA_TRIGGERSOURCE_x).
+void dma_sim_trigger(uint8_t source)
+{
+    uint8_t idx;
+    bool any = false;
+    for(idx=0; idx<DMA_CHANNELS; ++idx)
+    {
+        if((channels[idx].ctl & DMAEN) && (channels[idx].trigger == source))
+        {
+            channels[idx].requested = true;
+            any = true;
+        }
+    }
+    if(any && !service.armed)
+    {
+        service.fire = _service;
+        sim_arm(&service, sim_now + DMA_XFER_CYCLES);
+    }
+}
+
+// This function returns whether DMA_VECTOR is requested.
+bool dma_sim_pending(void)
+{
+    uint8_t idx;
+    for(idx=0; idx<DMA_CHANNELS; ++idx)
+        if((channels[idx].ctl & DMAIFG) && (channels[idx].ctl & DMAIE))
+            return true;
+    return false;
+}
+
+// This function prints the number of units each channel has moved.
+void dma_sim_report(void)
+{
+    uint8_t idx;
+    for(idx=0; idx<DMA_CHANNELS; ++idx)
+        if(channels[idx].transfers)
+            fprintf(stderr, "sim: dma channel %u moved %u bytes (trigger %u)\n", idx, channels[idx].transfers, channels[idx].trigger);
+}
+
+void DMA_init(DMA_initParam *param)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    uint8_t idx = _idx(param->channelSelect);
+    channels[idx].ctl = param->transferModeSelect | param->transferUnitSelect | param->triggerTypeSelect;
+    channels[idx].trigger = param->triggerSourceSelect;
+    channels[idx].size = param->transferSize;
+    channels[idx].remaining = param->transferSize;
+    channels[idx].requested = false;
+    if(((param->transferModeSelect & DMADT_MASK) != DMADT_0) && ((param->transferModeSelect & DMADT_MASK) != DMADT_4))
+    {
+        fprintf(stderr, "sim: only single and repeated single transfer DMA are simulated\n");
+        sim_finish(EXIT_FAILURE);
+    }
+}
+
+void DMA_setTransferSize(uint8_t channelSelect, uint16_t transferSize)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    uint8_t idx = _idx(channelSelect);
+    channels[idx].size = transferSize;
+    channels[idx].remaining = transferSize;
+}
+
+uint16_t DMA_getTransferSize(uint8_t channelSelect)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    return channels[_idx(channelSelect)].remaining;
+}
+
+void DMA_setSrcAddress(uint8_t channelSelect, uintptr_t srcAddress, uint16_t directionSelect)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    uint8_t idx = _idx(channelSelect);
+    channels[idx].sa = srcAddress;
+    channels[idx].src = srcAddress;
+    channels[idx].ctl = (channels[idx].ctl & ~0x0300) | directionSelect;
+}
+
+void DMA_setDstAddress(uint8_t channelSelect, uintptr_t dstAddress, uint16_t directionSelect)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    uint8_t idx = _idx(channelSelect);
+    channels[idx].da = dstAddress;
+    channels[idx].dst = dstAddress;
+    channels[idx].ctl = (channels[idx].ctl & ~DMADSTINCR_3) | (directionSelect << 2);
+}
+
+void DMA_enableTransfers(uint8_t channelSelect)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    uint8_t idx = _idx(channelSelect);
+    if(!(channels[idx].ctl & DMAEN)) // Enabling reloads the block from DMAxSA, DMAxDA and DMAxSZ
+    {
+        channels[idx].remaining = channels[idx].size;
+        channels[idx].src = channels[idx].sa;
+        channels[idx].dst = channels[idx].da;
+    }
+    channels[idx].ctl |= DMAEN;
+}
+
+void DMA_disableTransfers(uint8_t channelSelect)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    uint8_t idx = _idx(channelSelect);
+    channels[idx].ctl &= ~DMAEN;
+    channels[idx].requested = false;
+}
+
+void DMA_startTransfer(uint8_t channelSelect)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    uint8_t idx = _idx(channelSelect);
+    if(channels[idx].ctl & DMAEN)
+    {
+        channels[idx].requested = true;
+        service.fire = _service;
+        sim_arm(&service, sim_now + DMA_XFER_CYCLES);
+    }
+}
+
+void DMA_enableInterrupt(uint8_t channelSelect)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    channels[_idx(channelSelect)].ctl |= DMAIE;
+    sim_dispatch();
+}
+
+void DMA_disableInterrupt(uint8_t channelSelect)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    channels[_idx(channelSelect)].ctl &= ~DMAIE;
+}
+
+uint16_t DMA_getInterruptStatus(uint8_t channelSelect)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    return channels[_idx(channelSelect)].ctl & DMAIFG;
+}
+
+void DMA_clearInterrupt(uint8_t channelSelect)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    channels[_idx(channelSelect)].ctl &= ~DMAIFG;
+}
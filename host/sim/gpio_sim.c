@@ -0,0 +1,245 @@
+/*
+ * gpio_sim.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// This file simulates the MSP430 digital I/O ports. Output changes on the pins wired to the AT86RF233 are forwarded to the radio model, and the
+// radio drives the IRQ (and DIG) inputs back through gpio_sim_drivePin(). P2OUT is also mapped onto the simulated bus, for the DMA controller.
+// Edges on P1.1 to P1.5 reach the capture inputs of Timer_A0 while those pins are selected for it. Pins selected as peripheral outputs are
+// driven by the module instead of PxOUT; only the outputs of Timer_A0 (P1.1 to P1.5) and Timer_A2 (P2.3 to P2.5) are modelled.
+
+#include "sim.h"
+#include "gpio.h"
+#include "hal.h"
+
+#define NUM_PORTS (8U)
+
+typedef struct
+{
+    uint8_t out; // PxOUT
+    uint8_t dir; // PxDIR
+    uint8_t sel; // PxSEL
+    uint8_t in; // Level driven onto the pins from outside the MCU
+    uint8_t ie; // PxIE (ports 1 and 2 only)
+    uint8_t ifg; // PxIFG (ports 1 and 2 only)
+    uint8_t ies; // PxIES (ports 1 and 2 only)
+    uint8_t periph; // Level driven by the peripheral modules onto the pins selected for them
+} Port_t;
+
+static Port_t ports[NUM_PORTS+1]; // Indexed by GPIO_PORT_Px
+
+// This function returns the level of the pins of a port as seen from inside the MCU.
+static uint8_t _level(const Port_t * p)
+{
+    return (((p->out & ~p->sel) | (p->periph & p->sel)) & p->dir) | (p->in & ~p->dir);
+}
+
+// This function lets the rest of the board know which outputs of a port changed.
+//  before: level of the pins before the change.
+static void _notify(uint8_t port, uint8_t before)
+{
+    Port_t * p = &ports[port];
+    uint8_t changed = before ^ _level(p);
+    if(!changed)
+        return;
+    if((port == AT86_SS_PORT) && (changed & AT86_SS_PIN))
+        spi_sim_select(!(_level(p) & AT86_SS_PIN));
+    if(changed & ~((port == AT86_SS_PORT) ? AT86_SS_PIN : 0))
+        at86_model_pinChanged();
+}
+
+// This function updates the output latch of a port and lets the rest of the board know what changed.
+static void _update(uint8_t port, uint8_t out)
+{
+    uint8_t before = _level(&ports[port]);
+    ports[port].out = out;
+    _notify(port, before);
+}
+
+// These functions access P2OUT through the simulated bus.
+static uint8_t _readP2Out(void)
+{
+    return ports[GPIO_PORT_P2].out;
+}
+
+static void _writeP2Out(uint8_t value)
+{
+    _update(GPIO_PORT_P2, value);
+}
+
+// This function updates the output latch of a port on behalf of a driverlib call.
+static void _setOut(uint8_t port, uint8_t out)
+{
+    static bool mapped = false;
+    if(!mapped)
+    {
+        sim_mapIo(__MSP430_BASEADDRESS_PORT2_R__ + OFS_P2OUT, _readP2Out, _writeP2Out);
+        mapped = true;
+    }
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    _update(port, out);
+}
+
+void GPIO_setAsOutputPin(uint8_t selectedPort, uint16_t selectedPins)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    uint8_t before = _level(&ports[selectedPort]); // Taking a pin back from a peripheral can change its level.
+    ports[selectedPort].sel &= ~selectedPins;
+    ports[selectedPort].dir |= selectedPins;
+    _notify(selectedPort, before);
+}
+
+void GPIO_setAsInputPin(uint8_t selectedPort, uint16_t selectedPins)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    uint8_t before = _level(&ports[selectedPort]);
+    ports[selectedPort].sel &= ~selectedPins;
+    ports[selectedPort].dir &= ~selectedPins;
+    _notify(selectedPort, before);
+}
+
+void GPIO_setAsPeripheralModuleFunctionOutputPin(uint8_t selectedPort, uint16_t selectedPins)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    uint8_t before = _level(&ports[selectedPort]);
+    ports[selectedPort].sel |= selectedPins;
+    ports[selectedPort].dir |= selectedPins;
+    _notify(selectedPort, before);
+}
+
+void GPIO_setAsPeripheralModuleFunctionInputPin(uint8_t selectedPort, uint16_t selectedPins)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    ports[selectedPort].sel |= selectedPins;
+    ports[selectedPort].dir &= ~selectedPins;
+}
+
+void GPIO_setOutputHighOnPin(uint8_t selectedPort, uint16_t selectedPins)
+{
+    _setOut(selectedPort, ports[selectedPort].out | selectedPins);
+}
+
+void GPIO_setOutputLowOnPin(uint8_t selectedPort, uint16_t selectedPins)
+{
+    _setOut(selectedPort, ports[selectedPort].out & ~selectedPins);
+}
+
+void GPIO_toggleOutputOnPin(uint8_t selectedPort, uint16_t selectedPins)
+{
+    _setOut(selectedPort, ports[selectedPort].out ^ selectedPins);
+}
+
+uint8_t GPIO_getInputPinValue(uint8_t selectedPort, uint16_t selectedPins)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    return (_level(&ports[selectedPort]) & selectedPins) ? GPIO_INPUT_PIN_HIGH : GPIO_INPUT_PIN_LOW;
+}
+
+void GPIO_enableInterrupt(uint8_t selectedPort, uint16_t selectedPins)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    ports[selectedPort].ie |= selectedPins;
+    sim_dispatch();
+}
+
+void GPIO_disableInterrupt(uint8_t selectedPort, uint16_t selectedPins)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    ports[selectedPort].ie &= ~selectedPins;
+}
+
+uint16_t GPIO_getInterruptStatus(uint8_t selectedPort, uint16_t selectedPins)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    return ports[selectedPort].ifg & selectedPins;
+}
+
+void GPIO_clearInterrupt(uint8_t selectedPort, uint16_t selectedPins)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    ports[selectedPort].ifg &= ~selectedPins;
+}
+
+void GPIO_selectInterruptEdge(uint8_t selectedPort, uint16_t selectedPins, uint8_t edgeSelect)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    if(edgeSelect == GPIO_HIGH_TO_LOW_TRANSITION)
+        ports[selectedPort].ies |= selectedPins;
+    else
+        ports[selectedPort].ies &= ~selectedPins;
+}
+
+void GPIO_setDriveStrength(uint8_t selectedPort, uint16_t selectedPins, uint8_t driveStrength)
+{
+    (void) selectedPort;
+    (void) selectedPins;
+    (void) driveStrength;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+}
+
+// This function drives pins of a port from outside the MCU, setting interrupt flags on the selected edges.
+void gpio_sim_drivePin(uint8_t port, uint16_t pins, bool high)
+{
+    Port_t * p = &ports[port];
+    uint8_t before = p->in;
+    if(high)
+        p->in |= pins;
+    else
+        p->in &= ~pins;
+    uint8_t rising = ~before & p->in & ~p->dir;
+    uint8_t falling = before & ~p->in & ~p->dir;
+    if((port == GPIO_PORT_P1) || (port == GPIO_PORT_P2))
+        p->ifg |= (rising & ~p->ies) | (falling & p->ies);
+    if(port == GPIO_PORT_P1) // P1.1 to P1.5 are the CCInA inputs of CCR0 to CCR4 of Timer_A0 when selected for the timer
+    {
+        uint8_t n;
+        for(n=0; n<5; ++n)
+        {
+            uint8_t pin = GPIO_PIN1 << n;
+            if((p->sel & pin) && ((rising | falling) & pin))
+                timer_a_sim_input(0, n, high);
+        }
+    }
+}
+
+// This function drives the pin of a Timer_A output, as wired on the MSP430F5529: TA0.n is P1.(n+1) and TA2.n is P2.(n+3). It only
+// shows on the pin while the pin is selected for the timer.
+//  timer: index of the timer (0 for Timer_A0).
+//  n: index of the capture/compare register.
+//  high: new level of the output.
+void gpio_sim_timerOutput(uint8_t timer, uint8_t n, bool high)
+{
+    uint8_t port, pin;
+    if(timer == 0)
+    {
+        port = GPIO_PORT_P1;
+        pin = GPIO_PIN1 << n;
+    }
+    else if((timer == 2) && (n < 3))
+    {
+        port = GPIO_PORT_P2;
+        pin = GPIO_PIN3 << n;
+    }
+    else
+        return;
+    Port_t * p = &ports[port];
+    uint8_t before = _level(p);
+    if(high)
+        p->periph |= pin;
+    else
+        p->periph &= ~pin;
+    _notify(port, before);
+}
+
+// This function returns whether an output pin is currently driven high.
+bool gpio_sim_outputHigh(uint8_t port, uint16_t pin)
+{
+    return (_level(&ports[port]) & pin) != 0;
+}
+
+// This function returns whether PORT2_VECTOR is requested.
+bool gpio_sim_port2Pending(void)
+{
+    return (ports[GPIO_PORT_P2].ifg & ports[GPIO_PORT_P2].ie) != 0;
+}
@@ -0,0 +1,72 @@
+/*
+ * mpy32_sim.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// This file simulates the 32-bit hardware multiplier of the MSP430F5529. As on the device, writing the second operand starts the operation,
+// and the first operand and the kind of operation stay selected, so that several second operands may be multiplied by the same first one.
+// The result is available by the time the next driverlib call reads it.
+
+#include "sim.h"
+#include "mpy32.h"
+
+static uint8_t type = MPY32_MULTIPLY_UNSIGNED; // Kind of operation selected by the last write of the first operand
+static uint8_t one_bits = 16; // Width of the first operand
+static uint32_t one = 0; // First operand
+static uint64_t result = 0; // RES0 to RES3
+
+// This function returns an operand of a given width, sign-extended if the selected operation is signed.
+static int64_t _extend(uint32_t operand, uint8_t bits)
+{
+    if(!(type & MPY32_MULTIPLY_SIGNED))
+        return (int64_t) operand;
+    return (bits == 16) ? (int64_t) (int16_t) operand : (int64_t) (int32_t) operand;
+}
+
+// This function carries out the selected operation with a second operand.
+static void _multiply(uint32_t two, uint8_t two_bits)
+{
+    uint64_t product = (uint64_t) (_extend(one, one_bits)*_extend(two, two_bits));
+    result = (type & MPY32_MULTIPLYACCUMULATE_UNSIGNED) ? (result + product) : product;
+}
+
+void MPY32_setOperandOne16Bit(uint8_t multiplicationType, uint16_t operand)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    type = multiplicationType;
+    one_bits = 16;
+    one = operand;
+}
+
+void MPY32_setOperandOne32Bit(uint8_t multiplicationType, uint32_t operand)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    type = multiplicationType;
+    one_bits = 32;
+    one = operand;
+}
+
+void MPY32_setOperandTwo16Bit(uint16_t operand)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    _multiply(operand, 16);
+}
+
+void MPY32_setOperandTwo32Bit(uint32_t operand)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    _multiply(operand, 32);
+}
+
+uint64_t MPY32_getResult(void)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    return result;
+}
+
+void MPY32_preloadResult(uint64_t preload)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    result = preload;
+}
@@ -0,0 +1,346 @@
+/*
+ * sim.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// This file contains the core of the host simulator: the virtual clock, the event scheduler, interrupt dispatch and the simulated memory map.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+#include "msp430.h"
+
+#define SIM_MAX_EVENTS (32U) // Maximum number of distinct peripheral events
+#define SIM_MAX_SYNCS  (8U) // Maximum number of register ranges that need refreshing before access
+#define SIM_MAX_IOS    (8U) // Maximum number of registers with side effects on bus-master (DMA) access
+#define SIM_MAX_VECTORS (8U) // Maximum number of entries in sim_vectors
+#define SIM_ISR_CYCLES (11U) // Cycles to enter (6) and return from (5) an interrupt
+#define SIM_HWREG_CYCLES (3U) // Cycles charged for a firmware register access through HWREG (one absolute-mode instruction)
+
+sim_time_t sim_now = 0;
+uint8_t sim_mem[0x10000] __attribute__ ((aligned (2)));
+
+static sim_event_t * events[SIM_MAX_EVENTS]; // Every event that has ever been armed
+static uint8_t num_events = 0;
+static bool gie = false; // Global interrupt enable
+static bool in_isr = false; // Whether an interrupt handler is running
+static bool asleep = false; // Whether the CPU is in a low-power mode
+static sim_time_t sleep_cycles = 0; // Total time spent in low-power modes
+static sim_time_t isr_cycles = 0; // Total time spent in interrupt handlers, entry and return included
+static struct
+{
+    uint32_t count; // Times the interrupt was taken
+    sim_time_t cycles; // Time spent in its handler, entry and return included
+} isr_stats[SIM_MAX_VECTORS];
+
+static struct
+{
+    uint16_t base;
+    uint16_t size;
+    void (*sync)(uint16_t address);
+} syncs[SIM_MAX_SYNCS];
+static uint8_t num_syncs = 0;
+
+static struct
+{
+    uint16_t address;
+    uint8_t (*read)(void);
+    void (*write)(uint8_t value);
+} ios[SIM_MAX_IOS];
+static uint8_t num_ios = 0;
+static void (*pending_write)(uint8_t value) = NULL; // Write side effect of the last HWREG access, applied once the store has happened
+static uint16_t pending_address;
+
+static void _sync(uint16_t address);
+
+// This function schedules an event to fire at a given virtual time.
+void sim_arm(sim_event_t * ev, sim_time_t at)
+{
+    if(!ev->registered) // First use of this event: add it to the scheduler list
+    {
+        if(num_events == SIM_MAX_EVENTS)
+        {
+            fprintf(stderr, "sim: too many events\n");
+            exit(EXIT_FAILURE);
+        }
+        events[num_events++] = ev;
+        ev->registered = true;
+    }
+    ev->at = (at < sim_now) ? sim_now : at;
+    ev->armed = true;
+}
+
+// This function cancels a scheduled event.
+void sim_disarm(sim_event_t * ev)
+{
+    ev->armed = false;
+}
+
+// This function applies the side effect of a firmware store through HWREG. HWREG only hands out the address of the register, so the store
+// itself happens after sim_hwreg8/16 returns; its effect is applied at the next point the firmware re-enters the simulator.
+static void _commit(void)
+{
+    if(pending_write != NULL)
+    {
+        void (*write)(uint8_t value) = pending_write;
+        pending_write = NULL;
+        write(sim_mem[pending_address]);
+    }
+}
+
+// This function returns the earliest armed event due no later than the given time, or NULL.
+static sim_event_t * _nextEvent(sim_time_t until)
+{
+    sim_event_t * next = NULL;
+    uint8_t idx;
+    for(idx=0; idx<num_events; ++idx)
+    {
+        sim_event_t * ev = events[idx];
+        if(ev->armed && (ev->at <= until) && ((next == NULL) || (ev->at < next->at)))
+            next = ev;
+    }
+    return next;
+}
+
+// This function advances virtual time, firing every event it passes and taking interrupts after each one.
+//  cycles: number of MCLK cycles the CPU spends.
+void sim_spend(uint32_t cycles)
+{
+    _commit();
+    sim_time_t target = sim_now + cycles;
+    sim_event_t * ev;
+    while((ev = _nextEvent(target)) != NULL)
+    {
+        if(ev->at > sim_now)
+            sim_now = ev->at;
+        ev->armed = false;
+        ev->fire();
+        sim_dispatch();
+    }
+    if(sim_now < target)
+        sim_now = target;
+    sim_dispatch();
+}
+
+// This function runs the handler of every pending interrupt, highest priority first, as long as interrupts are enabled.
+void sim_dispatch(void)
+{
+    while(gie && !in_isr)
+    {
+        uint8_t idx;
+        for(idx=0; idx<sim_num_vectors; ++idx)
+            if((sim_vectors[idx].isr != NULL) && sim_vectors[idx].pending())
+                break;
+        if(idx == sim_num_vectors) // Nothing pending
+            return;
+        in_isr = true; // The CPU clears GIE on entry and restores it on return
+        gie = false;
+        if(sim_vectors[idx].taken != NULL)
+            sim_vectors[idx].taken();
+        sim_time_t start = sim_now;
+        sim_spend(SIM_ISR_CYCLES);
+        sim_vectors[idx].isr();
+        isr_cycles += sim_now - start;
+        if(idx < SIM_MAX_VECTORS)
+        {
+            ++isr_stats[idx].count;
+            isr_stats[idx].cycles += sim_now - start;
+        }
+        in_isr = false;
+        gie = true;
+    }
+}
+
+// This function implements __enable_interrupt() and __disable_interrupt().
+void sim_setGie(bool enable)
+{
+    _commit();
+    gie = enable;
+    if(enable)
+        sim_dispatch();
+}
+
+// This function returns the status register bits the simulator keeps track of, for __get_interrupt_state().
+uint16_t sim_getSr(void)
+{
+    return (gie ? GIE : 0) | (asleep ? CPUOFF : 0);
+}
+
+// This function implements __bis_SR_register(). Setting CPUOFF stops the CPU: virtual time runs from event to event until an interrupt
+// handler calls __bic_SR_register_on_exit() with CPUOFF.
+void sim_bisSr(uint16_t bits)
+{
+    if(bits & CPUOFF)
+        asleep = true;
+    if(bits & GIE)
+        sim_setGie(true);
+    while(asleep)
+    {
+        sim_event_t * ev = _nextEvent(UINT64_MAX);
+        if(ev == NULL)
+        {
+            fprintf(stderr, "sim: CPU sleeps with nothing left to wake it\n");
+            sim_finish(EXIT_FAILURE);
+        }
+        sim_time_t start = sim_now;
+        sim_spend((uint32_t)(ev->at - sim_now));
+        sleep_cycles += sim_now - start;
+    }
+}
+
+// This function implements __bic_SR_register_on_exit(), which interrupt handlers use to wake the CPU.
+void sim_bicSrOnExit(uint16_t bits)
+{
+    if(bits & CPUOFF)
+        asleep = false;
+}
+
+// This function registers a callback that brings a register range up to date before the firmware reads or writes it through HWREG.
+void sim_mapSync(uint16_t base, uint16_t size, void (*sync)(uint16_t address))
+{
+    if(num_syncs == SIM_MAX_SYNCS)
+    {
+        fprintf(stderr, "sim: too many register syncs\n");
+        exit(EXIT_FAILURE);
+    }
+    syncs[num_syncs].base = base;
+    syncs[num_syncs].size = size;
+    syncs[num_syncs].sync = sync;
+    ++num_syncs;
+}
+
+// This function registers the side effects of a register, such as a receive buffer whose flag is cleared on read or a transmit buffer that
+// starts a transfer when written. They apply to DMA accesses and to firmware accesses through HWREG8; since HWREG cannot tell a load from a
+// store, a register given a write handler is assumed to be only ever written by the firmware, and one given a read handler only ever read.
+// Registers without a handler behave as plain memory.
+void sim_mapIo(uint16_t address, uint8_t (*read)(void), void (*write)(uint8_t value))
+{
+    if(num_ios == SIM_MAX_IOS)
+    {
+        fprintf(stderr, "sim: too many bus registers\n");
+        exit(EXIT_FAILURE);
+    }
+    ios[num_ios].address = address;
+    ios[num_ios].read = read;
+    ios[num_ios].write = write;
+    ++num_ios;
+}
+
+// These functions carry out a byte access by a bus master other than the CPU.
+uint8_t sim_busRead8(uint16_t address)
+{
+    uint8_t idx;
+    for(idx=0; idx<num_ios; ++idx)
+        if((ios[idx].address == address) && (ios[idx].read != NULL))
+            return ios[idx].read();
+    _sync(address);
+    return sim_mem[address];
+}
+
+void sim_busWrite8(uint16_t address, uint8_t value)
+{
+    uint8_t idx;
+    for(idx=0; idx<num_ios; ++idx)
+    {
+        if((ios[idx].address == address) && (ios[idx].write != NULL))
+        {
+            ios[idx].write(value);
+            return;
+        }
+    }
+    _sync(address);
+    sim_mem[address] = value;
+}
+
+// This function prepares a firmware access through HWREG: any register side effect is started, and the register is brought up to date.
+static void _access(uint16_t address)
+{
+    sim_spend(SIM_HWREG_CYCLES);
+    uint8_t idx;
+    for(idx=0; idx<num_ios; ++idx)
+    {
+        if(ios[idx].address != address)
+            continue;
+        if(ios[idx].read != NULL)
+            sim_mem[address] = ios[idx].read();
+        if(ios[idx].write != NULL)
+        {
+            pending_write = ios[idx].write;
+            pending_address = address;
+        }
+    }
+    _sync(address);
+}
+
+// This function refreshes any simulated register backing the given address.
+static void _sync(uint16_t address)
+{
+    uint8_t idx;
+    for(idx=0; idx<num_syncs; ++idx)
+        if((address >= syncs[idx].base) && (address < syncs[idx].base + syncs[idx].size))
+            syncs[idx].sync(address);
+}
+
+// These functions back the HWREG8 and HWREG16 macros.
+volatile uint8_t * sim_hwreg8(uint16_t address)
+{
+    _access(address);
+    return &sim_mem[address];
+}
+
+volatile uint16_t * sim_hwreg16(uint16_t address)
+{
+    _access(address);
+    return (volatile uint16_t *) &sim_mem[address & ~1U];
+}
+
+// This function converts cycles to microseconds.
+double sim_us(sim_time_t cycles)
+{
+    return (double) cycles / (SIM_MCLK_FREQ/1000000UL);
+}
+
+// This function prints the statistics collected by each model and ends the simulation.
+void sim_finish(int status)
+{
+    fflush(stdout);
+    fprintf(stderr, "sim: %.1f us of virtual time, %.1f us of it with the CPU asleep, %.1f us in interrupt handlers\n", sim_us(sim_now),
+            sim_us(sleep_cycles), sim_us(isr_cycles));
+    uint8_t idx;
+    for(idx=0; (idx<sim_num_vectors) && (idx<SIM_MAX_VECTORS); ++idx)
+        if(isr_stats[idx].count)
+            fprintf(stderr, "sim: %-16s taken %6u times, %9.1f us\n", sim_vectors[idx].name, isr_stats[idx].count, sim_us(isr_stats[idx].cycles));
+    uart_sim_report();
+    usb_sim_report();
+    spi_sim_report();
+    dma_sim_report();
+    timer_a_sim_report();
+    at86_model_report();
+    exit(status);
+}
+
+// This function is called by gcc on entry to every firmware function (the firmware is built with -finstrument-functions). It charges the call
+// against virtual time, which is what lets polling loops such as while(VCOM_isTransmitting()) make progress.
+void __attribute__ ((no_instrument_function)) __cyg_profile_func_enter(void * fn, void * site)
+{
+    (void) fn;
+    (void) site;
+    sim_spend(SIM_CALL_CYCLES);
+}
+
+void __attribute__ ((no_instrument_function)) __cyg_profile_func_exit(void * fn, void * site)
+{
+    (void) fn;
+    (void) site;
+}
+
+// Implementation of the firmware assert function. On the board a failed assertion blinks the LEDs forever; here it ends the simulation.
+void assert(bool condition)
+{
+    if(!condition)
+    {
+        fprintf(stderr, "sim: firmware assertion failed (called from %p)\n", __builtin_return_address(0));
+        sim_finish(EXIT_FAILURE);
+    }
+}
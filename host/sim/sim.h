@@ -0,0 +1,88 @@
+/*
+ * sim.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// Declarations shared by the simulated MSP430 peripherals and the AT86RF233 model used by the host build.
+// The simulation runs in virtual time counted in MCLK cycles. Firmware code costs SIM_CALL_CYCLES per function call (the firmware objects are
+// built with -finstrument-functions), every simulated driverlib call costs SIM_DRIVERLIB_CYCLES, and peripherals schedule events (an SPI byte
+// finishing, a UART character arriving, the radio changing state) that fire as virtual time passes them.
+
+#ifndef HOST_SIM_H_
+#define HOST_SIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SIM_MCLK_FREQ        (20000000UL) // Frequency (Hz) of MCLK and SMCLK after init() has configured the FLL
+#define SIM_ACLK_FREQ        (32768UL) // Frequency (Hz) of ACLK (REFO)
+#define SIM_CALL_CYCLES      (24U) // Cycles charged for each firmware function call (call, prologue and epilogue at -O0)
+#define SIM_DRIVERLIB_CYCLES (16U) // Cycles charged for each driverlib call
+
+#define SIM_US(us) ((sim_time_t)(us)*(SIM_MCLK_FREQ/1000000UL)) // Convert microseconds to cycles
+
+typedef uint64_t sim_time_t; // Virtual time in MCLK cycles
+
+typedef struct sim_event // Something a peripheral wants to happen at a point in virtual time
+{
+    sim_time_t at; // Time at which the event fires
+    bool armed; // Whether the event is waiting to fire
+    bool registered; // Whether the event is in the scheduler list
+    void (*fire)(void); // Called once virtual time reaches the event
+} sim_event_t;
+
+typedef struct sim_vector // Entry of the simulated interrupt vector table, in priority order
+{
+    const char * name;
+    bool (*pending)(void); // Whether the peripheral is requesting this interrupt
+    void (*isr)(void); // Firmware interrupt handler
+    void (*taken)(void); // Clears flags the CPU clears when it takes the interrupt, or NULL
+} sim_vector_t;
+
+extern sim_time_t sim_now; // Current virtual time
+extern uint8_t sim_mem[0x10000]; // Backing store of the simulated memory map
+
+void sim_spend(uint32_t cycles); // Advance virtual time, firing events and taking interrupts on the way
+void sim_arm(sim_event_t * ev, sim_time_t at); // Schedule an event
+void sim_disarm(sim_event_t * ev); // Cancel a scheduled event
+void sim_dispatch(void); // Take pending interrupts, if interrupts are enabled
+void sim_mapSync(uint16_t base, uint16_t size, void (*sync)(uint16_t address)); // Refresh a register range before the firmware accesses it
+void sim_mapIo(uint16_t address, uint8_t (*read)(void), void (*write)(uint8_t value)); // Side effects of a register on DMA access
+uint8_t sim_busRead8(uint16_t address); // Byte access by the DMA controller
+void sim_busWrite8(uint16_t address, uint8_t value);
+double sim_us(sim_time_t cycles); // Convert cycles to microseconds
+void sim_finish(int status); // Print the statistics of every model and end the simulation
+
+extern const sim_vector_t sim_vectors[]; // Interrupt vector table (vectors.c)
+extern const uint8_t sim_num_vectors;
+
+// Hooks between simulated peripherals
+void    gpio_sim_drivePin(uint8_t port, uint16_t pins, bool high); // Drive an input pin from outside the MCU
+bool    gpio_sim_outputHigh(uint8_t port, uint16_t pin); // Level of an output pin
+bool    gpio_sim_port2Pending(void);
+void    gpio_sim_timerOutput(uint8_t timer, uint8_t n, bool high); // The output unit of a Timer_A register changed level
+uint8_t spi_sim_exchange(uint8_t mosi); // Exchange one byte with the device on the SPI bus
+void    spi_sim_select(bool selected); // SS edge seen by the SPI statistics and the radio
+void    dma_sim_trigger(uint8_t source); // Rising edge of a DMA trigger flag
+bool    dma_sim_pending(void);
+void    dma_sim_report(void);
+bool    timer_a_sim_cc0Pending(void);
+void    timer_a_sim_cc0Taken(void);
+bool    timer_a_sim_a0Pending(void);
+void    timer_a_sim_input(uint8_t timer, uint8_t n, bool high); // A capture input of a timer changed level
+void    timer_a_sim_report(void);
+bool    uart_sim_pending(void);
+bool    uart_sim_idle(void);
+void    uart_sim_report(void);
+bool    usb_sim_pending(void);
+void    usb_sim_isr(void); // Interrupt handler of the USB stack stand-in
+void    usb_sim_report(void);
+void    spi_sim_report(void);
+
+void    at86_model_pinChanged(void); // Power, reset, SS or SLP_TR changed
+uint8_t at86_model_exchange(uint8_t mosi); // One SPI byte while SS is low
+void    at86_model_select(bool selected); // SS edge
+void    at86_model_report(void);
+
+#endif /* HOST_SIM_H_ */
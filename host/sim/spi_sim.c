@@ -0,0 +1,276 @@
+/*
+ * spi_sim.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// This file simulates USCI_B0 in SPI master mode, including its double-buffered transmitter, and collects per-operation statistics on the
+// SPI transactions the firmware makes with the AT86RF233 (one transaction per SS low period).
+
+#include <stdio.h>
+#include <stddef.h>
+#include "sim.h"
+#include "usci_b_spi.h"
+
+#define UCB_IE    HWREG_SIM(USCI_B0_BASE + OFS_UCBxIE)
+#define UCB_IFG   HWREG_SIM(USCI_B0_BASE + OFS_UCBxIFG)
+#define UCB_STAT  HWREG_SIM(USCI_B0_BASE + OFS_UCBxSTAT)
+#define UCB_RXBUF HWREG_SIM(USCI_B0_BASE + OFS_UCBxRXBUF)
+#define UCB_TXBUF HWREG_SIM(USCI_B0_BASE + OFS_UCBxTXBUF)
+#define HWREG_SIM(x) (sim_mem[(x)])
+
+#define DMA_TRIGGER_UCB0RXIFG (18U)
+#define DMA_TRIGGER_UCB0TXIFG (19U)
+
+typedef enum // Kinds of AT86RF233 SPI access, decoded from the command byte
+{
+    opREG_READ,
+    opREG_WRITE,
+    opFB_READ,
+    opFB_WRITE,
+    opSRAM_READ,
+    opSRAM_WRITE,
+    opSTATUS,
+    opUNKNOWN,
+    opCOUNT
+} Op_Enum;
+
+static const char * const op_names[opCOUNT] = {"REG_read", "REG_write", "FB_read", "FB_write", "SRAM_read", "SRAM_write", "status", "(none)"};
+
+static struct
+{
+    uint32_t count; // Number of transactions
+    uint32_t bytes; // Bytes exchanged, including the command byte
+    sim_time_t cycles; // Total time SS was held low
+    sim_time_t max_cycles; // Longest transaction
+} stats[opCOUNT];
+
+static uint32_t byte_cycles = 8; // Cycles per SPI byte, set from the prescaler
+static bool shifting = false; // Whether the shift register is busy
+static bool tx_pending = false; // Whether TXBUF holds a byte waiting for the shift register
+static uint8_t shift_value; // Byte in the shift register
+static bool selected = false; // SS level (true = low)
+static sim_time_t select_time; // When SS went low
+static uint32_t transaction_bytes; // Bytes exchanged in the current transaction
+static Op_Enum transaction_op; // Kind of the current transaction
+static sim_event_t shift_done;
+static uint32_t overruns = 0; // Received bytes lost because RXBUF was not read in time
+
+// This function decodes the command byte of a transaction.
+static Op_Enum _decode(uint8_t cmd)
+{
+    if((cmd & 0xC0) == 0x80)
+        return opREG_READ;
+    if((cmd & 0xC0) == 0xC0)
+        return opREG_WRITE;
+    if((cmd & 0xE0) == 0x20)
+        return opFB_READ;
+    if((cmd & 0xE0) == 0x60)
+        return opFB_WRITE;
+    if((cmd & 0xE0) == 0x00)
+        return opSRAM_READ;
+    return opSRAM_WRITE;
+}
+
+// This function moves a byte into the shift register.
+static void _startShift(uint8_t value)
+{
+    shifting = true;
+    shift_value = value;
+    UCB_STAT |= UCBUSY;
+    sim_arm(&shift_done, sim_now + byte_cycles);
+    if(!(UCB_IFG & UCTXIFG)) // TXBUF is free again
+    {
+        UCB_IFG |= UCTXIFG;
+        dma_sim_trigger(DMA_TRIGGER_UCB0TXIFG);
+    }
+}
+
+// This function is called when the shift register has clocked out a byte and clocked in the reply.
+static void _shiftDone(void)
+{
+    uint8_t miso = spi_sim_exchange(shift_value);
+    bool overrun = (UCB_IFG & UCRXIFG) != 0; // Previous byte was never read
+    if(overrun)
+    {
+        UCB_STAT |= UCOE;
+        ++overruns;
+    }
+    UCB_RXBUF = miso;
+    UCB_IFG |= UCRXIFG;
+    shifting = false;
+    UCB_STAT &= ~UCBUSY;
+    if(tx_pending)
+    {
+        tx_pending = false;
+        _startShift(UCB_TXBUF);
+    }
+    if(!overrun)
+        dma_sim_trigger(DMA_TRIGGER_UCB0RXIFG);
+}
+
+// This function writes TXBUF, from the CPU or from a DMA channel.
+static void _writeTxbuf(uint8_t value)
+{
+    UCB_TXBUF = value;
+    UCB_IFG &= ~UCTXIFG;
+    if(!shifting)
+        _startShift(value);
+    else
+        tx_pending = true; // Overwrites any byte already waiting, as the hardware would
+}
+
+// This function reads RXBUF, from the CPU or from a DMA channel.
+static uint8_t _readRxbuf(void)
+{
+    UCB_IFG &= ~UCRXIFG;
+    UCB_STAT &= ~UCOE;
+    return UCB_RXBUF;
+}
+
+bool USCI_B_SPI_initMaster(uint16_t baseAddress, USCI_B_SPI_initMasterParam *param)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    shift_done.fire = _shiftDone;
+    static bool mapped = false;
+    if(!mapped)
+    {
+        sim_mapIo(USCI_B0_BASE + OFS_UCBxTXBUF, NULL, _writeTxbuf);
+        sim_mapIo(USCI_B0_BASE + OFS_UCBxRXBUF, _readRxbuf, NULL);
+        mapped = true;
+    }
+    uint32_t prescaler = param->clockSourceFrequency / param->desiredSpiClock;
+    if(prescaler == 0)
+        prescaler = 1;
+    byte_cycles = 8U * prescaler * (SIM_MCLK_FREQ / param->clockSourceFrequency);
+    UCB_IE = 0;
+    UCB_IFG = UCTXIFG; // Reset state: TXBUF empty
+    UCB_STAT = 0;
+    return STATUS_SUCCESS;
+}
+
+void USCI_B_SPI_enable(uint16_t baseAddress)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+}
+
+void USCI_B_SPI_disable(uint16_t baseAddress)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+}
+
+void USCI_B_SPI_transmitData(uint16_t baseAddress, uint8_t transmitData)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    _writeTxbuf(transmitData);
+}
+
+uint8_t USCI_B_SPI_receiveData(uint16_t baseAddress)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    return _readRxbuf();
+}
+
+void USCI_B_SPI_enableInterrupt(uint16_t baseAddress, uint8_t mask)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    UCB_IE |= mask;
+}
+
+void USCI_B_SPI_disableInterrupt(uint16_t baseAddress, uint8_t mask)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    UCB_IE &= ~mask;
+}
+
+uint8_t USCI_B_SPI_getInterruptStatus(uint16_t baseAddress, uint8_t mask)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    return UCB_IFG & mask;
+}
+
+void USCI_B_SPI_clearInterrupt(uint16_t baseAddress, uint8_t mask)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    UCB_IFG &= ~mask;
+}
+
+uint32_t USCI_B_SPI_getReceiveBufferAddressForDMA(uint16_t baseAddress)
+{
+    return baseAddress + OFS_UCBxRXBUF;
+}
+
+uint32_t USCI_B_SPI_getTransmitBufferAddressForDMA(uint16_t baseAddress)
+{
+    return baseAddress + OFS_UCBxTXBUF;
+}
+
+uint8_t USCI_B_SPI_isBusy(uint16_t baseAddress)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    return UCB_STAT & UCBUSY;
+}
+
+// This function exchanges one byte with the device on the bus. Only the AT86RF233 is attached; with SS high MISO floats low.
+uint8_t spi_sim_exchange(uint8_t mosi)
+{
+    if(!selected)
+        return 0x00;
+    if(transaction_bytes == 0)
+        transaction_op = _decode(mosi);
+    ++transaction_bytes;
+    return at86_model_exchange(mosi);
+}
+
+// This function is called on every SS edge.
+//  select: true when SS goes low.
+void spi_sim_select(bool select)
+{
+    if(select == selected)
+        return;
+    selected = select;
+    if(select)
+    {
+        select_time = sim_now;
+        transaction_bytes = 0;
+        transaction_op = opUNKNOWN;
+    }
+    else
+    {
+        sim_time_t duration = sim_now - select_time;
+        if((transaction_op == opREG_READ) && (transaction_bytes == 1)) // Aborted after the PHY_STATUS byte
+            transaction_op = opSTATUS;
+        stats[transaction_op].count += 1;
+        stats[transaction_op].bytes += transaction_bytes;
+        stats[transaction_op].cycles += duration;
+        if(duration > stats[transaction_op].max_cycles)
+            stats[transaction_op].max_cycles = duration;
+    }
+    at86_model_select(select);
+}
+
+// This function prints the SPI statistics for each kind of transaction.
+void spi_sim_report(void)
+{
+    fprintf(stderr, "sim: spi %-10s %8s %9s %10s %10s %12s\n", "operation", "count", "bytes", "avg us", "max us", "bytes/s");
+    uint8_t op;
+    for(op=0; op<opCOUNT; ++op)
+    {
+        if(stats[op].count == 0)
+            continue;
+        double total_us = sim_us(stats[op].cycles);
+        fprintf(stderr, "sim: spi %-10s %8u %9u %10.2f %10.2f %12.0f\n", op_names[op], stats[op].count, stats[op].bytes,
+                total_us/stats[op].count, sim_us(stats[op].max_cycles), (total_us > 0) ? (1e6*stats[op].bytes/total_us) : 0.0);
+    }
+    fprintf(stderr, "sim: spi %u receive overruns, %.0f bytes/s line rate\n", overruns, 1e6/sim_us(byte_cycles));
+}
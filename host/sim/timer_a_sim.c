@@ -0,0 +1,513 @@
+/*
+ * timer_a_sim.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// This file simulates Timer_A0, Timer_A1 and Timer_A2 in continuous, up and up/down mode with their capture/compare registers (five on
+// Timer_A0, three on the others) in compare or capture mode. The count is computed from virtual time whenever it is read, so TAxR can also be read directly through HWREG16, and each
+// compare register schedules the event of the count reaching it. Compare events of CCR0 and CCR2 are DMA triggers; the DMA controller
+// clears the flag when it responds, which the model does not need to track since triggers are edges. CCR0 of Timer_A0 requests
+// TIMER0_A0_VECTOR, whose flag the CPU clears when it takes the interrupt. The overflow flag (TAIFG) of Timer_A0 requests TIMER0_A1_VECTOR,
+// and stays set until the firmware clears it; it is only tracked while its interrupt is enabled. So do the flags of its other registers.
+// The other timers have no interrupt handlers.
+// The output unit of a register in compare mode follows OUT in output mode 0, and is set (mode 1) or reset (mode 5) when the count reaches
+// the register; the other modes are not modelled. Its level reaches the pin of the output through gpio_sim.c.
+// A register in capture mode copies the count when its CCInA input, driven through gpio_sim.c by the pin the register is selected on, has
+// the chosen edge. The capture is taken at once, as if the input were synchronized to the timer clock.
+
+#include <stdio.h>
+#include "sim.h"
+#include "timer_a.h"
+
+#define NUM_TIMERS (3U) // Timers simulated
+#define NUM_CCR    (5U) // Capture/compare registers simulated on Timer_A0; the others have the first three
+#define NO_TRIGGER (0U) // DMA_TRIGGERSOURCE_0 is DMAREQ, which no compare register drives
+
+typedef struct
+{
+    uint16_t base; // TIMER_Ax_BASE
+    uint8_t num_ccr; // Capture/compare registers of the timer
+    uint8_t triggers[NUM_CCR]; // DMA trigger of each compare register
+    uint16_t mode; // TIMER_A_xxx_MODE
+    uint32_t clock_freq; // Frequency of the selected clock source after the divider
+    sim_time_t sync_time; // Time at which the count was last brought up to date
+    uint32_t position; // Timer clock edges since the count last left 0 counting up, modulo the length of a cycle
+    uint16_t ccr[NUM_CCR]; // TAxCCRn
+    uint16_t cctl[NUM_CCR]; // TAxCCTLn (CM, CCIS, SCS, CAP, OUTMOD, CCIE, OUT, COV and CCIFG)
+    bool outputs[NUM_CCR]; // Level of the output unit of each register
+    uint16_t ctl; // TAxCTL (TAIE and TAIFG)
+    sim_event_t compare[NUM_CCR]; // Count reaching TAxCCRn
+    sim_event_t overflow; // Count returning to 0, while TAIE is set
+    uint32_t num_compares[NUM_CCR]; // Compare events per register
+    uint32_t num_captures[NUM_CCR]; // Captures per register
+    uint32_t num_overflows; // Overflow events
+} Timer_t;
+
+static Timer_t timers[NUM_TIMERS] =
+{
+    {.base = TIMER_A0_BASE, .num_ccr = 5, .triggers = {1, NO_TRIGGER, 2, NO_TRIGGER, NO_TRIGGER}, .mode = TIMER_A_STOP_MODE, .clock_freq = SIM_MCLK_FREQ},
+    {.base = TIMER_A1_BASE, .num_ccr = 3, .triggers = {3, NO_TRIGGER, 4}, .mode = TIMER_A_STOP_MODE, .clock_freq = SIM_MCLK_FREQ},
+    {.base = TIMER_A2_BASE, .num_ccr = 3, .triggers = {5, NO_TRIGGER, 6}, .mode = TIMER_A_STOP_MODE, .clock_freq = SIM_MCLK_FREQ},
+};
+
+// This function returns the timer at a base address.
+static Timer_t * _timer(uint16_t baseAddress)
+{
+    uint8_t idx;
+    for(idx=1; idx<NUM_TIMERS; ++idx)
+        if(timers[idx].base == baseAddress)
+            return &timers[idx];
+    return &timers[0];
+}
+
+// This function returns the number of timer clock edges between reset and a point in virtual time.
+static uint64_t _ticks(const Timer_t * t, sim_time_t time)
+{
+    return (time * t->clock_freq) / SIM_MCLK_FREQ;
+}
+
+// This function returns the number of timer clock edges in one cycle of the count.
+static uint32_t _cycle(const Timer_t * t)
+{
+    if(t->mode == TIMER_A_UP_MODE)
+        return (uint32_t) t->ccr[0] + 1U;
+    if(t->mode == TIMER_A_UPDOWN_MODE)
+        return (t->ccr[0] != 0) ? 2U * t->ccr[0] : 1U;
+    return 0x10000U;
+}
+
+// This function returns the count at a position in the cycle.
+static uint16_t _count(const Timer_t * t, uint32_t position)
+{
+    if((t->mode == TIMER_A_UPDOWN_MODE) && (position > t->ccr[0])) // Counting down
+        return (uint16_t) (2U * t->ccr[0] - position);
+    return (uint16_t) position;
+}
+
+// This function brings a timer's position, and its TAxR, up to date with virtual time.
+static void _advance(Timer_t * t)
+{
+    if(t->mode != TIMER_A_STOP_MODE)
+        t->position = (uint32_t) ((t->position + _ticks(t, sim_now) - _ticks(t, t->sync_time)) % _cycle(t));
+    t->sync_time = sim_now;
+    *(uint16_t *) &sim_mem[t->base + OFS_TAxR] = _count(t, t->position);
+}
+
+// This function brings TAxR up to date before the firmware reads it.
+static void _sync(uint16_t address)
+{
+    _advance(_timer(address & ~(uint16_t) 0x003F));
+}
+
+// This function returns the timer clock edges from one position in the cycle to the next time the count passes through a compare value.
+static uint32_t _distance(const Timer_t * t, uint32_t position, uint16_t value)
+{
+    uint32_t cycle = _cycle(t);
+    uint32_t targets[2] = {value, cycle - value}; // Up and (in up/down mode) down crossing
+    uint8_t num_targets = (t->mode == TIMER_A_UPDOWN_MODE) ? 2 : 1;
+    uint32_t best = 0;
+    uint8_t idx;
+    for(idx=0; idx<num_targets; ++idx)
+    {
+        if(targets[idx] >= cycle) // The count never gets there
+            continue;
+        uint32_t distance = (targets[idx] + cycle - position) % cycle;
+        if(distance == 0) // Equal right now: the flag was set when it got there, next time is a full turn away
+            distance = cycle;
+        if((best == 0) || (distance < best))
+            best = distance;
+    }
+    return best;
+}
+
+// This function schedules the next time the count reaches a compare register; registers in capture mode have no compare events. The position
+// must be up to date.
+static void _schedule(Timer_t * t, uint8_t n)
+{
+    bool compare = (t->mode != TIMER_A_STOP_MODE) && (n < t->num_ccr) && !(t->cctl[n] & CAP);
+    uint32_t distance = compare ? _distance(t, t->position, t->ccr[n]) : 0;
+    if(distance == 0)
+    {
+        sim_disarm(&t->compare[n]);
+        return;
+    }
+    uint64_t edge = _ticks(t, sim_now) + distance;
+    sim_arm(&t->compare[n], (edge * SIM_MCLK_FREQ + t->clock_freq - 1U) / t->clock_freq);
+}
+
+// This function schedules the next time the count returns to 0, if the overflow interrupt is enabled. The position must be up to date.
+static void _scheduleOverflow(Timer_t * t)
+{
+    if((t->mode == TIMER_A_STOP_MODE) || !(t->ctl & TAIE))
+    {
+        sim_disarm(&t->overflow);
+        return;
+    }
+    uint64_t edge = _ticks(t, sim_now) + (_cycle(t) - t->position); // Position 0 is where the count leaves 0 counting up
+    sim_arm(&t->overflow, (edge * SIM_MCLK_FREQ + t->clock_freq - 1U) / t->clock_freq);
+}
+
+// This function reschedules every compare register, and the overflow, after the count or the mode has changed.
+static void _scheduleAll(Timer_t * t)
+{
+    uint8_t n;
+    for(n=0; n<t->num_ccr; ++n)
+        _schedule(t, n);
+    _scheduleOverflow(t);
+}
+
+// This function changes the level of the output unit of a register, and of the pin it is selected on.
+static void _output(Timer_t * t, uint8_t n, bool high)
+{
+    if(t->outputs[n] == high)
+        return;
+    t->outputs[n] = high;
+    gpio_sim_timerOutput((uint8_t) (t - timers), n, high);
+}
+
+// This function makes the output unit of a register follow OUT, in output mode 0.
+static void _outBit(Timer_t * t, uint8_t n)
+{
+    if((t->cctl[n] & OUTMOD_7) == OUTMOD_0)
+        _output(t, n, (t->cctl[n] & OUT) != 0);
+}
+
+// This function sets a compare flag once the count reaches its register, and its output in modes 1 and 5, and triggers the DMA channels waiting for it.
+static void _compare(Timer_t * t, uint8_t n)
+{
+    _advance(t);
+    t->cctl[n] |= CCIFG;
+    ++t->num_compares[n];
+    if((t->cctl[n] & OUTMOD_7) == OUTMOD_1)
+        _output(t, n, true);
+    else if((t->cctl[n] & OUTMOD_7) == OUTMOD_5)
+        _output(t, n, false);
+    _schedule(t, n);
+    if(t->triggers[n] != NO_TRIGGER)
+        dma_sim_trigger(t->triggers[n]);
+}
+
+// This function sets the overflow flag once the count has returned to 0.
+static void _overflow(Timer_t * t)
+{
+    _advance(t);
+    t->ctl |= TAIFG;
+    ++t->num_overflows;
+    _scheduleOverflow(t);
+}
+
+static void _overflowA0(void) { _overflow(&timers[0]); }
+static void _overflowA1(void) { _overflow(&timers[1]); }
+static void _overflowA2(void) { _overflow(&timers[2]); }
+static void _compareA0_0(void) { _compare(&timers[0], 0); }
+static void _compareA0_1(void) { _compare(&timers[0], 1); }
+static void _compareA0_2(void) { _compare(&timers[0], 2); }
+static void _compareA0_3(void) { _compare(&timers[0], 3); }
+static void _compareA0_4(void) { _compare(&timers[0], 4); }
+static void _compareA1_0(void) { _compare(&timers[1], 0); }
+static void _compareA1_1(void) { _compare(&timers[1], 1); }
+static void _compareA1_2(void) { _compare(&timers[1], 2); }
+static void _compareA2_0(void) { _compare(&timers[2], 0); }
+static void _compareA2_1(void) { _compare(&timers[2], 1); }
+static void _compareA2_2(void) { _compare(&timers[2], 2); }
+
+// This function registers the counter registers with the memory map.
+static void _attach(void)
+{
+    static bool attached = false;
+    if(!attached)
+    {
+        static void (* const fires[NUM_TIMERS][NUM_CCR])(void) =
+        {
+            {_compareA0_0, _compareA0_1, _compareA0_2, _compareA0_3, _compareA0_4},
+            {_compareA1_0, _compareA1_1, _compareA1_2},
+            {_compareA2_0, _compareA2_1, _compareA2_2},
+        };
+        static void (* const overflows[NUM_TIMERS])(void) = {_overflowA0, _overflowA1, _overflowA2};
+        uint8_t idx, n;
+        for(idx=0; idx<NUM_TIMERS; ++idx)
+        {
+            sim_mapSync(timers[idx].base + OFS_TAxR, 2, _sync);
+            timers[idx].overflow.fire = overflows[idx];
+            for(n=0; n<timers[idx].num_ccr; ++n)
+                timers[idx].compare[n].fire = fires[idx][n];
+        }
+        attached = true;
+    }
+}
+
+// This function returns the index of a capture/compare register from its driverlib offset.
+static uint8_t _index(uint16_t captureCompareRegister)
+{
+    uint8_t n = (captureCompareRegister - TIMER_A_CAPTURECOMPARE_REGISTER_0) / 2U;
+    return (n < NUM_CCR) ? n : 0;
+}
+
+// This function applies the clock settings shared by the init functions.
+static void _setClock(Timer_t * t, uint16_t clockSource, uint16_t clockSourceDivider)
+{
+    uint32_t divider = 1U;
+    if(clockSourceDivider == TIMER_A_CLOCKSOURCE_DIVIDER_2)
+        divider = 2U;
+    else if(clockSourceDivider == TIMER_A_CLOCKSOURCE_DIVIDER_4)
+        divider = 4U;
+    t->clock_freq = ((clockSource == TIMER_A_CLOCKSOURCE_SMCLK) ? SIM_MCLK_FREQ : SIM_ACLK_FREQ) / divider;
+    t->sync_time = sim_now;
+}
+
+void Timer_A_initContinuousMode(uint16_t baseAddress, Timer_A_initContinuousModeParam *param)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    _attach();
+    Timer_t * t = _timer(baseAddress);
+    _advance(t);
+    t->mode = TIMER_A_STOP_MODE;
+    _setClock(t, param->clockSource, param->clockSourceDivider);
+    if(param->timerClear == TIMER_A_DO_CLEAR)
+        t->position = 0;
+    t->ctl = (t->ctl & ~TAIE) | (param->timerInterruptEnable_TAIE & TAIE);
+    if(param->startTimer)
+        t->mode = TIMER_A_CONTINUOUS_MODE;
+    _advance(t);
+    _scheduleAll(t);
+}
+
+void Timer_A_initUpDownMode(uint16_t baseAddress, Timer_A_initUpDownModeParam *param)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    _attach();
+    Timer_t * t = _timer(baseAddress);
+    _advance(t);
+    t->mode = TIMER_A_STOP_MODE;
+    _setClock(t, param->clockSource, param->clockSourceDivider);
+    if(param->timerClear == TIMER_A_DO_CLEAR)
+        t->position = 0;
+    t->ccr[0] = param->timerPeriod;
+    t->cctl[0] = (t->cctl[0] & ~CCIE) | (param->captureCompareInterruptEnable_CCR0_CCIE & CCIE);
+    t->ctl = (t->ctl & ~TAIE) | (param->timerInterruptEnable_TAIE & TAIE);
+    if(param->startTimer)
+        t->mode = TIMER_A_UPDOWN_MODE;
+    t->position %= _cycle(t);
+    _advance(t);
+    _scheduleAll(t);
+}
+
+void Timer_A_initCompareMode(uint16_t baseAddress, Timer_A_initCompareModeParam *param)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    _attach();
+    Timer_t * t = _timer(baseAddress);
+    _advance(t);
+    uint8_t n = _index(param->compareRegister);
+    t->cctl[n] = (t->cctl[n] & ~(CM_3|CCIS_MASK|SCS|CAP|OUTMOD_7|CCIE)) | (param->compareInterruptEnable & CCIE) |
+                 (param->compareOutputMode & OUTMOD_7);
+    t->ccr[n] = param->compareValue;
+    _outBit(t, n);
+    _scheduleAll(t); // CCR0 may set the length of the cycle
+}
+
+void Timer_A_initCaptureMode(uint16_t baseAddress, Timer_A_initCaptureModeParam *param)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    _attach();
+    Timer_t * t = _timer(baseAddress);
+    _advance(t);
+    uint8_t n = _index(param->captureRegister);
+    t->cctl[n] = (t->cctl[n] & (COV|CCIFG)) | (param->captureMode & CM_3) | (param->captureInputSelect & CCIS_MASK) |
+                 (param->synchronizeCaptureSource & SCS) | CAP | (param->captureInterruptEnable & CCIE);
+    _schedule(t, n); // No more compare events
+    sim_dispatch();
+}
+
+void Timer_A_startCounter(uint16_t baseAddress, uint16_t timerMode)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    Timer_t * t = _timer(baseAddress);
+    _advance(t);
+    t->mode = timerMode;
+    t->position %= _cycle(t);
+    _advance(t);
+    _scheduleAll(t);
+}
+
+void Timer_A_stop(uint16_t baseAddress)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    Timer_t * t = _timer(baseAddress);
+    _advance(t);
+    t->mode = TIMER_A_STOP_MODE;
+    _scheduleAll(t);
+}
+
+void Timer_A_clear(uint16_t baseAddress)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    Timer_t * t = _timer(baseAddress);
+    _advance(t);
+    t->position = 0;
+    _advance(t);
+    _scheduleAll(t);
+}
+
+uint16_t Timer_A_getCounterValue(uint16_t baseAddress)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    Timer_t * t = _timer(baseAddress);
+    _advance(t);
+    return _count(t, t->position);
+}
+
+void Timer_A_setCompareValue(uint16_t baseAddress, uint16_t compareRegister, uint16_t compareValue)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    Timer_t * t = _timer(baseAddress);
+    _advance(t);
+    uint8_t n = _index(compareRegister);
+    t->ccr[n] = compareValue;
+    if(n == 0)
+    {
+        t->position %= _cycle(t);
+        _scheduleAll(t);
+    }
+    else
+        _schedule(t, n);
+}
+
+uint16_t Timer_A_getCaptureCompareCount(uint16_t baseAddress, uint16_t captureCompareRegister)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    return _timer(baseAddress)->ccr[_index(captureCompareRegister)];
+}
+
+void Timer_A_enableCaptureCompareInterrupt(uint16_t baseAddress, uint16_t captureCompareRegister)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    _timer(baseAddress)->cctl[_index(captureCompareRegister)] |= CCIE;
+    sim_dispatch();
+}
+
+void Timer_A_disableCaptureCompareInterrupt(uint16_t baseAddress, uint16_t captureCompareRegister)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    _timer(baseAddress)->cctl[_index(captureCompareRegister)] &= ~CCIE;
+}
+
+uint32_t Timer_A_getCaptureCompareInterruptStatus(uint16_t baseAddress, uint16_t captureCompareRegister, uint16_t mask)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    return _timer(baseAddress)->cctl[_index(captureCompareRegister)] & mask;
+}
+
+void Timer_A_clearCaptureCompareInterrupt(uint16_t baseAddress, uint16_t captureCompareRegister)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    _timer(baseAddress)->cctl[_index(captureCompareRegister)] &= ~CCIFG;
+}
+
+void Timer_A_setOutputMode(uint16_t baseAddress, uint16_t compareRegister, uint16_t compareOutputMode)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    Timer_t * t = _timer(baseAddress);
+    uint8_t n = _index(compareRegister);
+    t->cctl[n] = (t->cctl[n] & ~OUTMOD_7) | (compareOutputMode & OUTMOD_7);
+    _outBit(t, n);
+}
+
+void Timer_A_setOutputForOutputModeOutBitValue(uint16_t baseAddress, uint16_t captureCompareRegister, uint8_t outputModeOutBitValue)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    Timer_t * t = _timer(baseAddress);
+    uint8_t n = _index(captureCompareRegister);
+    t->cctl[n] = (t->cctl[n] & ~OUT) | (outputModeOutBitValue & OUT);
+    _outBit(t, n);
+}
+
+void Timer_A_enableInterrupt(uint16_t baseAddress)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    Timer_t * t = _timer(baseAddress);
+    _advance(t);
+    t->ctl |= TAIE;
+    _scheduleOverflow(t);
+    sim_dispatch();
+}
+
+void Timer_A_disableInterrupt(uint16_t baseAddress)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    Timer_t * t = _timer(baseAddress);
+    t->ctl &= ~TAIE;
+    sim_disarm(&t->overflow);
+}
+
+uint32_t Timer_A_getInterruptStatus(uint16_t baseAddress)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    return (_timer(baseAddress)->ctl & TAIFG) ? TIMER_A_INTERRUPT_PENDING : TIMER_A_INTERRUPT_NOT_PENDING;
+}
+
+void Timer_A_clearTimerInterrupt(uint16_t baseAddress)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    _timer(baseAddress)->ctl &= ~TAIFG;
+}
+
+// This function captures the count into a register in capture mode when its CCInA input has the edge it waits for. A capture while the flag
+// of the previous one is still set also sets COV.
+//  timer: index of the timer (0 for Timer_A0).
+//  n: index of the capture/compare register.
+//  high: new level of the input.
+void timer_a_sim_input(uint8_t timer, uint8_t n, bool high)
+{
+    Timer_t * t = &timers[timer];
+    uint16_t cctl = t->cctl[n];
+    uint16_t edge = high ? CM_1 : CM_2;
+    if((n >= t->num_ccr) || !(cctl & CAP) || ((cctl & CCIS_MASK) != CCIS_0) || !(cctl & edge))
+        return;
+    _advance(t);
+    if(cctl & CCIFG)
+        t->cctl[n] |= COV;
+    t->ccr[n] = _count(t, t->position);
+    t->cctl[n] |= CCIFG;
+    ++t->num_captures[n];
+}
+
+// This function returns whether TIMER0_A0_VECTOR is requested.
+bool timer_a_sim_cc0Pending(void)
+{
+    return (timers[0].cctl[0] & CCIE) && (timers[0].cctl[0] & CCIFG);
+}
+
+// This function clears the CCR0 flag of Timer_A0 when TIMER0_A0_VECTOR is taken, as the CPU does.
+void timer_a_sim_cc0Taken(void)
+{
+    timers[0].cctl[0] &= ~CCIFG;
+}
+
+// This function returns whether TIMER0_A1_VECTOR is requested by the overflow of Timer_A0 or by one of its registers other than CCR0.
+bool timer_a_sim_a0Pending(void)
+{
+    uint8_t n;
+    for(n=1; n<timers[0].num_ccr; ++n)
+        if((timers[0].cctl[n] & CCIE) && (timers[0].cctl[n] & CCIFG))
+            return true;
+    return (timers[0].ctl & TAIE) && (timers[0].ctl & TAIFG);
+}
+
+// This function prints the number of compare events of each register of the timers that were used, and of overflow events and captures.
+void timer_a_sim_report(void)
+{
+    uint8_t idx, n;
+    for(idx=0; idx<NUM_TIMERS; ++idx)
+    {
+        const uint32_t * counts = timers[idx].num_compares;
+        if(counts[0] || counts[1] || counts[2])
+            fprintf(stderr, "sim: timer_a%u compare events: CCR0 %u, CCR1 %u, CCR2 %u\n", idx, counts[0], counts[1], counts[2]);
+        if(timers[idx].num_overflows)
+            fprintf(stderr, "sim: timer_a%u overflow events: %u\n", idx, timers[idx].num_overflows);
+        for(n=0; n<timers[idx].num_ccr; ++n)
+            if(timers[idx].num_captures[n])
+                fprintf(stderr, "sim: timer_a%u CCR%u captures: %u\n", idx, n, timers[idx].num_captures[n]);
+    }
+}
@@ -0,0 +1,108 @@
+/*
+ * timer_sim.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// This file simulates the counter of Timer_B0. The count is computed from virtual time whenever it is read, so TB0R can also be read and
+// written directly through HWREG16 as main.c does.
+
+#include "sim.h"
+#include "timer_b.h"
+
+#define TB_R (*(uint16_t *) &sim_mem[TIMER_B0_BASE + OFS_TBxR])
+
+static uint16_t mode = TIMER_B_STOP_MODE;
+static uint32_t clock_freq = SIM_ACLK_FREQ; // Frequency of the selected clock source
+static uint16_t period = 0xFFFF; // TB0CCR0, the top of the count in up mode
+static sim_time_t sync_time = 0; // Time at which TB_R was last brought up to date
+
+// This function returns the number of timer clock edges between reset and a point in virtual time.
+static uint64_t _ticks(sim_time_t t)
+{
+    return (t * clock_freq) / SIM_MCLK_FREQ;
+}
+
+// This function brings TB_R up to date with virtual time.
+static void _sync(uint16_t address)
+{
+    (void) address;
+    if(mode != TIMER_B_STOP_MODE)
+    {
+        uint64_t modulus = (mode == TIMER_B_UP_MODE) ? ((uint64_t) period + 1U) : 0x10000U;
+        TB_R = (uint16_t) ((TB_R + _ticks(sim_now) - _ticks(sync_time)) % modulus);
+    }
+    sync_time = sim_now;
+}
+
+// This function registers the counter register with the memory map.
+static void _attach(void)
+{
+    static bool attached = false;
+    if(!attached)
+    {
+        sim_mapSync(TIMER_B0_BASE + OFS_TBxR, 2, _sync);
+        attached = true;
+    }
+}
+
+void Timer_B_initUpMode(uint16_t baseAddress, Timer_B_initUpModeParam *param)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    _attach();
+    _sync(0);
+    mode = TIMER_B_STOP_MODE;
+    clock_freq = (param->clockSource == TIMER_B_CLOCKSOURCE_SMCLK) ? SIM_MCLK_FREQ : SIM_ACLK_FREQ;
+    period = param->timerPeriod;
+    if(param->timerClear == TIMER_B_DO_CLEAR)
+        TB_R = 0;
+    if(param->startTimer)
+        mode = TIMER_B_UP_MODE;
+}
+
+void Timer_B_initContinuousMode(uint16_t baseAddress, Timer_B_initContinuousModeParam *param)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    _attach();
+    _sync(0);
+    mode = TIMER_B_STOP_MODE;
+    clock_freq = (param->clockSource == TIMER_B_CLOCKSOURCE_SMCLK) ? SIM_MCLK_FREQ : SIM_ACLK_FREQ;
+    if(param->timerClear == TIMER_B_DO_CLEAR)
+        TB_R = 0;
+    if(param->startTimer)
+        mode = TIMER_B_CONTINUOUS_MODE;
+}
+
+void Timer_B_startCounter(uint16_t baseAddress, uint16_t timerMode)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    _sync(0);
+    mode = timerMode;
+}
+
+void Timer_B_stop(uint16_t baseAddress)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    _sync(0);
+    mode = TIMER_B_STOP_MODE;
+}
+
+void Timer_B_clear(uint16_t baseAddress)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    _sync(0);
+    TB_R = 0;
+}
+
+uint16_t Timer_B_getCounterValue(uint16_t baseAddress)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    _sync(0);
+    return TB_R;
+}
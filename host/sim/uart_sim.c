@@ -0,0 +1,294 @@
+/*
+ * uart_sim.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// This file simulates USCI_A1 in UART mode together with the computer on the other end of the virtual COM port.
+// Bytes the firmware transmits are written to stdout. Commands are read from stdin and sent one frame at a time at the configured baud rate,
+// a frame ending with the zero byte that delimits the frames of proto.c (python_files/protocol.py encodes them); like interface.py, the
+// simulated computer waits for the firmware to go quiet before it sends the next frame. With SIM_PIPELINE=1 in the environment, it sends
+// every frame as soon as the previous one is out instead, as protocol.Pipeline does. Once stdin is exhausted and the firmware has been
+// quiet for FINISH_CYCLES, the simulation ends.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+#include "usci_a_uart.h"
+
+#define UCA_IE    (sim_mem[USCI_A1_BASE + OFS_UCAxIE])
+#define UCA_IFG   (sim_mem[USCI_A1_BASE + OFS_UCAxIFG])
+#define UCA_STAT  (sim_mem[USCI_A1_BASE + OFS_UCAxSTAT])
+#define UCA_RXBUF (sim_mem[USCI_A1_BASE + OFS_UCAxRXBUF])
+#define UCA_TXBUF (sim_mem[USCI_A1_BASE + OFS_UCAxTXBUF])
+
+#define QUIET_CYCLES SIM_US(5000) // How long the computer waits for the firmware to stop talking before sending the next frame
+#define FINISH_CYCLES SIM_US(500000) // How long the firmware has to be quiet after the last frame before the simulation ends
+#define FRAME_END     (0x00) // Byte that ends a command frame
+#define DMA_TRIGGER_UCA1TXIFG (21U)
+
+static uint32_t char_cycles = 1740; // Cycles per character (start, 8 data, stop), set from the baud rate settings
+static bool enabled = false;
+static bool shifting = false; // Whether a character is being transmitted
+static bool tx_pending = false; // Whether TXBUF holds a character waiting for the shift register
+static uint8_t shift_value;
+static sim_event_t tx_done;
+static sim_event_t rx_char; // Next character from the computer arrives
+static sim_event_t quiet; // Computer decides the firmware has gone quiet
+static sim_time_t last_activity = 0; // Time of the last character in either direction
+static bool sending_frame = false; // Whether the computer is in the middle of sending a frame
+static uint32_t frame_chars = 0; // Characters of the current frame sent so far
+static bool input_done = false; // Whether stdin is exhausted
+static bool pipeline = false; // Whether the computer sends frames back to back rather than waiting for the firmware to go quiet
+
+static uint32_t tx_chars = 0; // Characters sent by the firmware
+static uint32_t rx_chars = 0; // Characters sent by the computer
+static uint32_t overruns = 0; // Characters lost because the firmware did not read RXBUF in time
+static uint32_t frames = 0; // Command frames sent by the computer
+static uint32_t answered = 0; // Command frames followed by a response
+static sim_time_t frame_end = 0; // When the last command frame finished arriving
+static bool frame_open = false; // Whether the response time of the last command frame is still being measured
+static sim_time_t last_tx = 0; // When the firmware last finished sending a character
+static sim_time_t response_cycles = 0; // Total time from end of command frame to end of response
+static sim_time_t max_response_cycles = 0;
+
+// This function records traffic and pushes back the moment the computer considers the link quiet.
+static void _activity(void)
+{
+    last_activity = sim_now;
+    sim_arm(&quiet, sim_now + (input_done ? FINISH_CYCLES : QUIET_CYCLES));
+}
+
+// This function closes the response-time measurement of the previous command frame.
+static void _closeFrame(void)
+{
+    if(frame_open && (last_tx > frame_end))
+    {
+        sim_time_t response = last_tx - frame_end;
+        ++answered;
+        response_cycles += response;
+        if(response > max_response_cycles)
+            max_response_cycles = response;
+    }
+    frame_open = false;
+}
+
+// This function moves a character into the transmit shift register.
+static void _startShift(uint8_t value)
+{
+    shifting = true;
+    shift_value = value;
+    UCA_STAT |= UCBUSY;
+    sim_arm(&tx_done, sim_now + char_cycles);
+    if(!(UCA_IFG & UCTXIFG)) // TXBUF is free again
+    {
+        UCA_IFG |= UCTXIFG;
+        dma_sim_trigger(DMA_TRIGGER_UCA1TXIFG);
+    }
+}
+
+static void _txDone(void)
+{
+    putchar(shift_value);
+    ++tx_chars;
+    last_tx = sim_now;
+    shifting = false;
+    UCA_STAT &= ~UCBUSY;
+    _activity();
+    if(tx_pending)
+    {
+        tx_pending = false;
+        _startShift(UCA_TXBUF);
+    }
+}
+
+// This function writes TXBUF, from the CPU or from a DMA channel.
+static void _writeTxbuf(uint8_t value)
+{
+    UCA_TXBUF = value;
+    UCA_IFG &= ~UCTXIFG;
+    if(!shifting)
+        _startShift(value);
+    else
+        tx_pending = true;
+}
+
+// This function delivers the next character of the current command frame.
+static void _rxChar(void)
+{
+    int c = getchar();
+    if(c == EOF)
+    {
+        input_done = true;
+        sending_frame = false;
+        if(frame_chars == 0) // The frame that was about to start does not exist
+            --frames;
+        sim_arm(&quiet, last_activity + FINISH_CYCLES);
+        return;
+    }
+    if(UCA_IFG & UCRXIFG)
+    {
+        UCA_STAT |= UCOE;
+        ++overruns;
+    }
+    UCA_RXBUF = (uint8_t) c;
+    UCA_IFG |= UCRXIFG;
+    ++rx_chars;
+    ++frame_chars;
+    _activity();
+    if(c == FRAME_END)
+    {
+        sending_frame = false;
+        frame_end = sim_now;
+        frame_open = true;
+        if(pipeline) // The next frame follows at once.
+        {
+            sending_frame = true;
+            frame_chars = 0;
+            ++frames;
+            sim_arm(&rx_char, sim_now + char_cycles);
+        }
+    }
+    else
+        sim_arm(&rx_char, sim_now + char_cycles);
+}
+
+// This function runs when the link has been quiet for QUIET_CYCLES: the computer sends its next frame, or the simulation ends.
+static void _quiet(void)
+{
+    if(sending_frame || shifting)
+        return;
+    _closeFrame();
+    if(input_done)
+        sim_finish(EXIT_SUCCESS);
+    sending_frame = true;
+    frame_chars = 0;
+    ++frames;
+    sim_arm(&rx_char, sim_now + char_cycles);
+}
+
+bool USCI_A_UART_init(uint16_t baseAddress, USCI_A_UART_initParam *param)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    tx_done.fire = _txDone;
+    rx_char.fire = _rxChar;
+    quiet.fire = _quiet;
+    static bool mapped = false;
+    if(!mapped)
+    {
+        const char * env = getenv("SIM_PIPELINE");
+        pipeline = (env != NULL) && (env[0] == '1');
+        sim_mapIo(USCI_A1_BASE + OFS_UCAxTXBUF, NULL, _writeTxbuf);
+        mapped = true;
+    }
+    uint32_t bit_cycles;
+    if(param->overSampling) // BITCLK16 = BRCLK/(UCBRx), with UCBRFx extra BRCLK cycles spread over each bit
+        bit_cycles = 16U*param->clockPrescalar + param->firstModReg;
+    else
+        bit_cycles = param->clockPrescalar + (param->secondModReg+4U)/8U;
+    if(param->selectClockSource == USCI_A_UART_CLOCKSOURCE_ACLK)
+        bit_cycles *= SIM_MCLK_FREQ/SIM_ACLK_FREQ;
+    char_cycles = 10U*bit_cycles;
+    UCA_IE = 0;
+    UCA_IFG = UCTXIFG;
+    UCA_STAT = 0;
+    return STATUS_SUCCESS;
+}
+
+void USCI_A_UART_enable(uint16_t baseAddress)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    if(!enabled)
+    {
+        enabled = true;
+        _activity(); // The computer starts talking once the port has been quiet for a while
+    }
+}
+
+void USCI_A_UART_disable(uint16_t baseAddress)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+}
+
+void USCI_A_UART_transmitData(uint16_t baseAddress, uint8_t transmitData)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    _writeTxbuf(transmitData);
+}
+
+uint8_t USCI_A_UART_receiveData(uint16_t baseAddress)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    UCA_IFG &= ~UCRXIFG;
+    UCA_STAT &= ~UCOE;
+    return UCA_RXBUF;
+}
+
+void USCI_A_UART_enableInterrupt(uint16_t baseAddress, uint8_t mask)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    UCA_IE |= mask;
+    sim_dispatch();
+}
+
+void USCI_A_UART_disableInterrupt(uint16_t baseAddress, uint8_t mask)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    UCA_IE &= ~mask;
+}
+
+uint8_t USCI_A_UART_getInterruptStatus(uint16_t baseAddress, uint8_t mask)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    return UCA_IFG & mask;
+}
+
+void USCI_A_UART_clearInterrupt(uint16_t baseAddress, uint8_t mask)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    UCA_IFG &= ~mask;
+}
+
+uint8_t USCI_A_UART_queryStatusFlags(uint16_t baseAddress, uint8_t mask)
+{
+    (void) baseAddress;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    return UCA_STAT & mask;
+}
+
+uint32_t USCI_A_UART_getTransmitBufferAddressForDMA(uint16_t baseAddress)
+{
+    return baseAddress + OFS_UCAxTXBUF;
+}
+
+// This function returns whether USCI_A1_VECTOR is requested.
+bool uart_sim_pending(void)
+{
+    return (UCA_IFG & UCA_IE) != 0;
+}
+
+// This function returns whether the transmitter has nothing left to send.
+bool uart_sim_idle(void)
+{
+    return !shifting && !tx_pending;
+}
+
+// This function prints the UART statistics, if the firmware has used the UART.
+void uart_sim_report(void)
+{
+    if(!enabled)
+        return;
+    _closeFrame();
+    fprintf(stderr, "sim: uart %u chars out, %u chars in, %u overruns, %.1f us per char\n", tx_chars, rx_chars, overruns, sim_us(char_cycles));
+    fprintf(stderr, "sim: uart %u command frames, %u answered, response avg %.1f us, max %.1f us\n", frames, answered,
+            answered ? sim_us(response_cycles)/answered : 0.0, sim_us(max_response_cycles));
+}
@@ -0,0 +1,293 @@
+/*
+ * usb_sim.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// This file stands in for the TI MSP430 USB Developers Package (CDC API) and the MSP430F5529 USB module, together with the computer on the
+// other end of the CDC-ACM port; it is used by builds with VCOM_USB = 1. The computer behaves as in uart_sim.c: it sends one command frame
+// at a time from stdin once the firmware has gone quiet (or back to back with SIM_PIPELINE=1), and what the firmware sends is written to
+// stdout.
+// Both bulk endpoints carry 64-byte packets, one per USB_PACKET_CYCLES. The IN endpoint has the X and Y buffers of the USB module; the stack
+// copies the data of a send operation into them from its interrupt handler as the computer takes packets, and calls
+// USBCDC_handleSendCompleted once the last byte has been copied. The computer only sends an OUT packet once the firmware has emptied the
+// previous one (until then the endpoint NAKs); each packet calls USBCDC_handleDataReceived from the interrupt handler.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+#include "USB_API/USB_Common/usb.h"
+#include "USB_API/USB_CDC_API/UsbCdc.h"
+#include "USB_config/descriptors.h"
+
+// The event handlers are only defined by builds with VCOM_USB = 1; the others never call USB_setup, so they are never called.
+extern uint8_t USBCDC_handleDataReceived(uint8_t intfNum) __attribute__ ((weak));
+extern uint8_t USBCDC_handleSendCompleted(uint8_t intfNum) __attribute__ ((weak));
+
+#define USB_PACKET_LEN    (64U) // Max packet size of the bulk endpoints
+#define USB_PACKET_CYCLES SIM_US(53) // Bus time per packet: 19 per 1 ms frame, the most a full-speed bulk endpoint gets
+#define USB_COPY_CYCLES(n) (100U + 4U*(n)) // Time the stack takes to copy a packet of n bytes between memory and an endpoint buffer, without DMA
+#define USB_IN_BUFFERS    (2U) // X and Y buffers of the IN endpoint
+
+#define QUIET_CYCLES SIM_US(5000) // How long the computer waits for the firmware to stop talking before sending the next frame
+#define FINISH_CYCLES SIM_US(500000) // How long the firmware has to be quiet after the last frame before the simulation ends
+#define FRAME_END     (0x00) // Byte that ends a command frame
+
+static bool connected = false; // Whether USB_setup has had the device enumerate
+static const uint8_t * send_data; // Data of the send operation not yet copied into an endpoint buffer
+static uint16_t send_left = 0; // Bytes of the send operation not yet copied
+static bool send_open = false; // Whether a send operation is in progress
+static uint8_t in_buf[USB_IN_BUFFERS][USB_PACKET_LEN]; // IN endpoint buffers
+static uint8_t in_len[USB_IN_BUFFERS];
+static uint8_t in_fill = 0; // Buffer the stack fills next
+static uint8_t in_count = 0; // Buffers waiting for the computer to take them
+static bool in_irq = false; // IN endpoint interrupt flag: a buffer is free, or a send operation has been started
+static uint8_t out_buf[USB_PACKET_LEN]; // OUT endpoint buffer
+static uint8_t out_len = 0; // Bytes in the OUT endpoint buffer
+static uint8_t out_idx = 0; // Bytes of them the firmware has taken
+static bool out_irq = false; // OUT endpoint interrupt flag: a packet has arrived
+static sim_event_t in_packet; // Computer takes the next IN packet
+static sim_event_t out_packet; // Computer sends the next OUT packet
+static sim_event_t quiet; // Computer decides the firmware has gone quiet
+static sim_time_t last_activity = 0; // Time of the last packet in either direction
+static bool sending_frame = false; // Whether the computer is in the middle of sending a frame
+static uint32_t frame_chars = 0; // Bytes of the current frame sent so far
+static bool input_done = false; // Whether stdin is exhausted
+static bool pipeline = false; // Whether the computer sends frames back to back rather than waiting for the firmware to go quiet
+
+static uint32_t tx_chars = 0; // Bytes sent by the firmware
+static uint32_t rx_chars = 0; // Bytes sent by the computer
+static uint32_t in_packets = 0;
+static uint32_t out_packets = 0;
+static uint32_t naks = 0; // OUT packets refused because the firmware had not emptied the endpoint buffer
+static uint32_t frames = 0; // Command frames sent by the computer
+static uint32_t answered = 0; // Command frames followed by a response
+static sim_time_t frame_end = 0; // When the last command frame finished arriving
+static bool frame_open = false; // Whether the response time of the last command frame is still being measured
+static sim_time_t last_tx = 0; // When the computer last took a packet
+static sim_time_t response_cycles = 0; // Total time from end of command frame to end of response
+static sim_time_t max_response_cycles = 0;
+
+// This function records traffic and pushes back the moment the computer considers the link quiet.
+static void _activity(void)
+{
+    last_activity = sim_now;
+    sim_arm(&quiet, sim_now + (input_done ? FINISH_CYCLES : QUIET_CYCLES));
+}
+
+// This function closes the response-time measurement of the previous command frame.
+static void _closeFrame(void)
+{
+    if(frame_open && (last_tx > frame_end))
+    {
+        sim_time_t response = last_tx - frame_end;
+        ++answered;
+        response_cycles += response;
+        if(response > max_response_cycles)
+            max_response_cycles = response;
+    }
+    frame_open = false;
+}
+
+// This function copies the next part of the send operation into the free IN endpoint buffers, as the stack does from its interrupt handler.
+// Returns true if an event handler asked for the CPU to be woken up.
+static bool _fillIn(void)
+{
+    bool wake = false;
+    while(send_open && (in_count < USB_IN_BUFFERS))
+    {
+        uint8_t len = (send_left < USB_PACKET_LEN) ? send_left : USB_PACKET_LEN;
+        uint8_t idx;
+        for(idx=0; idx<len; ++idx)
+            in_buf[in_fill][idx] = send_data[idx];
+        sim_spend(USB_COPY_CYCLES(len));
+        in_len[in_fill] = len;
+        in_fill = (in_fill + 1) % USB_IN_BUFFERS;
+        ++in_count;
+        send_data += len;
+        send_left -= len;
+        if(!in_packet.armed)
+            sim_arm(&in_packet, sim_now + USB_PACKET_CYCLES);
+        if(send_left == 0) // Everything has been copied: the operation is over, and another one may be started from the event handler.
+        {
+            send_open = false;
+            wake |= USBCDC_handleSendCompleted(CDC0_INTFNUM);
+        }
+    }
+    return wake;
+}
+
+// This function runs when the computer takes an IN packet.
+static void _inPacket(void)
+{
+    uint8_t take = (in_fill + USB_IN_BUFFERS - in_count) % USB_IN_BUFFERS; // Oldest buffer filled
+    uint8_t idx;
+    for(idx=0; idx<in_len[take]; ++idx)
+        putchar(in_buf[take][idx]);
+    tx_chars += in_len[take];
+    ++in_packets;
+    last_tx = sim_now;
+    --in_count;
+    in_irq = true; // The stack can fill the buffer again.
+    _activity();
+    if(in_count != 0)
+        sim_arm(&in_packet, sim_now + USB_PACKET_CYCLES);
+}
+
+// This function sends the next OUT packet of the current command frame, or retries later if the endpoint buffer is still full.
+static void _outPacket(void)
+{
+    if(out_idx < out_len) // NAK
+    {
+        ++naks;
+        sim_arm(&out_packet, sim_now + USB_PACKET_CYCLES);
+        return;
+    }
+    out_len = 0;
+    out_idx = 0;
+    int c = 0;
+    while((out_len < USB_PACKET_LEN) && ((c = getchar()) != EOF))
+    {
+        out_buf[out_len++] = (uint8_t) c;
+        if(c == FRAME_END)
+            break;
+    }
+    if(out_len == 0) // stdin is exhausted
+    {
+        input_done = true;
+        sending_frame = false;
+        if(frame_chars == 0) // The frame that was about to start does not exist
+            --frames;
+        sim_arm(&quiet, last_activity + FINISH_CYCLES);
+        return;
+    }
+    rx_chars += out_len;
+    frame_chars += out_len;
+    ++out_packets;
+    out_irq = true;
+    _activity();
+    if(c == FRAME_END)
+    {
+        sending_frame = false;
+        frame_end = sim_now;
+        frame_open = true;
+        if(pipeline) // The next frame follows in the next packet.
+        {
+            sending_frame = true;
+            frame_chars = 0;
+            ++frames;
+            sim_arm(&out_packet, sim_now + USB_PACKET_CYCLES);
+        }
+    }
+    else
+        sim_arm(&out_packet, sim_now + USB_PACKET_CYCLES);
+}
+
+// This function runs when the link has been quiet for QUIET_CYCLES: the computer sends its next frame, or the simulation ends.
+static void _quiet(void)
+{
+    if(sending_frame || send_open || (in_count != 0))
+        return;
+    _closeFrame();
+    if(input_done)
+        sim_finish(EXIT_SUCCESS);
+    sending_frame = true;
+    frame_chars = 0;
+    ++frames;
+    sim_arm(&out_packet, sim_now + USB_PACKET_CYCLES);
+}
+
+uint8_t USB_setup(uint8_t connectEnable, uint8_t eventsEnable)
+{
+    (void) eventsEnable;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    in_packet.fire = _inPacket;
+    out_packet.fire = _outPacket;
+    quiet.fire = _quiet;
+    if(connectEnable && !connected) // The cable is always plugged in, and the computer opens the port as soon as the device has enumerated.
+    {
+        const char * env = getenv("SIM_PIPELINE");
+        pipeline = (env != NULL) && (env[0] == '1');
+        connected = true;
+        _activity();
+    }
+    return kUSB_succeed;
+}
+
+uint8_t USB_getConnectionState(void)
+{
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    return connected ? ST_ENUM_ACTIVE : ST_USB_DISCONNECTED;
+}
+
+uint8_t USBCDC_sendData(const uint8_t * data, uint16_t size, uint8_t intfNum)
+{
+    (void) intfNum;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    if(size == 0)
+        return kUSBCDC_generalError;
+    if(!connected)
+        return kUSBCDC_busNotAvailable;
+    if(send_open)
+        return kUSBCDC_intfBusyError;
+    send_data = data;
+    send_left = size;
+    send_open = true;
+    in_irq = true; // The stack triggers the IN endpoint interrupt to start copying.
+    return kUSBCDC_sendStarted;
+}
+
+uint16_t USBCDC_receiveDataInBuffer(uint8_t * data, uint16_t size, uint8_t intfNum)
+{
+    (void) intfNum;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    uint16_t count = 0;
+    while((count < size) && (out_idx < out_len))
+        data[count++] = out_buf[out_idx++];
+    sim_spend(USB_COPY_CYCLES(count));
+    return count;
+}
+
+uint16_t USBCDC_getBytesInUSBBuffer(uint8_t intfNum)
+{
+    (void) intfNum;
+    sim_spend(SIM_DRIVERLIB_CYCLES);
+    return out_len - out_idx;
+}
+
+// This function returns whether USB_UBM_VECTOR is requested.
+bool usb_sim_pending(void)
+{
+    return in_irq || out_irq;
+}
+
+// This function is the interrupt handler of the USB stack: it fills the IN endpoint buffers and reports received packets to the firmware.
+void usb_sim_isr(void)
+{
+    bool wake = false;
+    if(in_irq)
+    {
+        in_irq = false;
+        wake |= _fillIn();
+    }
+    if(out_irq)
+    {
+        out_irq = false;
+        if(out_idx < out_len)
+            wake |= USBCDC_handleDataReceived(CDC0_INTFNUM);
+    }
+    if(wake)
+        sim_bicSrOnExit(CPUOFF);
+}
+
+// This function prints the USB statistics, if the firmware has used the USB module.
+void usb_sim_report(void)
+{
+    if(!connected)
+        return;
+    _closeFrame();
+    fprintf(stderr, "sim: usb %u bytes in %u packets out, %u bytes in %u packets in, %u NAKs\n", tx_chars, in_packets, rx_chars, out_packets,
+            naks);
+    fprintf(stderr, "sim: usb %u command frames, %u answered, response avg %.1f us, max %.1f us\n", frames, answered,
+            answered ? sim_us(response_cycles)/answered : 0.0, sim_us(max_response_cycles));
+}
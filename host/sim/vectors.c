@@ -0,0 +1,31 @@
+/*
+ * vectors.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// This file is the simulated interrupt vector table. On the board the firmware binds its handlers with #pragma vector; on the host the
+// handlers are ordinary functions, referenced weakly here so that a vector without a handler is simply never taken. The handler of
+// USB_UBM_VECTOR belongs to the USB stack, so it comes with its stand-in (usb_sim.c).
+// Entries are listed from highest to lowest priority, as in the MSP430F5529 datasheet.
+
+#include <stddef.h>
+#include "sim.h"
+
+extern void _sampleIrqHandler(void) __attribute__ ((weak)); // TIMER0_A0_VECTOR, phase.c
+extern void _overflowIrqHandler(void) __attribute__ ((weak)); // TIMER0_A1_VECTOR, timestamp.c
+extern void _dmaIrqHandler(void) __attribute__ ((weak)); // DMA_VECTOR, main.c
+extern void serviceUart(void) __attribute__ ((weak)); // USCI_A1_VECTOR, vcom.c
+extern void _pinIrqHandler(void) __attribute__ ((weak)); // PORT2_VECTOR, at86.c
+
+const sim_vector_t sim_vectors[] =
+{
+    {"TIMER0_A0_VECTOR", timer_a_sim_cc0Pending,  _sampleIrqHandler,    timer_a_sim_cc0Taken},
+    {"TIMER0_A1_VECTOR", timer_a_sim_a0Pending,   _overflowIrqHandler,  NULL},
+    {"USB_UBM_VECTOR",   usb_sim_pending,         usb_sim_isr,          NULL},
+    {"DMA_VECTOR",       dma_sim_pending,         _dmaIrqHandler,       NULL},
+    {"USCI_A1_VECTOR",   uart_sim_pending,        serviceUart,          NULL},
+    {"PORT2_VECTOR",     gpio_sim_port2Pending,   _pinIrqHandler,       NULL},
+};
+
+const uint8_t sim_num_vectors = sizeof(sim_vectors)/sizeof(sim_vectors[0]);
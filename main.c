@@ -1,32 +1,96 @@
 // This file defines the high-level details of interactions between the computer and MSP430, and between the MSP430 and AT86RF233.
 
 #include <string.h> // TI-provided library to work with strings
-#include <stdio.h> // TI-provided library to work with strings
 
 #include "driverlib.h" // TI-provided library to control MSP430 peripherals
 #include "at86.h" // Low-level control of AT86RF233
+#include "registers.h" // Raw SPI transactions with the AT86RF233, used by the SPI benchmark
 #include "gpio.h" // TI-provided library to control MSP430 GPIO pins
 #include "hal.h" // Definitions of pins/ports, peripheral initialization details, etc.
-#include "timer_b.h" // TI-provided library to control hardware timer
+#include "timestamp.h" // Time base of transmissions, receptions and deadlines
 #include "vcom.h" // Low-level control of UART to talk to computer
+#include "phase.h" // Timer-paced phase measurements during reception
+#include "fit.h" // Straight line fitted to the phase measurements
+#include "proto.h" // Binary protocol spoken with the computer
+#include "sched.h" // Run-to-completion scheduler the work is split into tasks for
 #include "assert_app.h" // Assert statements so we can abort code if errors happen
 
-#define RECEIVE  ("RX") // Command computer sends to tell us to have AT86RF233 receive a payload
-#define TRANSMIT ("TX") // Command computer sends to tell us to have AT86RF233 send a payload
-#define CHANNEL  ("CH") // Command computer sends to tell us to change AT86RF233 channel
-
 volatile AT86_Status_Enum status;
 #define ADDRESS (0xAA) // Address included in payload so upon reception we can distinguish between payloads we sent and garbage payloads
 //#define PAYLOAD (0xFF)
 
 
 #define TX_PAYLOAD_LEN (64U) // Number of bytes per payload (including address byte)
-uint8_t transmit_payload[TX_PAYLOAD_LEN]; // Buffer to store payload to transmit
+uint8_t transmit_payload[TX_PAYLOAD_LEN]; // Buffer to store payload to transmit; the next one is composed here while the last one is on the air
+static uint8_t loaded_payload[TX_PAYLOAD_LEN]; // Copy of the payload in the frame buffer of the AT86RF233, while AT86_txLoaded()
+static uint8_t composed_header_len = 0xFF; // header_len the body of transmit_payload was filled for, so that it is only filled again once it moves
+static uint16_t tx_uploads = 0; // Writes to the frame buffer of the AT86RF233 by loadPayload
 uint8_t received_payload[TX_PAYLOAD_LEN]; // Buffer to store payload received by AT86RF233
 
 #define NUM_PHASE_SAMPLES (256U) // Number of phase measurements to take during reception
 volatile uint8_t phases[NUM_PHASE_SAMPLES]; // Buffer in which to store phase measurements
+volatile uint16_t phase_times[NUM_PHASE_SAMPLES]; // Buffer in which to store the time of each phase measurement (PHASE_TIMER_FREQ ticks after the SFD of the payload)
 volatile uint16_t phases_idx = 0; // Index of phase measurement buffer
+static bool summary = false; // Whether receptions are reported with the fitted line only, rather than with every phase measurement
+
+#define MAC_PAN_ID       (0x2330) // PAN ID of both boards in MAC mode
+#define MAC_HEADER_LEN   (9U) // MAC header ahead of the address byte: frame control (2 bytes), sequence number, destination PAN ID, destination and source short addresses (2 bytes each)
+#define MAC_FCF          (0x8861U) // Frame control field: data frame, ACK request, PAN ID compression, short destination and source addresses
+#define MAC_CSMA_RETRIES (4U) // CSMA-CA attempts after the channel was found busy (the AT86RF233 reset value)
+static bool mac = false; // Whether payloads are sent as acknowledged IEEE 802.15.4 data frames through the AT86RF233 extended operating mode
+static uint8_t header_len = 0; // Bytes of the payload ahead of the address byte: MAC_HEADER_LEN in MAC mode, 0 otherwise
+static uint16_t mac_own = 0; // Our short address in MAC mode
+static uint16_t mac_peer = 0; // Short address of the other board in MAC mode
+static uint8_t mac_seq = 0; // Sequence number of the next frame we send in MAC mode
+
+static volatile bool radio_done = false; // Set by onRadioDone once the ongoing transmission or reception has completed
+static volatile uint32_t radio_start = 0; // Timestamp of the start of the ongoing transmission or reception
+static volatile uint32_t radio_end = 0; // Timestamp recorded by onRadioDone
+static volatile bool radio_async = false; // Whether onRadioDone should post taskRADIO, rather than a function sleeping until radio_done
+static uint16_t analysis_first = 0; // Index of the first phase measurement of the ongoing reception that has not been analyzed yet
+
+typedef enum // Tasks of the scheduler, highest priority first
+{
+    taskRADIO = 0, // Reports a transmission or reception carried out for a command, once it has completed
+    taskCOMMANDS, // Acknowledges and queues the commands that have arrived, and starts the next one once the previous has completed
+    taskANALYSIS, // Fits a line to the phase measurements of a reception, a block at a time
+    taskCOUNT
+} Task_Enum;
+static PROTO_Cmd current; // Command being carried out
+static bool cmd_running = false; // Whether current has not completed yet
+
+#define BENCH_ITERATIONS (256U) // Number of times each kind of SPI transaction is repeated by the benchmark
+#define BENCH_LEN        (127U) // Number of data bytes in each buffer transaction of the benchmark (a full frame)
+typedef enum // Kinds of SPI transaction measured by the benchmark
+{
+    benchREG_READ = 0,
+    benchREG_WRITE,
+    benchREG_STATUS,
+    benchSRAM_READ,
+    benchSRAM_WRITE,
+    benchFB_READ,
+    benchCOUNT
+} Bench_Enum;
+
+#define TX_LEAD_TICKS     TS_US(20UL) // How far ahead a transmission that is already due is scheduled: time for AT86_execTxAt to set up the timer
+#define TX_AHEAD_TICKS    TS_US(5000UL) // Furthest ahead a transmission is handed to AT86_execTxAt, within half a turn of the timer; until then we wait
+
+#define TX_START_US       (16UL) // Time from TX_START, or the SLP_TR edge, to the start of the preamble (us)
+#define SWEEP_START_TICKS TS_US(1000000UL) // How long a receiving sweep waits for the first payload (1 s), which gives the computer time to start the transmitting one
+#define SWEEP_MAX_GAP_US  (1000000UL) // Longest time between payloads of a sweep
+#define BURST_MAX_IFS_US  (5000UL) // Longest spacing between frames of a burst, which keeps the next start within reach of AT86_execTxAt
+#define PLL_CAL_MAX_AGE   TS_US(300000000UL) // How long the PLL calibrations of the AT86RF233 are trusted before a sweep runs them again (5 min, as the datasheet recommends)
+static uint64_t pll_cal_time = 0; // Timestamp of the latest PLL calibration by hand; the PLL was calibrated when first turned on
+static volatile uint16_t burst_frames = 0; // Frames of the ongoing burst
+static volatile uint16_t burst_done = 0; // Frames of it that have been sent
+static volatile uint16_t burst_underruns = 0; // Frames of it that went out with TRX_UR, because a byte was written to the frame buffer too late
+static volatile uint16_t burst_failures = 0; // Frames of it that were not acknowledged, in MAC mode
+static uint32_t burst_ifs = 0; // Time from the end of a frame of the burst to the start of the next (timestamp ticks)
+typedef enum // Part a board plays in a sweep
+{
+    sweepTRANSMIT = 0,
+    sweepRECEIVE
+} Sweep_Enum;
 
 // This function initializes the MSP430 peripherals we will be using, as well as the AT86RF233.
 void init(void)
@@ -41,116 +105,614 @@ void init(void)
     AT86_init(); // Initialize GPIO and SPI pins going to AT86RF233, and put AT86RF233 in idle state
     AT86_enablePhase(true); // Turn on phase measurement during reception by AT86RF233
     AT86_setTxPower(0); // Have AT86RF233 transmit at 0dBm
-    Timer_B_initUpModeParam timerb_settings = // Set up a timer we will use to time transmissions and receptions
-    {
-     .clockSource = TIMER_B_CLOCKSOURCE_ACLK,
-     .clockSourceDivider = TIMER_B_CLOCKSOURCE_DIVIDER_1,
-     .timerPeriod = 0xFFFF,
-     .timerInterruptEnable_TBIE = TIMER_B_TBIE_INTERRUPT_DISABLE,
-     .captureCompareInterruptEnable_CCR0_CCIE = TIMER_B_CCIE_CCR0_INTERRUPT_DISABLE,
-     .timerClear = TIMER_B_DO_CLEAR,
-     .startTimer = false
-    };
-    Timer_B_initUpMode(TIMER_B0_BASE, &timerb_settings);
+    TS_init(); // Start the timer we will use to time transmissions and receptions (and, with PHASE_DMA = 0, phase measurements)
+    PHASE_init(); // Set up the timers that pace phase measurements
     VCOM_init(); // Initialize UART that will let us send strings to computer over USB virtual COM port
     __enable_interrupt(); // Enable MSP430 interrupts
 }
 
-// This function has the AT86RF233 transmit a payload.
-void transmitPayload(void)
-{
-    AT86_prepareTx(); // Put the AT86RF233 in the appropriate state for transmission.
-    while(AT86_getStatus() != statusPLL_ON); // Wait until in appropriate state.
-    transmit_payload[0] = ADDRESS; // Payload contains an address so upon reception we can distinguish between payloads we sent and garbage payloads.
-    memset(transmit_payload+1, 0xFF, TX_PAYLOAD_LEN-1); // Payloads are hard-coded to 0xFF..., so we can measure a clean sine wave.
-    AT86_loadTx(transmit_payload, TX_PAYLOAD_LEN, 0); // Prepare AT86RF233 to transmit payload by loading payload into its transmit buffer.
-    HWREG16(TIMER_B0_BASE + OFS_TBxR) = 0; // Clear a timer.
-    Timer_B_startCounter(TIMER_B0_BASE, TIMER_B_UP_MODE); // Start the timer so we can see how long transmission took.
-    AT86_execTx(); // Transmit the payload.
-    while(AT86_getStatus() != statusBUSY_TX); // Ensure it gets into the currently-transmitting state.
-    while(AT86_getStatus() != statusPLL_ON); // Wait for transmission to complete.
-    uint32_t time = Timer_B_getCounterValue(TIMER_B0_BASE); // Record time it took to transmit.
-    Timer_B_stop(TIMER_B0_BASE); // Stop timer.
-    GPIO_toggleOutputOnPin(MCU_LED1_PORT, MCU_LED1_PIN); // Toggle an LED, for debugging purposes.
-    char msg[64];
-    sprintf(msg, "(TX) Address: 0x%x, Time: %d us\n", transmit_payload[0], (1000000UL*time)/32768UL);
-    VCOM_tx((uint8_t *)msg, strlen(msg)); // Inform computer that we have transmitted a payload.
+// Interrupt triggered when a DMA channel has finished a block. The SPI driver and VCOM each check their own channel.
+#pragma vector=DMA_VECTOR
+void __attribute__ ((interrupt)) _dmaIrqHandler(void)
+{
+    bool wake = false; // Whether a function is sleeping until this block was done
+#if AT86_SPI_DMA
+    wake |= REG_serviceDma();
+#endif
+#if VCOM_DMA
+    wake |= VCOM_serviceDma();
+#endif
+    if(wake)
+        __bic_SR_register_on_exit(LPM0_bits); // Wake it up.
 }
 
-// This function has the AT86RF233 wait to receive a payload, then retrieves and stores the payload.
-void receivePayload(void)
+// This function puts the CPU to sleep until an interrupt handler has set a flag, acknowledging and queueing the commands that arrive in the
+// meantime. Interrupts are enabled on return.
+//  flag: flag to wait for.
+void sleepUntil(volatile bool * flag)
 {
-    memset(received_payload, TX_PAYLOAD_LEN, 0); // Clear the static variable in which we will store received payload.
-    AT86_prepareRx(); // Have the AT86RF233 switch into the receive state.
-    while((!AT86_irqPending()) && (!(AT86_readIstat() & irqRX_START))); // Wait until AT86RF233 indicates it has started receiving something.
-    HWREG16(TIMER_B0_BASE + OFS_TBxR) = 0; // Clear a timer.
-    Timer_B_startCounter(TIMER_B0_BASE, TIMER_B_UP_MODE); // Start the timer to see how long reception took.
-    phases_idx = 0; // Reset index for array in which we will store phase measurements.
-    AT86_execRx(); // Reset interrupt so we can see when AT86RF233 is done receiving.
-    while((!AT86_irqPending()) && (!(AT86_readIstat() & irqTRX_END))) // Loop until done recieving.
+    __disable_interrupt(); // Don't let the flag be set between checking it and going to sleep.
+    while(!*flag)
     {
-        if(phases_idx != NUM_PHASE_SAMPLES) // Record up to this number of phases
+        if(VCOM_rxAvailable()) // The computer sent another command; it is woken up for.
         {
-            phases[phases_idx] = AT86_getPhase(); // Retrieve and store latest phase measurement
-            ++phases_idx;
+            __enable_interrupt();
+            PROTO_poll();
         }
+        else
+            __bis_SR_register(LPM0_bits + GIE); // Sleep until an interrupt handler wakes us up.
+        __disable_interrupt();
     }
-    uint32_t time = Timer_B_getCounterValue(TIMER_B0_BASE); // Record duration of reception
-    Timer_B_stop(TIMER_B0_BASE); // Stop timer.
+    __enable_interrupt();
+}
+
+// This function busy-waits until a given time has passed.
+//  from: timestamp the time is counted from.
+//  ticks: how long to wait after it (timestamp ticks).
+void waitUntil(uint32_t from, uint32_t ticks)
+{
+    while((TS_now() - from) < ticks);
+}
+
+// This function is called by the AT86RF233 driver from its interrupt handler when it starts receiving a payload.
+void onRxStart(AT86_Irq_Enum irqs)
+{
+    uint32_t now = TS_now();
+    uint16_t sfd; // Timer count captured from DIG2 at the SFD
+    radio_start = AT86_getRxStart(&sfd) ? TS_extend(sfd) : now; // Record when reception started, to see how long it took.
+    PHASE_start(phases, phase_times, NUM_PHASE_SAMPLES, (uint16_t) (now - radio_start)); // Take phase measurements at a fixed period, timed from the SFD.
+}
+
+// This function is called by the AT86RF233 driver from its interrupt handler when a transmission or reception has completed.
+void onRadioDone(AT86_Irq_Enum irqs)
+{
+    radio_end = TS_now(); // Record when it ended.
+    PHASE_stop(); // Stop taking phase measurements, if we were.
+    radio_done = true;
+    if(radio_async)
+        SCHED_post(taskRADIO); // The driver wakes the CPU up on exit.
+}
+
+// This function fills transmit_payload with the next payload to transmit. Only the MAC header changes from one payload to the next; the rest
+// is only filled again when the header changes length.
+void composePayload(void)
+{
+    if(mac) // The MAC header addresses the frame to the other board, which acknowledges it.
+    {
+        transmit_payload[0] = MAC_FCF & 0xFF;
+        transmit_payload[1] = MAC_FCF >> 8;
+        transmit_payload[2] = mac_seq++;
+        transmit_payload[3] = MAC_PAN_ID & 0xFF;
+        transmit_payload[4] = MAC_PAN_ID >> 8;
+        transmit_payload[5] = mac_peer & 0xFF;
+        transmit_payload[6] = mac_peer >> 8;
+        transmit_payload[7] = mac_own & 0xFF;
+        transmit_payload[8] = mac_own >> 8;
+    }
+    if(composed_header_len == header_len)
+        return;
+    transmit_payload[header_len] = ADDRESS; // Payload contains an address so upon reception we can distinguish between payloads we sent and garbage payloads.
+    memset(transmit_payload+header_len+1, 0xFF, TX_PAYLOAD_LEN-header_len-1); // Payloads are hard-coded to 0xFF..., so we can measure a clean sine wave.
+    composed_header_len = header_len;
+}
+
+// This function brings the frame buffer of the AT86RF233 up to date with transmit_payload. Only the bytes from the first to the last that
+// differ from the payload already there are written, and nothing at all if it is the same; the whole payload is only loaded again once a
+// reception or the SPI benchmark has overwritten the buffer.
+void loadPayload(void)
+{
+    uint8_t first = 0; // Bytes to write: first to last-1
+    uint8_t last = TX_PAYLOAD_LEN;
+    if(!AT86_txLoaded())
+        AT86_loadTx(transmit_payload, TX_PAYLOAD_LEN, 0); // Load the whole payload, and its length.
+    else
+    {
+        while((first < TX_PAYLOAD_LEN) && (transmit_payload[first] == loaded_payload[first]))
+            ++first;
+        if(first == TX_PAYLOAD_LEN) // Already there
+            return;
+        while(transmit_payload[last-1] == loaded_payload[last-1])
+            --last;
+        AT86_patchTx(transmit_payload+first, last-first, first);
+    }
+    memcpy(loaded_payload+first, transmit_payload+first, last-first);
+    ++tx_uploads;
+}
+
+// This function has the AT86RF233 start transmitting a payload. onRadioDone is called once it has been transmitted. The transmission is
+// started by a timer raising SLP_TR at the scheduled time, so it starts on time to within a tick whatever the CPU is doing.
+//  from: timestamp the start of transmission is counted from.
+//  delay: how long after from to start transmitting (timestamp ticks), once the payload is loaded; 0 to start as soon as it is.
+void startTransmit(uint32_t from, uint32_t delay)
+{
+    if(mac) // Put the AT86RF233 in the appropriate state for transmission.
+        AT86_prepareTxAret();
+    else
+        AT86_prepareTx();
+    composePayload();
+    loadPayload(); // Prepare AT86RF233 to transmit payload by loading what changed of it into its transmit buffer while the PLL settles.
+    AT86_waitStatus(mac ? statusTX_ARET_ON : statusPLL_ON); // Wait until in appropriate state; the buffer writes have usually already seen it.
+    radio_done = false;
+    uint32_t now = TS_now();
+    uint32_t at = from + delay; // When to start
+    if(((now - from) > delay) || ((delay - (now - from)) < TX_LEAD_TICKS)) // Due already: start as soon as it can be scheduled.
+        at = now + TX_LEAD_TICKS;
+    if((at - now) > TX_AHEAD_TICKS) // Too far ahead for the timer: wait until it is within reach.
+        waitUntil(now, at - now - TX_AHEAD_TICKS);
+    radio_start = at; // Record when transmission starts, to see how long it took.
+    if(!AT86_execTxAt((uint16_t) at, onRadioDone)) // Transmit the payload at that time.
+        radio_start = TS_now(); // We were held up past it, and it started at once.
+}
+
+// This function reports a transmission that has completed. In MAC mode, it took from the start of the CSMA-CA algorithm to the ACK of the
+// last attempt, and its outcome is read back from the AT86RF233.
+void reportTransmit(void)
+{
+    uint32_t time = radio_end - radio_start; // Time it took to transmit.
+    uint8_t outcome = mac ? AT86_getTrac() : tracSUCCESS; // Whether the other board acknowledged it
+    uint8_t retries = mac ? AT86_getAretRetries() : 0;
+    GPIO_toggleOutputOnPin(MCU_LED1_PORT, MCU_LED1_PIN); // Toggle an LED, for debugging purposes.
+    PROTO_reportTx(transmit_payload[header_len], TS_TO_US(time), outcome, retries, AT86_getDataRate()); // Inform computer that we have transmitted a payload.
+}
+
+// This function has the AT86RF233 transmit a payload, and reports the transmission.
+//  from: timestamp the start of transmission is counted from.
+//  delay: how long after from to start transmitting (timestamp ticks), once the payload is loaded; 0 to start as soon as it is.
+void transmitPayload(uint32_t from, uint32_t delay)
+{
+    startTransmit(from, delay);
+    sleepUntil(&radio_done); // Sleep until the transmission has completed.
+    reportTransmit();
+}
+
+// This function has the AT86RF233 wait to receive a payload; phase measurements are taken from interrupts. onRadioDone is called once a
+// payload has been received. In MAC mode, the AT86RF233 drops frames that are not addressed to us or fail their FCS without waking us, and
+// acknowledges the others by itself.
+void startReceive(void)
+{
+    memset(received_payload, 0, TX_PAYLOAD_LEN); // Clear the static variable in which we will store received payload.
+    radio_done = false;
+    if(mac) // Have the AT86RF233 switch into the receive state
+        AT86_prepareRxAack(onRxStart, onRadioDone);
+    else
+        AT86_prepareRx(onRxStart, onRadioDone);
+}
+
+// This function retrieves a payload that has been received and reports it. Its phase measurements are then left to analyzeBlock.
+//  returns: true if the payload is one we sent, whose phase measurements should be analyzed.
+bool finishReceive(void)
+{
+    phases_idx = PHASE_stop(); // Number of phase measurements taken
+    uint32_t time = radio_end - radio_start; // Duration of reception
     AT86_readRx(received_payload, 4, 0); // Retrieve the payload received by the AT86RF233
+    if(mac)
+        AT86_readRx(received_payload+1, 3, 1+header_len); // Skip the MAC header, which the AT86RF233 has already checked
     if((received_payload[0] == TX_PAYLOAD_LEN) && (received_payload[1]==ADDRESS)) // Payload is expected length, and contained expected address
     {
         GPIO_toggleOutputOnPin(MCU_LED1_PORT, MCU_LED1_PIN); // Toggle an LED for debugging purposes
-        char msg[64]; // Store retrieved payload
-        sprintf(msg, "(valid RX) Length: %d, Address: 0x%x, Time: %d us\n", received_payload[0], received_payload[1], (1000000UL*time)/32768UL);
-        VCOM_tx((uint8_t *)msg, strlen(msg)); // Inform computer of the received payload and reception duration
+        PROTO_reportRx(true, received_payload, TS_TO_US(time), AT86_getDataRate()); // Inform computer of the received payload and reception duration
+        FIT_reset();
+        analysis_first = 0;
+        return true;
+    }
+    // Sometimes the AT86RF233 receives garbage payloads that we did not send. We can tell this is the case when the payload is not the expected length and/or does not contain the expected address.
+    PROTO_reportRx(false, received_payload, TS_TO_US(time), AT86_getDataRate()); // Inform the computer that we got a garbage payload
+    return false;
+}
+
+// This function adds the next block of phase measurements of a reception to the fitted line, informing computer of the block unless it
+// only wants the line. After the last block, it reports the line.
+//  returns: true if there are blocks left.
+bool analyzeBlock(void)
+{
+    if(analysis_first < phases_idx)
+    {
+        uint16_t count = ((phases_idx-analysis_first) < PROTO_PHASES_PER_FRAME) ? (phases_idx-analysis_first) : PROTO_PHASES_PER_FRAME; // Measurements in this block
         uint16_t idx;
-        for(idx=0; idx<phases_idx; ++idx) // Inform computer of the phase measurements taken during reception
+        for(idx=analysis_first; idx<analysis_first+count; ++idx)
+            FIT_add(phases[idx], phase_times[idx]); // Done while the previous block is still being transmitted
+        if(!summary)
+            PROTO_reportPhases(analysis_first, &phases[analysis_first], &phase_times[analysis_first], count); // Phases and their times (timer ticks after reception started)
+        analysis_first += count;
+        if(analysis_first < phases_idx)
+            return true;
+    }
+    FIT_Line line;
+    FIT_get(&line);
+    PROTO_reportFit(&line); // Inform computer of the fitted line
+    return false;
+}
+
+// This function has the AT86RF233 wait to receive a payload, then retrieves the payload and reports it with its phase measurements.
+//  from: timestamp the deadline is counted from.
+//  ticks: how long after from to give up (timestamp ticks), or 0 to wait as long as it takes.
+//  returns: false, with nothing reported, if the deadline passed before a payload was received.
+bool receivePayload(uint32_t from, uint32_t ticks)
+{
+    startReceive();
+    if(ticks == 0)
+        sleepUntil(&radio_done); // Sleep until the AT86RF233 is done receiving.
+    else
+    {
+        while(!radio_done && ((TS_now() - from) < ticks)) // Nothing wakes us up at the deadline, so watch the timer,
+            PROTO_poll(); // acknowledging the commands that arrive in the meantime.
+        AT86_cancel(); // Stop listening; from here on radio_done can't change.
+    }
+    if(!radio_done)
+    {
+        PHASE_stop(); // A payload may have started without ending in time.
+        return false;
+    }
+    if(finishReceive())
+        while(analyzeBlock());
+    return true;
+}
+
+// This function measures how many bytes per second each kind of SPI transaction moves between the MSP430 and the AT86RF233, counting the
+// command and address bytes, and reports the results to the computer. The frame buffer contents are overwritten.
+void benchmarkSpi(void)
+{
+    static const uint8_t bytes[benchCOUNT] = {2, 2, 1, BENCH_LEN+2, BENCH_LEN+2, BENCH_LEN+1}; // Bytes on the bus per transaction
+    static uint8_t buffer[BENCH_LEN]; // Data for the buffer transactions
+    uint8_t short_addr = REG_read(REG__SHORT_ADDR_0); // Register we write to, restored to its value by every write
+    AT86_forgetTx(); // The payload to transmit won't be in the frame buffer any more.
+    uint8_t bench;
+    for(bench=0; bench<benchCOUNT; ++bench)
+    {
+        uint32_t start = TS_now(); // Record when the transactions started, to see how long they take.
+        uint16_t iteration;
+        for(iteration=0; iteration<BENCH_ITERATIONS; ++iteration)
+        {
+            switch(bench)
+            {
+            case benchREG_READ:
+                REG_read(REG__TRX_STATUS);
+                break;
+            case benchREG_WRITE:
+                REG_write(REG__SHORT_ADDR_0, short_addr);
+                break;
+            case benchREG_STATUS:
+                REG_status();
+                break;
+            case benchSRAM_READ:
+                SRAM_read(0, buffer, BENCH_LEN);
+                break;
+            case benchSRAM_WRITE:
+                SRAM_write(0, buffer, BENCH_LEN);
+                break;
+            default:
+                FB_read(buffer, BENCH_LEN);
+                break;
+            }
+        }
+        uint32_t time = TS_now() - start; // Record how long the transactions took, in timestamp ticks.
+        if(time == 0)
+            time = 1;
+        uint32_t total = (uint32_t) bytes[bench]*BENCH_ITERATIONS; // Bytes moved
+        PROTO_reportBench(bench, bytes[bench], BENCH_ITERATIONS, TS_TO_US(time), ((uint64_t) total*TS_FREQ)/time); // Report the throughput of this kind of transaction
+    }
+}
+
+// This function switches the VCOM link to a new baud rate, once everything sent so far has gone out at the old one. The computer has to
+// confirm the rate by sending the same msgBAUD command again at it within VCOM_BAUD_CONFIRM_MS; any other frame is rejected with msgERROR,
+// frameBUSY if it was intact. Without confirmation, e.g. because the computer or a USB bridge cannot keep up, we go back to
+// VCOM_BAUD_DEFAULT, where the computer can find us again. msgDONE is then sent at whichever rate is in use.
+//  baud: rate to switch to.
+void changeBaud(uint32_t baud)
+{
+    if(!VCOM_setBaud(baud)) // SMCLK is too slow to generate that rate; keep the one we have.
+        return;
+    bool confirmed = false;
+    uint32_t start = TS_now(); // Record when we switched, so we can tell when the computer has run out of time.
+    while(!confirmed && ((TS_now() - start) < TS_US(VCOM_BAUD_CONFIRM_MS*1000UL)))
+    {
+        if(VCOM_rxAvailable())
         {
-            sprintf(msg, "%x\n", phases[idx]);
-            while(VCOM_isTransmitting()); // Wait for pending VCOM transmissions to end
-            VCOM_tx((uint8_t *) msg, strlen(msg)); // Transmit the next measurement
+            PROTO_Cmd cmd;
+            PROTO_Frame_Enum check = PROTO_receive(&cmd);
+            confirmed = (check == frameOK) && (cmd.type == msgBAUD) && (PROTO_get32(cmd.args) == baud);
+            if(!confirmed) // Don't let its sequence ID vanish: the computer can send it again once msgDONE has come.
+                PROTO_error((check == frameOK) ? frameBUSY : check, cmd.seq);
         }
-        sprintf(msg, "done\n"); // Indicate all measurements have been transmitted to computer
-        while(VCOM_isTransmitting());
-        VCOM_tx((uint8_t *)msg, strlen(msg));
     }
-    else // Sometimes the AT86RF233 receives garbage payloads that we did not send. We can tell this is the case when the payload is not the expected length and/or does not contain the expected address.
+    if(!confirmed)
+        VCOM_setBaud(VCOM_BAUD_DEFAULT);
+}
+
+// This function chooses whether payloads are sent as acknowledged IEEE 802.15.4 data frames, through the CSMA-CA, retransmissions, ACKs and
+// address filtering the AT86RF233 carries out by itself in its extended operating mode, or as bare frames. Both boards need the same mode,
+// each with the other's short address.
+//  enable: true for MAC mode.
+//  own: our short address.
+//  peer: short address of the other board, the destination of our frames.
+//  retries: retransmissions of a frame that is not acknowledged, 0 to 15.
+void setMac(bool enable, uint16_t own, uint16_t peer, uint8_t retries)
+{
+    mac = enable;
+    header_len = enable ? MAC_HEADER_LEN : 0;
+    mac_own = own;
+    mac_peer = peer;
+    AT86_setPan(MAC_PAN_ID); // Address filter of RX_AACK_ON
+    AT86_setAddrShort(own);
+    AT86_setCsmaSeed(own); // Keeps the backoffs of the two boards apart
+    AT86_setRetries(retries, MAC_CSMA_RETRIES);
+}
+
+// This function changes the data rate of the PSDU of the frames the AT86RF233 transmits and receives. Both boards need the same one. At the
+// higher rates a payload spends less time on the air, so phase measurements are taken as often as they can be to keep as many of them as
+// the PMU updates; msgPERIOD can still change that afterwards.
+//  rate: data rate.
+//  scrambler: whether the PSDU is scrambled at the rates above 250 kb/s.
+void setRate(AT86_Rate_Enum rate, bool scrambler)
+{
+    AT86_setDataRate(rate, scrambler);
+    PHASE_setPeriod((rate == rate250KBPS) ? PHASE_PERIOD_DEFAULT : PHASE_PERIOD_HDR);
+}
+
+// This function returns the time from the start of a transmission to the end of its payload on the air at the current data rate, in
+// timestamp ticks.
+uint32_t airTicks(void)
+{
+    return TS_US(TX_START_US + AT86_getAirtime(TX_PAYLOAD_LEN));
+}
+
+// This function is called by the AT86RF233 driver from its interrupt handler when a frame of a burst has been sent. It has the next one
+// start a spacing after it, from a timer edge, before anything else can hold it up.
+void onBurstDone(AT86_Irq_Enum irqs)
+{
+    radio_end = TS_now(); // Record when it ended.
+    if(irqs & irqTRX_UR)
+        ++burst_underruns;
+    if(mac && (AT86_getTrac() != tracSUCCESS)) // Before the next transaction resets it
+        ++burst_failures;
+    if(burst_done+1 < burst_frames) // Start the next frame; its new bytes are written while its SHR goes out.
+        AT86_execTxAt((uint16_t) (radio_end + burst_ifs), onBurstDone);
+    ++burst_done;
+}
+
+// This function sleeps until a number of frames of the ongoing burst have been sent.
+//  count: number of frames.
+void waitBurst(uint16_t count)
+{
+    __disable_interrupt(); // Don't let a frame end between checking the count and going to sleep.
+    while(burst_done < count)
+    {
+        if(VCOM_rxAvailable()) // The computer sent another command; it is woken up for.
+        {
+            __enable_interrupt();
+            PROTO_poll();
+        }
+        else
+            __bis_SR_register(LPM0_bits + GIE); // Sleep until an interrupt handler wakes us up.
+        __disable_interrupt();
+    }
+    __enable_interrupt();
+}
+
+// This function transmits a burst of frames back to back for the computer to measure the frame rate with: each frame starts a set spacing
+// after the end of the previous one, from a timer edge armed by the interrupt handler at its TRX_END. The payload stays in the frame buffer
+// of the AT86RF233, and only the bytes that change (the sequence number in MAC mode) are written again. The next payload is composed in
+// transmit_payload while the current one is on the air, and its new bytes written once the current one has left the buffer, while the SHR of
+// the next goes out; a frame whose bytes were written too late goes out with TRX_UR and is counted as an underrun. The burst is reported once
+// it is over.
+//  frames: frames to send.
+//  ifs_us: time from the end of a frame to the start of the next (us), at most BURST_MAX_IFS_US; below AT86_TX_AT_MIN_LEAD, the next frame
+//   starts as soon as the previous one has ended.
+void burst(uint16_t frames, uint32_t ifs_us)
+{
+    uint16_t uploads = tx_uploads;
+    burst_ifs = TS_US((ifs_us < BURST_MAX_IFS_US) ? ifs_us : BURST_MAX_IFS_US);
+    burst_frames = frames;
+    burst_done = 0;
+    burst_underruns = 0;
+    burst_failures = 0;
+    if(frames == 0)
+        return;
+    if(mac) // Put the AT86RF233 in the appropriate state for transmission.
+        AT86_prepareTxAret();
+    else
+        AT86_prepareTx();
+    composePayload();
+    loadPayload();
+    AT86_waitStatus(mac ? statusTX_ARET_ON : statusPLL_ON); // Wait until in appropriate state
+    uint32_t start = TS_now() + TX_LEAD_TICKS; // Record when the burst starts, to see how long it took.
+    if(!AT86_execTxAt((uint16_t) start, onBurstDone))
+        start = TS_now();
+    uint16_t frame;
+    for(frame=1; frame<frames; ++frame)
     {
-        char msg[64]; // Inform the computer that we got a garbage payload
-        sprintf(msg, "(invalid RX) Length: %d, Address: 0x%x, Payload: 0x%x\n", received_payload[0], received_payload[1], received_payload[2]);
-        VCOM_tx((uint8_t *)msg, strlen(msg));
+        composePayload(); // While the previous frame is on the air
+        waitBurst(frame); // The previous frame is out of the buffer, and this one has been started.
+        loadPayload();
     }
+    waitBurst(frames);
+    PROTO_reportBurst(frames, burst_underruns, burst_failures, tx_uploads - uploads, TS_TO_US(radio_end - start), AT86_getDataRate());
 }
 
-// This function interprets a command from the computer, and calls the appropriate function.
-void parseCmd(void)
+// This function walks a plan of center frequencies without the computer: at each frequency in turn, lowest first, it transmits or receives a
+// number of payloads, reporting each slot of the schedule and then the transmission or reception in it. The two boards stay in step by
+// keeping to the gap they were both given: the transmitter starts each payload a gap after the end of the previous one, and the receiver,
+// which moves to the next slot as soon as a payload has ended, gives up on a slot half a gap after its payload should have ended. The gap
+// must leave the receiver time to report a reception, and in MAC mode cover the CSMA-CA backoff and the ACK as well, which delay the end of a
+// transmission but not that of the reception. The receiving board has to be started first. If the first payload doesn't arrive within
+// SWEEP_START_TICKS, the transmitting board was never started, and the sweep ends there.
+//  base: frequency of the plan to start from (MHz).
+//  step: spacing of the frequencies of the plan (MHz).
+//  points: frequencies to visit, bit n standing for base + n steps. Those outside AT86_FREQ_MIN to AT86_FREQ_MAX are skipped.
+//  gap_us: time between the end of a payload and the start of the next (us), at most SWEEP_MAX_GAP_US.
+//  reps: payloads per frequency.
+//  role: whether we transmit or receive.
+void sweep(uint16_t base, uint8_t step, uint32_t points, uint32_t gap_us, uint8_t reps, Sweep_Enum role)
 {
-    char * s = VCOM_getRxString(); // Read an ASCII string from the computer
-    char msg[2] = "\n"; // Acknowledgement string to return to computer
-    VCOM_tx((uint8_t *) msg, 1); // Send acknowledgement string
-    if(!strcmp(s, TRANSMIT)) // We got the transmit command
-        transmitPayload(); // Have AT86RF233 transmit the payload
-    else if(!strcmp(s, RECEIVE)) // We got the receive command
-        receivePayload(); // Have the AT86RF233 wait to receive a payload
-    else if(!strcmp(s, CHANNEL)) // We got the set channel command
+    uint32_t gap = TS_US((gap_us < SWEEP_MAX_GAP_US) ? gap_us : SWEEP_MAX_GAP_US); // In timestamp ticks
+    uint32_t slot = gap + airTicks(); // Time from the end of one payload to the end of the next
+    bool first = true;
+    uint32_t end = 0; // Timestamp of the end of the previous payload
+    if((TS_now64() - pll_cal_time) > PLL_CAL_MAX_AGE) // The PLL may have drifted from its calibrations: run them again.
     {
-        while(!VCOM_rxAvailable()); // Wait until we get a string specifying the new channel
-        s = VCOM_getRxString(); // Retrieve that string
-        int channel;
-        sscanf(s, "%d\n", &channel); // Parse it to determine the channel
-        channel = channel&0x1F; // Make sure channel is only 5 bits
-        AT86_setChan(channel); // Tell AT86RF233 to change to that channel
+        AT86_calibratePll();
+        pll_cal_time = TS_now64();
     }
-    else // We got an invalid command
+    uint8_t point;
+    for(point=0; point<32; ++point)
     {
-        VCOM_tx((uint8_t *)s, strlen(s)); // Send the command back for debugging purposes
-        assert(false); // Abort execution of firmware
+        uint32_t freq = base + (uint32_t) point*step;
+        if(!(points & (1UL << point)) || (freq < AT86_FREQ_MIN) || (freq > AT86_FREQ_MAX))
+            continue;
+        uint32_t hop_start = TS_now(); // Record when the hop started, to see how long it took.
+        bool locked = AT86_hopFreq(freq); // Returns once the PLL has locked on the frequency, or has failed to
+        uint16_t hop = locked ? TS_TO_US(TS_now() - hop_start) : PROTO_HOP_FAILED; // The slots go ahead anyway, to stay in step with the other board.
+        uint8_t rep;
+        for(rep=0; rep<reps; ++rep)
+        {
+            PROTO_reportSlot(freq, rep, (rep == 0) ? hop : 0);
+            if(role == sweepTRANSMIT)
+            {
+                transmitPayload(end, first ? 0 : gap);
+                end = radio_end;
+            }
+            else if(receivePayload(first ? TS_now() : end, first ? SWEEP_START_TICKS : slot + gap/2))
+                end = radio_end;
+            else if(first) // Nobody is transmitting.
+                return;
+            else
+                end += slot; // When the payload we missed should have ended
+            first = false;
+        }
     }
 }
 
+// This function reports the runtime accounting of each task and of the time spent asleep, and starts it over. The run of taskCOMMANDS that
+// carries out this command is not counted.
+void reportStats(void)
+{
+    SCHED_Stats stats;
+    uint8_t task;
+    for(task=0; task<taskCOUNT; ++task)
+    {
+        SCHED_getStats(task, &stats);
+        PROTO_reportTask(task, &stats);
+    }
+    SCHED_getStats(SCHED_IDLE, &stats);
+    PROTO_reportTask(SCHED_IDLE, &stats);
+    SCHED_resetStats();
+}
+
+// This function starts carrying out a command from the computer, which has already been acknowledged. Transmissions and receptions are only
+// started: taskRADIO takes over once they have completed, and the CPU is free for other tasks in the meantime. Other commands are carried
+// out here.
+//  cmd: the command.
+//  returns: true if the command has completed.
+bool startCmd(const PROTO_Cmd * cmd)
+{
+    switch(cmd->type)
+    {
+    case msgTRANSMIT: // We got the transmit command
+        radio_async = true;
+        startTransmit(TS_now(), 0); // Have AT86RF233 transmit the payload
+        return false;
+    case msgRECEIVE: // We got the receive command
+        radio_async = true;
+        startReceive(); // Have the AT86RF233 wait to receive a payload
+        return false;
+    case msgCHANNEL: // We got the set channel command
+        AT86_hopChan(cmd->args[0]); // Tell AT86RF233 to change to that channel, if it is one of the 2.4 GHz band, and wait until it has locked on it
+        break;
+    case msgPERIOD: // We got the set phase measurement period command
+    {
+        uint32_t period_ns = PROTO_get32(cmd->args); // Period in ns
+        uint32_t period = (period_ns*(PHASE_TIMER_FREQ/1000000UL)+500UL)/1000UL; // Convert to timer ticks
+        PHASE_setPeriod((period > 0xFFFF) ? 0xFFFF : period); // Out-of-range periods are clamped
+        break;
+    }
+    case msgSUMMARY: // We got the reporting mode command
+        summary = (cmd->args[0] != 0);
+        break;
+    case msgBENCHMARK: // We got the SPI benchmark command
+        benchmarkSpi(); // Measure and report the SPI throughput
+        break;
+    case msgBAUD: // We got the change baud rate command
+        changeBaud(PROTO_get32(cmd->args)); // Switch to that rate if the computer confirms it
+        break;
+    case msgSWEEP: // We got the frequency sweep command
+        sweep(PROTO_get16(cmd->args), cmd->args[2], PROTO_get32(cmd->args+3), PROTO_get32(cmd->args+7), cmd->args[11], (cmd->args[12] != 0) ? sweepRECEIVE : sweepTRANSMIT); // Walk the plan, reporting as we go
+        break;
+    case msgSTATS: // We got the runtime accounting command
+        reportStats();
+        break;
+    case msgRATE: // We got the data rate command
+        setRate((AT86_Rate_Enum) (cmd->args[0]&0x03), cmd->args[1] != 0); // Only 4 rates
+        break;
+    case msgFREQUENCY: // We got the set frequency command
+        AT86_hopFreq(PROTO_get16(cmd->args)); // Tell AT86RF233 to tune to that frequency and wait until it has locked on it
+        break;
+    case msgBURST: // We got the burst transmit command
+        burst(PROTO_get16(cmd->args), PROTO_get32(cmd->args+2)); // Send the frames, then report the burst
+        break;
+    case msgMAC: // We got the MAC mode command
+        setMac(cmd->args[0] != 0, PROTO_get16(cmd->args+1), PROTO_get16(cmd->args+3), cmd->args[5]&0x0F); // Retries are only 4 bits
+        break;
+    default: // PROTO_poll only queues commands.
+        break;
+    }
+    return true;
+}
+
+// This function tells the computer that the current command has completed, and lets the next one start.
+void finishCmd(void)
+{
+    PROTO_done(&current); // Indicate everything about the command has been transmitted to computer
+    cmd_running = false;
+    SCHED_post(taskCOMMANDS);
+}
+
+// Task that acknowledges and queues the commands that have arrived, and starts the oldest one once the previous has completed. Commands
+// are carried out one at a time, in the order they arrived. Posted whenever a frame arrives and whenever a command completes.
+void commandsTask(void)
+{
+    PROTO_poll(); // Acknowledge and queue the commands that have arrived
+    if(!cmd_running && PROTO_next(&current)) // Start the oldest one
+    {
+        cmd_running = true;
+        if(startCmd(&current))
+            finishCmd();
+    }
+}
+
+// Task that reports the transmission or reception of the current command. Posted by onRadioDone.
+void radioTask(void)
+{
+    radio_async = false;
+    if(current.type == msgTRANSMIT)
+    {
+        reportTransmit();
+        finishCmd();
+    }
+    else if(finishReceive()) // The phase measurements are analyzed next, leaving room for commands to be acknowledged between blocks.
+        SCHED_post(taskANALYSIS);
+    else
+        finishCmd();
+}
+
+// Task that analyzes a block of phase measurements of the current reception, then posts itself again until every block has been.
+void analysisTask(void)
+{
+    if(analyzeBlock())
+        SCHED_post(taskANALYSIS);
+    else
+        finishCmd();
+}
+
+// This function is called by VCOM from an interrupt handler when a frame from the computer has arrived.
+void onFrame(void)
+{
+    SCHED_post(taskCOMMANDS);
+}
+
 void main(void)
 {
+    static const SCHED_Task tasks[taskCOUNT] = {radioTask, commandsTask, analysisTask}; // Indexed by Task_Enum
+
     // Initialize the necessary MSP peripherals and the AT86RF233
     init();
 
@@ -162,10 +724,8 @@ void main(void)
     uint16_t man_id = AT86_getManId();
     assert(man_id == 0x001F);
 
-    while(1)
-    {
-        if(VCOM_rxAvailable()) // Wait for a command from the computer
-            parseCmd(); // Execute the command
-    }
-
+    SCHED_init(tasks, taskCOUNT);
+    VCOM_setRxHandler(onFrame); // Frames from the computer have taskCOMMANDS run
+    SCHED_post(taskCOMMANDS); // in case some arrived during initialization.
+    SCHED_run();
 }
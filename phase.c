@@ -0,0 +1,289 @@
+/*
+ * phase.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// This file contains functions that take phase measurements from the AT86RF233 at a fixed, known period. The AT86RF233 updates PHY_PMU_VALUE
+// every 8 us during reception; reading it from a busy loop gives samples at whatever spacing the loop happens to run at. Sampling is started
+// from the RX_START interrupt, so that the measurements are aligned to the start of the reception, and is done in one of two ways:
+//  PHASE_DMA = 0: a compare register of a free-running timer interrupts at exact multiples of the sample period, and the interrupt handler
+//   reads the register and records when it did so. Each measurement costs an interrupt and a register read, about 11 us of CPU time.
+//  PHASE_DMA = 1: the CPU is not involved at all. Two timers run in up/down mode with the sample period, so that the CCR2 of each matches
+//   twice per period, symmetrically around the middle of the period. The matches of one timer have a DMA channel pull SS low and back high;
+//   those of the other have a second channel write the read command and then the filler byte into the SPI transmit buffer, in the middle of
+//   that window. A third channel stores both bytes received. The CPU may sleep throughout.
+
+#include "phase.h" // Declarations of functions/macros in this file
+#include "at86.h" // Low-level control of AT86RF233
+#include "registers.h" // AT86RF233 register addresses and SPI access functions
+#include "hal.h" // Definitions of pins, peripheral initialization details, etc.
+#include "timer_a.h" // TI-provided file to control MSP430 hardware timer
+#if PHASE_DMA
+#include "dma.h" // TI-provided file to control MSP430 DMA controller
+#include "gpio.h" // TI-provided file to control MSP430 GPIO pins
+#include "usci_b_spi.h" // TI-provided file to control MSP430 SPI module
+#include "vcom.h" // Low-level control of UART to talk to computer, whose DMA channel we borrow
+#endif
+
+#define PHASE_TIMER_R HWREG16(PHASE_TIMER_BASE + OFS_TAxR) // Timer count. The timer runs from SMCLK like the CPU, so it can be read directly.
+
+static volatile uint8_t * sample_phases; // Buffer in which to store phase measurements
+static volatile uint16_t * sample_times; // Buffer in which to store the time of each phase measurement (timer ticks after sampling started)
+static volatile uint16_t sample_len = 0; // Size of the above buffers
+static volatile uint16_t sample_idx = 0; // Index of above buffers
+static volatile bool sampling = false; // Whether phase measurements are being taken
+static uint16_t sample_period = PHASE_PERIOD_DEFAULT; // Time (timer ticks) between phase measurements
+#if PHASE_DMA
+static uint16_t sample_lead; // Time (timer ticks) from the event measurement times count from to the start of sampling
+#define CAPTURE_SS_LEAD (1U) // Timer ticks from the start and to the end of each period at which SS goes low and high again
+
+static uint8_t ss_levels[2]; // Values the SS channel writes to the SS port: selected, then unselected
+static const uint8_t read_cmd[2] = {REG__PHY_PMU_VALUE|0x80, 0x00}; // Values the transmit channel writes to the SPI transmit buffer: read command, then filler
+
+static void _initCaptureTimer(uint16_t base);
+static void _initChannel(uint8_t channel, uint8_t trigger, uint16_t mode, uint16_t size);
+static void _reclaimBus(void);
+#else
+static uint16_t start_time; // Timer count when sampling was started
+static uint16_t next_time; // Timer count at which the next phase measurement is due
+#endif
+
+// This function initializes the timers that pace phase measurements. With PHASE_DMA = 0, the timer is the one timestamps are taken from,
+// which TS_init must have started; its count is the time base of the measurement timestamps.
+void PHASE_init(void)
+{
+#if PHASE_DMA
+    _initCaptureTimer(PHASE_SS_TIMER_BASE);
+    _initCaptureTimer(PHASE_TX_TIMER_BASE);
+#else
+    Timer_A_initCompareModeParam compare_settings = // Compare register that will interrupt when a measurement is due
+    {
+     .compareRegister = TIMER_A_CAPTURECOMPARE_REGISTER_0,
+     .compareInterruptEnable = TIMER_A_CAPTURECOMPARE_INTERRUPT_DISABLE,
+     .compareOutputMode = TIMER_A_OUTPUTMODE_OUTBITVALUE,
+     .compareValue = 0
+    };
+    Timer_A_initCompareMode(PHASE_TIMER_BASE, &compare_settings);
+#endif
+}
+
+// This function sets the time between phase measurements. It takes effect the next time sampling is started.
+//  period: time in timer ticks (PHASE_TIMER_FREQ), from PHASE_PERIOD_MIN to half the timer range. Values outside that range are clamped. With
+//   PHASE_DMA = 1 it is rounded down to an even number, since the timers count up and back down in one period.
+void PHASE_setPeriod(uint16_t period)
+{
+    if(period < PHASE_PERIOD_MIN)
+        period = PHASE_PERIOD_MIN;
+    else if(period > 0x7FFF) // Keeps "is the next slot in the past" decidable from a 16-bit difference
+        period = 0x7FFF;
+#if PHASE_DMA
+    period &= ~1U;
+#endif
+    sample_period = period;
+}
+
+// This function returns the time (timer ticks) between phase measurements.
+uint16_t PHASE_getPeriod(void)
+{
+    return sample_period;
+}
+
+// This function starts taking phase measurements, one every period until the buffers are full or PHASE_stop is called. It is meant to be
+// called from the RX_START callback of the AT86RF233 driver, with the time elapsed since the SFD of the frame, so that the measurements are
+// timed from the start of the reception.
+// With PHASE_DMA = 0 the first measurement is taken one period from now. While sampling, the CPU must not start DMA bursts over SPI (SRAM and
+// frame buffer accesses of AT86_SPI_DMA_MIN_LEN bytes or more), as the timer interrupt handler does SPI transactions of its own.
+// With PHASE_DMA = 1 the first measurement is taken half a period from now. The SPI bus is lent out until PHASE_stop is called; any other
+// access to the AT86RF233, such as the IRQ_STATUS read at the end of the reception, stops sampling first. The AT86RF233 IRQ pin interrupt
+// handler is the only code that may change the outputs of the SS port in the meantime.
+//  phases: buffer in which to store phase measurements.
+//  times: buffer in which to store the time of each measurement, in timer ticks after the event lead refers to. With PHASE_DMA = 1, it
+//   holds the bytes received until PHASE_stop sorts them out.
+//  len: size of both buffers.
+//  lead: time (timer ticks) from the event measurement times count from to this call, or 0 to count them from this call.
+void PHASE_start(volatile uint8_t * phases, volatile uint16_t * times, uint16_t len, uint16_t lead)
+{
+    uint16_t gie = __get_interrupt_state(); // Interrupt state to return to.
+    __disable_interrupt(); // Don't take the compare interrupt until everything is set up.
+    sample_phases = phases;
+    sample_times = times;
+    sample_len = len;
+    sample_idx = 0;
+    sampling = (len != 0);
+#if PHASE_DMA
+    if(sampling)
+    {
+        sample_lead = lead;
+        uint16_t half = sample_period/2; // Count at the middle of each period
+        Timer_A_setCompareValue(PHASE_SS_TIMER_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_0, half);
+        Timer_A_setCompareValue(PHASE_SS_TIMER_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_2, CAPTURE_SS_LEAD); // SS low just after the start, high just before the end
+        Timer_A_setCompareValue(PHASE_TX_TIMER_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_0, half);
+        Timer_A_setCompareValue(PHASE_TX_TIMER_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_2, half-1); // Command 1 tick before the middle, filler 1 tick after
+        Timer_A_clear(PHASE_SS_TIMER_BASE);
+        Timer_A_clear(PHASE_TX_TIMER_BASE);
+
+        uint8_t out = HWREG8(AT86_SS_OUT_ADDR); // Leave the other pins of the SS port as they are
+        ss_levels[0] = out & ~AT86_SS_PIN;
+        ss_levels[1] = out | AT86_SS_PIN;
+#if VCOM_DMA
+        VCOM_lendDma(); // VCOM carries on a byte per interrupt meanwhile.
+#endif
+        _initChannel(PHASE_SS_DMA_CHANNEL, PHASE_SS_DMA_TRIGGER, DMA_TRANSFER_REPEATED_SINGLE, 2);
+        DMA_setSrcAddress(PHASE_SS_DMA_CHANNEL, (uintptr_t) ss_levels, DMA_DIRECTION_INCREMENT);
+        DMA_setDstAddress(PHASE_SS_DMA_CHANNEL, AT86_SS_OUT_ADDR, DMA_DIRECTION_UNCHANGED);
+        _initChannel(PHASE_TX_DMA_CHANNEL, PHASE_TX_DMA_TRIGGER, DMA_TRANSFER_REPEATED_SINGLE, 2);
+        DMA_setSrcAddress(PHASE_TX_DMA_CHANNEL, (uintptr_t) read_cmd, DMA_DIRECTION_INCREMENT);
+        DMA_setDstAddress(PHASE_TX_DMA_CHANNEL, USCI_B_SPI_getTransmitBufferAddressForDMA(AT86_SPI_BASE), DMA_DIRECTION_UNCHANGED);
+        _initChannel(PHASE_RX_DMA_CHANNEL, PHASE_RX_DMA_TRIGGER, DMA_TRANSFER_SINGLE, 2*len); // PHY_STATUS byte and PHY_PMU_VALUE of each read
+        DMA_setSrcAddress(PHASE_RX_DMA_CHANNEL, USCI_B_SPI_getReceiveBufferAddressForDMA(AT86_SPI_BASE), DMA_DIRECTION_UNCHANGED);
+        DMA_setDstAddress(PHASE_RX_DMA_CHANNEL, (uintptr_t) times, DMA_DIRECTION_INCREMENT);
+        DMA_enableTransfers(PHASE_SS_DMA_CHANNEL);
+        DMA_enableTransfers(PHASE_TX_DMA_CHANNEL);
+        DMA_enableTransfers(PHASE_RX_DMA_CHANNEL);
+        REG_lendBus(_reclaimBus);
+
+        Timer_A_startCounter(PHASE_TX_TIMER_BASE, TIMER_A_UPDOWN_MODE); // Transmit timer first: the time it takes to start the other one only
+        Timer_A_startCounter(PHASE_SS_TIMER_BASE, TIMER_A_UPDOWN_MODE); // delays the SS edges, and there is half a period of slack for that.
+    }
+#else
+    uint16_t now = PHASE_TIMER_R;
+    start_time = now - lead; // Measurement times are counted from the event lead refers to
+    next_time = now + sample_period;
+    Timer_A_setCompareValue(PHASE_TIMER_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_0, next_time);
+    Timer_A_clearCaptureCompareInterrupt(PHASE_TIMER_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_0);
+    if(sampling)
+        Timer_A_enableCaptureCompareInterrupt(PHASE_TIMER_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_0);
+#endif
+    __set_interrupt_state(gie);
+}
+
+// This function stops taking phase measurements. With PHASE_DMA = 1 it waits for a register read in progress to finish, leaves SS high, and
+// moves the measurements out of the times buffer. Calling it again has no effect.
+// Returns the number of measurements stored in the buffers.
+uint16_t PHASE_stop(void)
+{
+#if PHASE_DMA
+    uint16_t gie = __get_interrupt_state(); // Interrupt state to return to.
+    __disable_interrupt(); // Don't let anything use the SPI bus until it is left in a clean state.
+    if(sampling)
+    {
+        Timer_A_stop(PHASE_TX_TIMER_BASE);
+        Timer_A_stop(PHASE_SS_TIMER_BASE);
+        DMA_disableTransfers(PHASE_TX_DMA_CHANNEL);
+        DMA_disableTransfers(PHASE_SS_DMA_CHANNEL);
+#if VCOM_DMA
+        VCOM_reclaimDma(); // Give the SS channel back.
+#endif
+        while(USCI_B_SPI_isBusy(AT86_SPI_BASE)); // Let the receive channel store the bytes still on the bus
+        uint16_t received = 2*sample_len; // Bytes the receive channel stored
+        if(DMA_getInterruptStatus(PHASE_RX_DMA_CHANNEL) != DMA_INT_ACTIVE) // Buffer is not full
+            received -= DMA_getTransferSize(PHASE_RX_DMA_CHANNEL);
+        DMA_disableTransfers(PHASE_RX_DMA_CHANNEL);
+        DMA_clearInterrupt(PHASE_RX_DMA_CHANNEL);
+        GPIO_setOutputHighOnPin(AT86_SS_PORT, AT86_SS_PIN); // End a read that was cut short
+        USCI_B_SPI_receiveData(AT86_SPI_BASE); // Leave the receive flag clear for the next transaction
+
+        const volatile uint8_t * raw = (const volatile uint8_t *) sample_times; // Bytes received, two per measurement
+        uint16_t first = sample_lead + sample_period/2 - 1; // Time at which the first read command was written
+        sample_idx = received/2; // A read cut short after its PHY_STATUS byte doesn't count
+        uint16_t idx;
+        for(idx=0; idx<sample_idx; ++idx) // Measurement idx is read from bytes 2*idx and 2*idx+1 before the time of measurement idx overwrites them
+        {
+            sample_phases[idx] = raw[2*idx+1];
+            sample_times[idx] = first + idx*sample_period;
+        }
+        sampling = false;
+    }
+    __set_interrupt_state(gie);
+#else
+    Timer_A_disableCaptureCompareInterrupt(PHASE_TIMER_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_0);
+    sampling = false;
+#endif
+    return sample_idx;
+}
+
+// This function indicates whether phase measurements are being taken (true = yes).
+bool PHASE_isSampling(void)
+{
+#if PHASE_DMA
+    return sampling && (DMA_getInterruptStatus(PHASE_RX_DMA_CHANNEL) != DMA_INT_ACTIVE);
+#else
+    return sampling;
+#endif
+}
+
+#if PHASE_DMA
+// This function sets up a timer that paces DMA phase measurements. It is started by PHASE_start, in up/down mode with the sample period.
+//  base: base address of the timer.
+static void _initCaptureTimer(uint16_t base)
+{
+    Timer_A_initUpDownModeParam timera_settings =
+    {
+     .clockSource = TIMER_A_CLOCKSOURCE_SMCLK,
+     .clockSourceDivider = PHASE_TIMER_DIVIDER,
+     .timerPeriod = PHASE_PERIOD_DEFAULT/2,
+     .timerInterruptEnable_TAIE = TIMER_A_TAIE_INTERRUPT_DISABLE,
+     .captureCompareInterruptEnable_CCR0_CCIE = TIMER_A_CCIE_CCR0_INTERRUPT_DISABLE,
+     .timerClear = TIMER_A_DO_CLEAR,
+     .startTimer = false
+    };
+    Timer_A_initUpDownMode(base, &timera_settings);
+    Timer_A_initCompareModeParam compare_settings = // Compare register whose matches trigger the DMA channel
+    {
+     .compareRegister = TIMER_A_CAPTURECOMPARE_REGISTER_2,
+     .compareInterruptEnable = TIMER_A_CAPTURECOMPARE_INTERRUPT_DISABLE,
+     .compareOutputMode = TIMER_A_OUTPUTMODE_OUTBITVALUE,
+     .compareValue = 0
+    };
+    Timer_A_initCompareMode(base, &compare_settings);
+}
+
+// This function sets up a DMA channel for byte transfers, one per trigger, without an interrupt. Addresses are set by the caller.
+//  channel: DMA channel.
+//  trigger: DMA trigger source.
+//  mode: DMA_TRANSFER_SINGLE to stop after size transfers, or DMA_TRANSFER_REPEATED_SINGLE to start over.
+//  size: number of transfers in a block.
+static void _initChannel(uint8_t channel, uint8_t trigger, uint16_t mode, uint16_t size)
+{
+    DMA_initParam settings =
+    {
+     .channelSelect = channel,
+     .transferModeSelect = mode,
+     .transferSize = size,
+     .triggerSourceSelect = trigger,
+     .transferUnitSelect = DMA_SIZE_SRCBYTE_DSTBYTE,
+     .triggerTypeSelect = DMA_TRIGGER_RISINGEDGE
+    };
+    DMA_init(&settings);
+}
+
+// This function is called by registers.c when the SPI bus is needed again.
+static void _reclaimBus(void)
+{
+    PHASE_stop();
+}
+#else
+// This interrupt happens when a phase measurement is due. The measurement is stored with the time at which it was read, and the compare
+// register is moved on by one period. If the handler was held off for longer than a period, the slots that were missed are skipped; the gap
+// shows in the timestamps.
+#pragma vector=TIMER0_A0_VECTOR
+void __attribute__ ((interrupt)) _sampleIrqHandler(void)
+{
+    uint16_t now = PHASE_TIMER_R; // Time of this measurement
+    sample_phases[sample_idx] = AT86_getPhase(); // Retrieve and store latest phase measurement
+    sample_times[sample_idx] = now - start_time;
+    ++sample_idx;
+    if(sample_idx == sample_len) // Buffers are full
+    {
+        PHASE_stop();
+        return;
+    }
+    do
+    {
+        next_time += sample_period;
+        Timer_A_setCompareValue(PHASE_TIMER_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_0, next_time);
+    }
+    while((int16_t) (next_time - PHASE_TIMER_R) <= 0); // The count already got there, so the compare will not happen: skip this slot
+}
+#endif
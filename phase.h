@@ -0,0 +1,22 @@
+/*
+ * phase.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// File with function declarations for phase.c. Specific details in this file.
+
+#ifndef PHASE_H_
+#define PHASE_H_
+
+#include <stdint.h> // Specific definitions of integers
+#include <stdbool.h> // Definition of bool data type
+
+void     PHASE_init(void); // Start the timer that paces and timestamps phase measurements.
+void     PHASE_setPeriod(uint16_t period); // Set the time (timer ticks) between phase measurements.
+uint16_t PHASE_getPeriod(void); // Get the time (timer ticks) between phase measurements.
+void     PHASE_start(volatile uint8_t * phases, volatile uint16_t * times, uint16_t len, uint16_t lead); // Start taking phase measurements at a fixed period, timed from lead ticks ago.
+uint16_t PHASE_stop(void); // Stop taking phase measurements, and return how many were taken.
+bool     PHASE_isSampling(void); // Indicates whether phase measurements are being taken.
+
+#endif /* PHASE_H_ */
@@ -0,0 +1,383 @@
+/*
+ * proto.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// This file contains the binary protocol we speak with the computer over VCOM, replacing ASCII commands and printf-formatted reports. Every
+// message travels in a frame of its own:
+//  version (1 byte) | message type (1 byte) | sequence ID (1 byte) | payload length (1 byte) | payload | CRC-16/CCITT of all the preceding bytes (2 bytes)
+// The frame is then COBS-encoded, which removes every zero byte from it, and a zero byte is sent after it; the receiver can always find the
+// start of the next frame, even after losing bytes. The CRC is computed by the MSP430 CRC16 module. python_files/protocol.py is the other end.
+// The computer does not have to wait for a command to complete before sending the next: commands are acknowledged as they arrive, also while
+// another one is being carried out, and queued. Every message about a command carries the sequence ID the computer gave it, so the
+// computer can tell which command acknowledgements, reports and msgDONE belong to.
+
+#include <string.h> // TI-provided library to work with strings
+#include "proto.h" // Declarations of functions/macros in this file
+#include "hal.h" // Definitions of pins, peripheral initialization details, etc.
+#include "vcom.h" // Low-level control of UART to talk to computer
+#include "crc.h" // TI-provided file to control MSP430 CRC module
+
+#define PROTO_HEADER_LEN (4U) // Version, message type, sequence ID and payload length
+#define PROTO_CRC_LEN    (2U)
+#define PROTO_CRC_SEED   (0xFFFFU) // Initial CRC value
+#define PROTO_FRAME_LEN  (PROTO_HEADER_LEN + PROTO_MAX_PAYLOAD + PROTO_CRC_LEN) // Largest frame before encoding
+#define PROTO_COBS_BLOCK (0xFFU) // COBS code of a block of 254 non-zero bytes that is not followed by a zero
+
+static uint8_t frame[PROTO_FRAME_LEN]; // Frame being sent, before encoding. Its payload is filled in place.
+static uint8_t encoded[PROTO_FRAME_LEN + PROTO_FRAME_LEN/254 + 2]; // Frame being sent, after encoding and with its delimiter
+static const uint8_t arg_lens[] = {0, 0, 0, 1, 4, 1, 0, 4, 13, 0, 6, 2, 2, 6}; // Length of the arguments of each command, indexed by PROTO_Msg_Enum
+static PROTO_Cmd queue[PROTO_QUEUE_LEN]; // Commands acknowledged but not carried out yet, oldest first from queue_tail
+#define PROTO_QUEUE_MASK (PROTO_QUEUE_LEN-1U) // Maps a free-running index to its place in the queue
+static uint8_t queue_head = 0; // Free-running index at which the next command will be stored
+static uint8_t queue_tail = 0; // Free-running index of the next command to carry out
+static uint8_t current_seq = 0; // Sequence ID of the command being carried out, carried by the reports about it
+
+// This function computes the CRC of a block of bytes with the CRC module.
+//  data: bytes to compute the CRC of.
+//  len: number of bytes.
+//  returns: their CRC-16/CCITT.
+static uint16_t _crc(const uint8_t * data, uint8_t len)
+{
+    CRC_setSeed(PROTO_CRC_BASE, PROTO_CRC_SEED);
+    uint8_t idx;
+    for(idx=0; idx<len; ++idx)
+        CRC_set8BitDataReversed(PROTO_CRC_BASE, data[idx]); // The module takes bits least significant first; reversing gives the standard CRC.
+    return CRC_getResult(PROTO_CRC_BASE);
+}
+
+// This function COBS-encodes a frame and appends the delimiter.
+//  in: frame to encode.
+//  len: length of the frame.
+//  out: where to store the encoded frame. Must have room for len + len/254 + 2 bytes.
+//  returns: length of the encoded frame, delimiter included.
+static uint8_t _cobsEncode(const uint8_t * in, uint8_t len, uint8_t * out)
+{
+    uint8_t code_idx = 0; // Where the code of the block being encoded goes
+    uint8_t out_idx = 1;
+    uint8_t code = 1; // One more than the number of non-zero bytes in the block so far
+    uint8_t idx;
+    for(idx=0; idx<len; ++idx)
+    {
+        if(in[idx] == 0) // A zero ends the block; its code says where the zero was.
+        {
+            out[code_idx] = code;
+            code_idx = out_idx++;
+            code = 1;
+        }
+        else
+        {
+            out[out_idx++] = in[idx];
+            if(++code == PROTO_COBS_BLOCK) // Longest possible block
+            {
+                out[code_idx] = code;
+                code_idx = out_idx++;
+                code = 1;
+            }
+        }
+    }
+    out[code_idx] = code;
+    out[out_idx++] = 0; // Delimiter
+    return out_idx;
+}
+
+// This function decodes a COBS-encoded frame in place.
+//  data: encoded frame, without its delimiter. Replaced by the decoded frame.
+//  len: length of the encoded frame.
+//  returns: length of the decoded frame, or -1 if the encoding is not valid.
+static int16_t _cobsDecode(uint8_t * data, uint8_t len)
+{
+    uint8_t in_idx = 0;
+    uint8_t out_idx = 0; // Never ahead of in_idx, so decoding in place is safe.
+    while(in_idx < len)
+    {
+        uint8_t code = data[in_idx++];
+        if((code == 0) || ((uint16_t) in_idx + code - 1U > len)) // Block runs past the end of the frame
+            return -1;
+        uint8_t idx;
+        for(idx=1; idx<code; ++idx)
+            data[out_idx++] = data[in_idx++];
+        if((code != PROTO_COBS_BLOCK) && (in_idx < len)) // Every block but a full one and the last stood for a zero.
+            data[out_idx++] = 0;
+    }
+    return out_idx;
+}
+
+// This function stores a 16-bit field of a payload.
+//  p: where to store it.
+//  value: value to store.
+//  returns: where the next field goes.
+static uint8_t * _put16(uint8_t * p, uint16_t value)
+{
+    p[0] = (uint8_t) value;
+    p[1] = (uint8_t) (value >> 8);
+    return p + 2;
+}
+
+// This function stores a 32-bit field of a payload.
+//  p: where to store it.
+//  value: value to store.
+//  returns: where the next field goes.
+static uint8_t * _put32(uint8_t * p, uint32_t value)
+{
+    p = _put16(p, (uint16_t) value);
+    return _put16(p, (uint16_t) (value >> 16));
+}
+
+// This function queues the frame whose payload has been filled in for transmission.
+//  type: kind of message.
+//  seq: sequence ID of the command the message is about.
+//  end: address just past the last byte of the payload.
+static void _send(PROTO_Msg_Enum type, uint8_t seq, const uint8_t * end)
+{
+    uint8_t len = end - (frame + PROTO_HEADER_LEN);
+    frame[0] = PROTO_VERSION;
+    frame[1] = type;
+    frame[2] = seq;
+    frame[3] = len;
+    _put16(frame + PROTO_HEADER_LEN + len, _crc(frame, PROTO_HEADER_LEN + len));
+    uint8_t encoded_len = _cobsEncode(frame, PROTO_HEADER_LEN + len + PROTO_CRC_LEN, encoded); // Done while earlier frames are still being transmitted
+    VCOM_waitTx(encoded_len); // Frames are never dropped: wait for room in the VCOM transmit buffer if there is none.
+    VCOM_tx(encoded, encoded_len);
+}
+
+// This function decodes and checks the oldest command frame waiting in the VCOM RX ring, and frees its slot. Must only be called once
+// VCOM_rxAvailable() is true.
+//  cmd: where to store the command. Its sequence ID is set as soon as it can be read, for msgERROR to carry it.
+//  returns: frameOK if the frame holds a command of this protocol version with the right arguments, or why it was rejected.
+PROTO_Frame_Enum PROTO_receive(PROTO_Cmd * cmd)
+{
+    uint8_t * data = (uint8_t *) VCOM_getRxString(); // An encoded frame has no zero bytes, so it reads as a string.
+    int16_t len = _cobsDecode(data, strlen((char *) data));
+    PROTO_Frame_Enum check = frameOK;
+    cmd->seq = (len >= (int16_t) PROTO_HEADER_LEN) ? data[2] : 0;
+    if(len < 0)
+        check = frameBAD_ENCODING;
+    else if((len < (int16_t) (PROTO_HEADER_LEN + PROTO_CRC_LEN)) || (data[3] != len - (PROTO_HEADER_LEN + PROTO_CRC_LEN)))
+        check = frameBAD_LENGTH;
+    else if(_crc(data, len - PROTO_CRC_LEN) != (data[len-2] | ((uint16_t) data[len-1] << 8)))
+        check = frameBAD_CRC;
+    else if(data[0] != PROTO_VERSION)
+        check = frameBAD_VERSION;
+    else if((data[1] == 0) || (data[1] >= sizeof(arg_lens)))
+        check = frameBAD_TYPE;
+    else if(data[3] != arg_lens[data[1]])
+        check = frameBAD_LENGTH;
+    else
+    {
+        cmd->type = (PROTO_Msg_Enum) data[1];
+        memcpy(cmd->args, data + PROTO_HEADER_LEN, data[3]);
+    }
+    VCOM_releaseRx(); // Everything we need has been copied out of the slot.
+    return check;
+}
+
+// This function looks at every frame waiting in the VCOM RX ring: a command is acknowledged and queued, to be carried out once the commands
+// before it have completed, and any other frame is rejected with msgERROR, as is a command that finds the queue full. It is called by the
+// commands task of main.c, and while a command waits for the radio, so that commands are acknowledged even while another is being carried
+// out. Must not be called while a message is being sent.
+void PROTO_poll(void)
+{
+    while(VCOM_rxAvailable())
+    {
+        PROTO_Cmd cmd;
+        PROTO_Frame_Enum check = PROTO_receive(&cmd);
+        if((check == frameOK) && ((uint8_t) (queue_head - queue_tail) == PROTO_QUEUE_LEN))
+            check = frameBUSY;
+        if(check != frameOK) // The computer can send the frame again.
+            PROTO_error(check, cmd.seq);
+        else
+        {
+            queue[queue_head & PROTO_QUEUE_MASK] = cmd;
+            ++queue_head;
+            PROTO_ack(&cmd);
+        }
+    }
+}
+
+// This function takes the oldest command off the queue. The reports sent from then on carry its sequence ID.
+//  cmd: where to store the command.
+//  returns: false if the queue is empty.
+bool PROTO_next(PROTO_Cmd * cmd)
+{
+    if(queue_head == queue_tail)
+        return false;
+    *cmd = queue[queue_tail & PROTO_QUEUE_MASK];
+    ++queue_tail;
+    current_seq = cmd->seq;
+    return true;
+}
+
+// This function reads a 4-byte argument of a command.
+//  data: address of the argument.
+//  returns: its value.
+uint32_t PROTO_get32(const uint8_t * data)
+{
+    return data[0] | ((uint32_t) data[1] << 8) | ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+// This function reads a 2-byte argument of a command.
+//  data: address of the argument.
+//  returns: its value.
+uint16_t PROTO_get16(const uint8_t * data)
+{
+    return data[0] | ((uint16_t) data[1] << 8);
+}
+
+// This function tells the computer a command was received intact and will be carried out.
+//  cmd: the command.
+void PROTO_ack(const PROTO_Cmd * cmd)
+{
+    uint8_t * p = frame + PROTO_HEADER_LEN;
+    *p++ = cmd->type;
+    _send(msgACK, cmd->seq, p);
+}
+
+// This function tells the computer a frame was rejected, so that it can send the command again.
+//  error: why it was rejected.
+//  seq: sequence ID of the frame, or 0 if it could not be read.
+void PROTO_error(PROTO_Frame_Enum error, uint8_t seq)
+{
+    uint8_t * p = frame + PROTO_HEADER_LEN;
+    *p++ = error;
+    _send(msgERROR, seq, p);
+}
+
+// This function tells the computer that a command has completed and nothing more will be sent about it.
+//  cmd: the command.
+void PROTO_done(const PROTO_Cmd * cmd)
+{
+    uint8_t * p = frame + PROTO_HEADER_LEN;
+    *p++ = cmd->type;
+    _send(msgDONE, cmd->seq, p);
+}
+
+// This function informs the computer of a transmission.
+//  address: address the payload contained.
+//  time: how long the transmission took (us).
+//  outcome: TRAC_STATUS of the transmission in MAC mode (AT86_Trac_Enum), 0 otherwise.
+//  retries: times the frame was sent again because it was not acknowledged.
+//  rate: data rate of the PSDU (AT86_Rate_Enum).
+void PROTO_reportTx(uint8_t address, uint32_t time, uint8_t outcome, uint8_t retries, uint8_t rate)
+{
+    uint8_t * p = frame + PROTO_HEADER_LEN;
+    *p++ = address;
+    p = _put32(p, time);
+    *p++ = outcome;
+    *p++ = retries;
+    *p++ = rate;
+    _send(msgTX_REPORT, current_seq, p);
+}
+
+// This function informs the computer of a reception.
+//  valid: whether the payload is one of ours.
+//  payload: first three bytes retrieved from the frame buffer: length, address and the byte after it.
+//  time: how long the reception took (us).
+//  rate: data rate of the PSDU (AT86_Rate_Enum).
+void PROTO_reportRx(bool valid, const uint8_t * payload, uint32_t time, uint8_t rate)
+{
+    uint8_t * p = frame + PROTO_HEADER_LEN;
+    *p++ = valid;
+    *p++ = payload[0];
+    *p++ = payload[1];
+    *p++ = payload[2];
+    p = _put32(p, time);
+    *p++ = rate;
+    _send(msgRX_REPORT, current_seq, p);
+}
+
+// This function informs the computer of a block of phase measurements.
+//  first: index of the first measurement of the block within the reception.
+//  phases: phase measurements.
+//  times: time of each measurement (timer ticks after reception started).
+//  count: number of measurements, at most PROTO_PHASES_PER_FRAME.
+void PROTO_reportPhases(uint16_t first, volatile const uint8_t * phases, volatile const uint16_t * times, uint8_t count)
+{
+    uint8_t * p = frame + PROTO_HEADER_LEN;
+    p = _put16(p, first);
+    p = _put16(p, 1000000000UL/PHASE_TIMER_FREQ); // Lets the computer convert the times without knowing our timer setup
+    uint8_t idx;
+    for(idx=0; idx<count; ++idx)
+    {
+        *p++ = phases[idx];
+        p = _put16(p, times[idx]);
+    }
+    _send(msgPHASES, current_seq, p);
+}
+
+// This function informs the computer of the line fitted to the phase measurements of a reception.
+//  line: the line.
+void PROTO_reportFit(const FIT_Line * line)
+{
+    uint8_t * p = frame + PROTO_HEADER_LEN;
+    p = _put16(p, line->count);
+    p = _put32(p, line->slope);
+    p = _put32(p, line->intercept);
+    p = _put32(p, line->r2);
+    _send(msgFIT, current_seq, p);
+}
+
+// This function informs the computer of the throughput of one kind of SPI transaction.
+//  bench: kind of transaction (Bench_Enum in main.c).
+//  bytes: bytes on the bus per transaction.
+//  iterations: number of transactions.
+//  time: how long they took (us).
+//  rate: resulting throughput (B/s).
+void PROTO_reportBench(uint8_t bench, uint8_t bytes, uint16_t iterations, uint32_t time, uint32_t rate)
+{
+    uint8_t * p = frame + PROTO_HEADER_LEN;
+    *p++ = bench;
+    *p++ = bytes;
+    p = _put16(p, iterations);
+    p = _put32(p, time);
+    p = _put32(p, rate);
+    _send(msgBENCH_REPORT, current_seq, p);
+}
+
+// This function informs the computer that a slot of a sweep is starting.
+//  freq: center frequency of the slot (MHz).
+//  rep: repetition at that frequency, from 0.
+//  hop: how long the move to the frequency took (us), 0 after the first repetition, or PROTO_HOP_FAILED.
+void PROTO_reportSlot(uint16_t freq, uint8_t rep, uint16_t hop)
+{
+    uint8_t * p = frame + PROTO_HEADER_LEN;
+    p = _put16(p, freq);
+    *p++ = rep;
+    p = _put16(p, hop);
+    _send(msgSLOT, current_seq, p);
+}
+
+// This function informs the computer of the runtime accounting of a task.
+//  task: number of the task, or SCHED_IDLE for the time spent asleep.
+//  stats: its accounting.
+void PROTO_reportTask(uint8_t task, const SCHED_Stats * stats)
+{
+    uint8_t * p = frame + PROTO_HEADER_LEN;
+    *p++ = task;
+    p = _put32(p, stats->runs);
+    p = _put32(p, (uint32_t) stats->ticks);
+    p = _put32(p, (uint32_t) (stats->ticks >> 32));
+    p = _put32(p, stats->max_ticks);
+    p = _put16(p, 1000000000UL/TS_FREQ); // Lets the computer convert the times without knowing our timer setup
+    _send(msgTASK_REPORT, current_seq, p);
+}
+
+// This function informs the computer of a burst of frames that has been transmitted.
+//  frames: frames sent.
+//  underruns: frames of them that went out with TRX_UR.
+//  failures: frames of them that were not acknowledged, in MAC mode.
+//  uploads: writes to the frame buffer the burst took.
+//  time: time from the start of the first frame to the end of the last (us).
+//  rate: data rate, AT86_Rate_Enum.
+void PROTO_reportBurst(uint16_t frames, uint16_t underruns, uint16_t failures, uint16_t uploads, uint32_t time, uint8_t rate)
+{
+    uint8_t * p = frame + PROTO_HEADER_LEN;
+    p = _put16(p, frames);
+    p = _put16(p, underruns);
+    p = _put16(p, failures);
+    p = _put16(p, uploads);
+    p = _put32(p, time);
+    *p++ = rate;
+    _send(msgBURST_REPORT, current_seq, p);
+}
@@ -0,0 +1,88 @@
+/*
+ * proto.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// File with function declarations for proto.c. Specific details in this file.
+
+#ifndef PROTO_H_
+#define PROTO_H_
+
+#include <stdint.h> // Specific definitions of integers
+#include <stdbool.h> // Definition of bool data type
+#include "fit.h" // Straight line fitted to the phase measurements
+#include "sched.h" // Runtime accounting of the tasks
+
+#define PROTO_VERSION          (7U) // Protocol version carried by every frame. Frames of any other version are rejected.
+#define PROTO_MAX_PAYLOAD      (240U) // Largest payload (bytes) of a frame, which keeps an encoded frame within one VCOM transmission
+#define PROTO_PHASES_PER_FRAME (64U) // Most phase measurements carried by one msgPHASES frame
+#define PROTO_HOP_FAILED       (0xFFFFU) // Hop time of a msgSLOT frame whose move to the frequency failed: the PLL did not lock on it
+#define PROTO_MAX_ARGS         (13U) // Longest arguments (bytes) of a command
+#define PROTO_QUEUE_LEN        (8U) // Commands (a power of two) that can wait to be carried out once acknowledged
+
+typedef enum // Kinds of message. Commands are sent by the computer, the others by us. Multi-byte fields are little-endian. Every message
+             // about a command carries its sequence ID; msgERROR carries the one of the rejected frame, or 0 if it could not be read.
+{
+    msgTRANSMIT     = 0x01, // Have the AT86RF233 transmit a payload.
+    msgRECEIVE      = 0x02, // Have the AT86RF233 receive a payload.
+    msgCHANNEL      = 0x03, // Change the AT86RF233 channel; anything but channels 11 to 26 is ignored. Arguments: channel (1 byte).
+    msgPERIOD       = 0x04, // Change the time between phase measurements. Arguments: period in ns (4 bytes).
+    msgSUMMARY      = 0x05, // Choose whether receptions are reported with the fitted line only (1) or with every phase measurement (0). Arguments: mode (1 byte).
+    msgBENCHMARK    = 0x06, // Measure the throughput of each kind of SPI transaction.
+    msgBAUD         = 0x07, // Change the VCOM baud rate. The ack goes out at the old rate; the computer must then send the same command again at the new rate within VCOM_BAUD_CONFIRM_MS, or we go back to VCOM_BAUD_DEFAULT. Arguments: baud rate (4 bytes).
+    msgSWEEP        = 0x08, // Transmit or receive a number of payloads at each of a set of center frequencies, keeping in step with the other board through the gap between payloads. Frequencies outside AT86_FREQ_MIN to AT86_FREQ_MAX are skipped. Arguments: first frequency in MHz (2 bytes), step in MHz (1 byte), first frequency + n steps in bit n (4 bytes), gap in us (4 bytes), payloads per frequency (1 byte), receive (1) or transmit (0) (1 byte).
+    msgSTATS        = 0x09, // Report the runtime accounting of each task and of the time spent asleep, then start it over.
+    msgMAC          = 0x0A, // Choose whether payloads are sent as acknowledged IEEE 802.15.4 data frames, with the CSMA-CA, retransmissions, ACKs and address filtering of the AT86RF233 extended operating mode (1), or as bare frames (0). Arguments: mode (1 byte), own short address (2 bytes), short address of the other board (2 bytes), retransmissions of a frame that is not acknowledged, 0 to 15 (1 byte).
+    msgRATE         = 0x0B, // Change the O-QPSK data rate of the PSDU of the frames the AT86RF233 transmits and receives, and with it the time between phase measurements. Arguments: AT86_Rate_Enum: 250 kb/s (0), 500 kb/s (1), 1 Mb/s (2) or 2 Mb/s (3) (1 byte), scrambler on (1) or off (0) (1 byte).
+    msgFREQUENCY    = 0x0C, // Move the AT86RF233 to any center frequency in 1 MHz steps, off the channel grid if need be, until the next msgCHANNEL. Arguments: frequency in MHz, limited to AT86_FREQ_MIN to AT86_FREQ_MAX (2 bytes).
+    msgBURST        = 0x0D, // Transmit a burst of payloads back to back, each a set time after the end of the previous one, then report it. Arguments: payloads (2 bytes), time from the end of a payload to the start of the next in us, at most BURST_MAX_IFS_US (4 bytes).
+    msgACK          = 0x80, // A command was received intact and is being carried out. Contents: command (1 byte).
+    msgERROR        = 0x81, // A frame was rejected. Contents: PROTO_Frame_Enum (1 byte).
+    msgDONE         = 0x82, // A command has completed; nothing more will be sent about it. Contents: command (1 byte).
+    msgTX_REPORT    = 0x83, // Contents: address (1 byte), transmission time in us (4 bytes), outcome: TRAC_STATUS in MAC mode, 0 otherwise (1 byte), retransmissions (1 byte), data rate (1 byte).
+    msgRX_REPORT    = 0x84, // Contents: valid (1 byte), first three bytes received: length, address, next, the last two after the MAC header in MAC mode (3 bytes), reception time in us (4 bytes), data rate (1 byte).
+    msgPHASES       = 0x85, // Contents: index of the first measurement (2 bytes), timer tick in ns (2 bytes), then phase (1 byte) and time in ticks after the SFD of the payload (2 bytes) of each measurement.
+    msgFIT          = 0x86, // Contents: measurements fitted (2 bytes), slope in rad/s (4 bytes), intercept in mrad (4 bytes), r^2 in ppm (4 bytes).
+    msgBENCH_REPORT = 0x87, // Contents: Bench_Enum (1 byte), bytes per transaction (1 byte), iterations (2 bytes), time in us (4 bytes), throughput in B/s (4 bytes).
+    msgSLOT         = 0x88, // Start of a slot of a sweep, followed by the report of its transmission or reception; nothing follows if no payload was received. Contents: center frequency in MHz (2 bytes), repetition (1 byte), time the move to the frequency took in us, 0 after the first repetition and PROTO_HOP_FAILED if the PLL did not lock on it (2 bytes).
+    msgTASK_REPORT  = 0x89, // Contents: task (1 byte, SCHED_IDLE for the time spent asleep), runs (4 bytes), total time in ticks (8 bytes), longest run in ticks (4 bytes), timer tick in ns (2 bytes).
+    msgBURST_REPORT = 0x8A // Contents: payloads sent (2 bytes), payloads that went out with TRX_UR because they were written to the frame buffer too late (2 bytes), payloads not acknowledged in MAC mode (2 bytes), writes to the frame buffer (2 bytes), time from the start of the first payload to the end of the last in us (4 bytes), data rate (1 byte).
+} PROTO_Msg_Enum;
+
+typedef enum // Outcome of checking a frame from the computer
+{
+    frameOK = 0,
+    frameBAD_ENCODING, // Not valid COBS
+    frameBAD_LENGTH, // Too short, length field does not match, or wrong argument length for the command
+    frameBAD_CRC, // CRC does not match
+    frameBAD_VERSION, // Sent by a different version of the protocol
+    frameBAD_TYPE, // Not a command
+    frameBUSY // Intact, but the command queue is full or a baud rate change awaits confirmation; send it again once a command has completed
+} PROTO_Frame_Enum;
+
+typedef struct // Command from the computer
+{
+    PROTO_Msg_Enum type;
+    uint8_t seq; // Sequence ID chosen by the computer, carried by every message we send about the command
+    uint8_t args[PROTO_MAX_ARGS]; // Arguments, as many as the command takes
+} PROTO_Cmd;
+
+PROTO_Frame_Enum PROTO_receive(PROTO_Cmd * cmd); // Decode and check the oldest command frame waiting in the VCOM RX ring.
+void PROTO_poll(void); // Acknowledge and queue the commands that have arrived, or reject their frames.
+bool PROTO_next(PROTO_Cmd * cmd); // Take the oldest queued command, to be carried out next.
+uint32_t PROTO_get32(const uint8_t * data); // Read a 4-byte argument.
+uint16_t PROTO_get16(const uint8_t * data); // Read a 2-byte argument.
+void PROTO_ack(const PROTO_Cmd * cmd); // Acknowledge a command.
+void PROTO_error(PROTO_Frame_Enum error, uint8_t seq); // Report a rejected frame.
+void PROTO_done(const PROTO_Cmd * cmd); // Report that a command has completed.
+void PROTO_reportTx(uint8_t address, uint32_t time, uint8_t outcome, uint8_t retries, uint8_t rate); // Report a transmission.
+void PROTO_reportRx(bool valid, const uint8_t * payload, uint32_t time, uint8_t rate); // Report a reception.
+void PROTO_reportPhases(uint16_t first, volatile const uint8_t * phases, volatile const uint16_t * times, uint8_t count); // Report a block of phase measurements.
+void PROTO_reportFit(const FIT_Line * line); // Report the line fitted to the phase measurements.
+void PROTO_reportBench(uint8_t bench, uint8_t bytes, uint16_t iterations, uint32_t time, uint32_t rate); // Report the throughput of one kind of SPI transaction.
+void PROTO_reportSlot(uint16_t freq, uint8_t rep, uint16_t hop); // Report the start of a slot of a sweep.
+void PROTO_reportTask(uint8_t task, const SCHED_Stats * stats); // Report the runtime accounting of a task.
+void PROTO_reportBurst(uint16_t frames, uint16_t underruns, uint16_t failures, uint16_t uploads, uint32_t time, uint8_t rate); // Report a burst of transmissions.
+
+#endif /* PROTO_H_ */
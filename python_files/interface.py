@@ -8,8 +8,9 @@ Created on Tue Apr 27 14:41:41 2021
 # This file contains code to interact with the AT86RF233 evaluation boards through the MSP-EXP430F5529LP.
 # Currently, the code will exchange packets repeatedly between AT86RF233 boards and retreive phase measurements taken during each reception.
 # Each set of phase data is unwrapped and a line is fit to it using linear regression. Lines that fit with sufficiently-large coefficient of determination are saved.
-# This is repeated on each channel at which the AT86RF233 can transmit until 5 regression lines are recorded for each channel.
-# The slopes and intercepts are then plotted with respect to channel.
+# Both boards sweep a plan of center frequencies by themselves, streaming each capture, and the sweep is repeated over the frequencies that
+# still need data until 5 regression lines are recorded for each frequency.
+# The slopes and intercepts are then plotted with respect to frequency.
 # Plots and raw data for each payload reception are saved in folders corresponding to date and time inside the data folder as 'Data.pickle' and 'plot.png'. Plot of slopes and intercepts is in python_files folder saved as 'plot.png'.
 
 # This experiment has not yielded interesting data so far, likely because phase transitions must be handled by a microcontroller for sufficiently-precise timing.
@@ -19,6 +20,16 @@ Created on Tue Apr 27 14:41:41 2021
 
 RX_COM = 'COM36'
 TX_COM = 'COM33'
+SUMMARY = False # Set to True to have the receiver send only the line it fits to its phase measurements, which is much faster than sending them all
+CAPTURES = 5 # Sufficiently-linear captures to save at each frequency
+SWEEP_REPS = 8 # Payloads exchanged at each frequency per sweep; frequencies are swept again until each has enough good lines
+FREQ_STEP = 1 # Spacing in MHz of the frequencies swept; 5 keeps to the IEEE 802.15.4 channels
+FREQUENCIES = range(2400, 2484, FREQ_STEP) # Center frequencies in MHz to capture at: the 2.4 GHz ISM band. A sweep visits up to 32 of them
+MAC = False # Set to True to send payloads as acknowledged IEEE 802.15.4 frames, with the AT86RF233 doing CSMA-CA, retransmissions, ACKs and address filtering
+RX_SHORT_ADDR = 0x0001 # Short addresses of the boards in MAC mode
+TX_SHORT_ADDR = 0x0002
+MAC_RETRIES = 3 # Retransmissions of a frame that is not acknowledged in MAC mode
+DATA_RATE = 250 # O-QPSK data rate in kb/s: 250, 500, 1000 or 2000. The higher rates shorten each payload, and with it the phase measurements taken during it
 
 import serial
 from matplotlib import pyplot as plt
@@ -28,125 +39,177 @@ import numpy as np
 import pickle
 import os
 import datetime
+import protocol # Binary protocol spoken with the MSP430
 
-def setChannel(ser, channel): # Configure an AT86RF233 to transmit and receive on a specific channel
-    ser.write(b'CH\n') # Send set channel command
-    ser.readline() # Wait for acknowledgement
-    ser.write((str(channel&0x1F)+'\n').encode('ascii')) # Specify channel on which to transmit/receive
+link_rates = {} # Baud rate each COM port has been moved to; the MSP430 keeps it until reset
+
+def openLink(com): # Connect to an MSP430 over its VCOM port, moving the link to the fastest baud rate it supports the first time
+    ser = serial.Serial(com, link_rates.get(com, protocol.DEFAULT_BAUD))
+    if com not in link_rates:
+        link_rates[com] = protocol.negotiateBaud(ser)
+    return ser
+
+def setChannel(ser, channel): # Configure an AT86RF233 to transmit and receive on a specific channel, 11 to 26
+    if channel not in protocol.CHANNELS:
+        raise ValueError('no channel %d in the 2.4 GHz band'%channel)
+    protocol.runCommand(ser, 'CH', channel) # Send set channel command, specifying channel on which to transmit/receive
+
+def setFrequency(ser, freq): # Configure an AT86RF233 to transmit and receive at any center frequency in MHz, in 1 MHz steps, until the next channel change
+    if not protocol.FREQ_MIN <= freq <= protocol.FREQ_MAX:
+        raise ValueError('the AT86RF233 can not tune to %d MHz'%freq)
+    protocol.runCommand(ser, 'FQ', freq) # Send set frequency command
+
+def setMac(ser, mac, own, peer, retries): # Choose whether an AT86RF233 sends and receives payloads as acknowledged IEEE 802.15.4 frames, addressed from own to peer
+    protocol.runCommand(ser, 'MC', 1 if mac else 0, own, peer, retries) # Send MAC mode command
+
+def setRate(ser, rate, scrambler=True): # Configure an AT86RF233 to transmit and receive at a data rate in kb/s; both boards need the same one
+    protocol.runCommand(ser, 'DR', protocol.RATES.index(rate), 1 if scrambler else 0) # Send data rate command; it resets the sample period to suit the rate
+
+def setSamplePeriod(ser, period): # Set the time in ns between phase measurements taken during reception
+    protocol.runCommand(ser, 'PR', int(period)) # Send set sample period command; the MSP430 rounds the period to its timer resolution
+
+def setSummary(ser, summary): # Choose whether receptions are reported with only the line the MSP430 fits to the phase measurements, or with every measurement as well
+    protocol.runCommand(ser, 'SM', 1 if summary else 0) # Send reporting mode command
 
 def startTransmit(ser): # Tell an AT86RF233 to start transmission
-    ser.write(b'TX\n') # Sent start transmit command
-    ser.readline() # Wait for acknowledgement
+    protocol.sendCommand(ser, 'TX') # Send start transmit command and wait for acknowledgement
 
 def endTransmit(ser): # Retrieve data after an AT86RF233 has finished transmitting
-    vals = [] # Contains characters received from the VCOM port
-    while len(vals)==0 or vals[-1]!='\n': # Record characters until we receive '\n', indicating end of command
-        while not(ser.in_waiting):
-            pass
-        vals.append(ser.read().decode())
-    m = ''.join(vals) # Join characters into string
-    print(m)
-    address = int(m.split(' ')[2][:-1], 16) # Extract address value from string
-    time    = int(m.split(' ')[4]) # Extract transmit duration from string
-    return {'address': address, 'time': time} # Return these parsed values
+    return parseTransmission(protocol.readUntilDone(ser)) # Messages sent about the transmission
+
+def parseTransmission(msgs): # Retrieve data about a transmission from the messages the MSP430 sent about it
+    for msg in msgs:
+        print(protocol.formatMessage(msg))
+    report = [msg for msg in msgs if msg['type'] == protocol.TX_REPORT][0]
+    return {'address': report['address'], 'time': report['time'], 'outcome': report['outcome'], 'retries': report['retries'], 'rate': report['rate']} # Return the address, transmit duration and, in MAC mode, whether it was acknowledged
 
 def startReceive(ser): # Tell an AT86RF233 to start receiving
-    ser.write(b'RX\n') # Send start receive command
-    ser.readline() # Wait for acknowledgement
+    protocol.sendCommand(ser, 'RX') # Send start receive command and wait for acknowledgement
 
 def endReceive(ser): # Wait until reception is complete, then retrieve data about the reception
-    vals = [] # Contains values received from the VCOM port
-    while len(vals)==0 or vals[-1]!='\n': # Record characters until we receive '\n', indicating end of command
-        while not(ser.in_waiting):
-            pass
-        vals.append(ser.read().decode())
-    m = ''.join(vals) # Join characters into string
-    print(m)
-    if not('invalid RX' in m): # Sometimes the AT86RF233 receives erroneous packets; proceed only if packet is valid
+    return parseReception(protocol.readUntilDone(ser)) # Messages sent about the reception
+
+def parseReception(msgs): # Retrieve data about a reception from the messages the MSP430 sent about it
+    report = [msg for msg in msgs if msg['type'] == protocol.RX_REPORT][0]
+    print(protocol.formatMessage(report))
+    if report['valid']: # Sometimes the AT86RF233 receives erroneous packets; proceed only if packet is valid
         vals = []
-        mm = ''
-        while not('done' in mm): # Record phase values until we get command indicating all have been transmitted
-            mm = ser.readline().decode()
-            try:
-                vals.append(int(mm[:-1], 16))
-            except:
-                pass
+        times = [] # Time in ns after start of reception at which each phase value was measured
+        fit = None # Line fitted by the MSP430 to the unwrapped phase values
+        for msg in msgs:
+            if msg['type'] == protocol.PHASES: # Block of phase values
+                vals += msg['phases']
+                times += msg['times']
+            elif msg['type'] == protocol.FIT: # Slope in rad/s, intercept in mrad, r^2 in parts per million
+                m = msg['slope']*1e-6 # rad/us
+                b = msg['intercept']/1000 - np.pi # rad, offset like the phase values below
+                fit = {'m': m, 'b': b, 'r': np.copysign(np.sqrt(msg['r2']/1e6), m)}
         print(vals)
-        length  = int(m.split(' ')[3][:-1]) # Extract payload length
-        address = int(m.split(' ')[5][:-1], 16) # Extract address
-        time    = int(m.split(' ')[7]) # Extract time
-        return vals, {'length': length, 'address': address, 'time': time} # Return parsed data
+        return vals, {'length': report['length'], 'address': report['address'], 'time': report['time'], 'rate': report['rate'], 'sample times': times, 'fit': fit} # Return parsed data
     else:
         return None, None # If payload was erroneous, return nothing
 
+def sweepGap(rate): # Time in us between payloads of a sweep that leaves the receiver time to send its reports about a payload at a baud rate
+    report_bytes = 40 if SUMMARY else 1000 # Encoded size of the reports about one reception
+    return 2000 + int(report_bytes*10*1e6/rate)
+
+def startSweep(ser, plan, gap, reps, receive): # Have an AT86RF233 transmit or receive reps payloads at each frequency of a plan from protocol.sweepPlan by itself; start the receiver first
+    protocol.sendCommand(ser, 'SW', *plan, gap, reps, 1 if receive else 0) # Send sweep command and wait for acknowledgement
+
+def burstTransmit(ser, frames, spacing): # Have an AT86RF233 transmit payloads back to back, each spacing us after the end of the previous one, and return the report of the burst
+    report = [msg for msg in protocol.runCommand(ser, 'BT', frames, spacing) if msg['type'] == protocol.BURST_REPORT][0]
+    print(protocol.formatMessage(report))
+    return report
 
-successes = 0
-for channel in np.concatenate((np.arange(0, 0x20), np.arange(0x1F, -1, -1))): # Attempt for each channel that the AT86RF233 can transmit on
-    while successes < 5:
-        try: # Sometimes errors happen. If this is the case, close the serial connections and retry on the next loop.
-            RX = serial.Serial(RX_COM, 115200) # Connect to AT86RF233 we will designate receiver over VCOM port
-            TX = serial.Serial(TX_COM, 115200) # Connect to AT86RF233 we will designate transmitter over VCOM port
-            
-            setChannel(RX, channel) # Set both radios to the current channel
-            setChannel(TX, channel)
-            
-            startReceive(RX) # Tell receiver to start listening for payload
-            startTransmit(TX) # Start transmission of payload
-            tx_info = endTransmit(TX) # Wait for end of payload transmission and record information about it
-            vals, rx_info = endReceive(RX) # Wait for end of reception and record phase measurements and reception information
-            if vals==None: # If the packet was erroneous, try again
+def benchmarkSpi(ser): # Have the MSP430 measure the throughput of each kind of SPI transaction with its AT86RF233
+    results = {} # Bytes per second of each kind of transaction
+    for msg in protocol.runCommand(ser, 'BM'): # Send benchmark command and record results until all have been transmitted
+        print(protocol.formatMessage(msg))
+        results[msg['name']] = msg['rate']
+    return results
+
+
+def fitCapture(vals, rx_info): # Unwrap the phase data of a reception and fit a line to it
+    vals = np.unwrap(((2*np.pi/256)*np.array(vals))-np.pi) # Convert phase data to radians and unwrap it
+    times = np.array(rx_info['sample times'])/1000 # Sample times in us
+    if SUMMARY: # Use the LSRL the MSP430 computed
+        m, b, r = rx_info['fit']['m'], rx_info['fit']['b'], rx_info['fit']['r']
+    else:
+        m, b, r, _, _ = linregress(times, vals) # Compute LSRL for unwrapped phase data
+    print('Slope: %f, Intercept: %f, Correlation coefficient: %f'%(m, b, r))
+    return vals, times, {'m': m, 'b': b, 'r': r}
+
+def saveCapture(freq, vals, times, line, rx_info, tx_info): # Save the data and plot of a reception
+    m, b = line['m'], line['b']
+    plt.plot(times, np.unwrap(vals), marker='.', color='blue', label='Data')
+    plt.plot(times, m*times+b, '--', color='red', label='Regression line')
+    plt.legend()
+    plt.xlabel('Time (us)')
+    plt.ylabel('Phase (radians)')
+    print('Saving data...')
+    Data = {'frequency': freq, 'rx info': rx_info, 'tx info': tx_info, 'values': vals, 'regression line': line}
+    dt = datetime.datetime.now()
+    folder_name = 'data__%d_%d_%d__%d_%d_%d_%d'%(dt.year, dt.month, dt.day, dt.hour, dt.minute, dt.second, dt.microsecond)
+    folder_path = os.path.join(os.getcwd(), 'data', folder_name)
+    os.mkdir(folder_path)
+    with open(os.path.join(folder_path, 'Data.pickle'), 'wb') as F:
+        pickle.dump(Data, F)
+    plt.savefig(os.path.join(folder_path, 'plot.png'))
+    plt.close()
+
+
+successes = {freq: 0 for freq in FREQUENCIES} # Sufficiently-linear captures saved at each frequency
+while min(successes.values()) < CAPTURES:
+    plan = protocol.sweepPlan([freq for freq in successes if successes[freq] < CAPTURES], FREQ_STEP) # The first 32 steps of the frequencies that still need captures
+    try: # Sometimes errors happen. If this is the case, close the serial connections and retry on the next loop.
+        RX = openLink(RX_COM) # Connect to AT86RF233 we will designate receiver over VCOM port
+        TX = openLink(TX_COM) # Connect to AT86RF233 we will designate transmitter over VCOM port
+        setSummary(RX, SUMMARY) # Choose how much the receiver reports
+        setMac(RX, MAC, RX_SHORT_ADDR, TX_SHORT_ADDR, MAC_RETRIES) # Both boards send payloads the same way, each addressed to the other
+        setMac(TX, MAC, TX_SHORT_ADDR, RX_SHORT_ADDR, MAC_RETRIES)
+        setRate(RX, DATA_RATE) # Both boards at the same data rate
+        setRate(TX, DATA_RATE)
+        gap = sweepGap(min(link_rates[RX_COM], link_rates[TX_COM]))
+
+        startSweep(RX, plan, gap, SWEEP_REPS, True) # Receiver listens first, so it hears the first payload
+        startSweep(TX, plan, gap, SWEEP_REPS, False) # Both boards now walk the frequencies by themselves
+        good = [] # Captures on which the line fit well, waiting for their transmit information
+        for freq, rep, msgs in protocol.sweepSlots(RX): # Handle each reception as the receiver streams it
+            if not msgs: # The payload was missed
+                continue
+            vals, rx_info = parseReception(msgs)
+            if vals==None: # If the packet was erroneous, skip it
                 continue
-           
-             
-            vals = np.unwrap(((2*np.pi/256)*np.array(vals))-np.pi) # Convert phase data to radians and unwrap it
-            m, b, r, _, _ = linregress(range(len(vals)), vals) # Compute LSRL for unwrapped phase data
-            
-            print('Slope: %f, Intercept: %f, Correlation coefficient: %f'%(m, b, r))
-            
-            # Save plot of phase data
-            plt.plot(np.linspace(0, rx_info['time'], len(vals)), np.unwrap(vals), marker='.', color='blue', label='Data')
-            plt.plot(np.linspace(0, rx_info['time'], len(vals)), m*np.arange(len(vals))+b, '--', color='red', label='Regression line')
-            plt.legend()
-            plt.xlabel('Time (us)')
-            plt.ylabel('Phase (radians)')
-            
-            # Save phase data provided it was sufficiently linear. If not, do not save and try again.
-            if r**2 >= .99:
-                print('Saving data...')
-                successes += 1
-                Data = {'channel': channel, 'rx info': rx_info, 'tx info': tx_info, 'values': vals, 'regression line': {'m': m, 'b': b, 'r': r}}
-                dt = datetime.datetime.now()
-                folder_name = 'data__%d_%d_%d__%d_%d_%d_%d'%(dt.year, dt.month, dt.day, dt.hour, dt.minute, dt.second, dt.microsecond)
-                folder_path = os.path.join(os.getcwd(), 'data', folder_name)
-                os.mkdir(folder_path)
-                with open(os.path.join(folder_path, 'Data.pickle'), 'wb') as F:
-                    pickle.dump(Data, F)
-                plt.savefig(os.path.join(folder_path, 'plot.png'))
-            plt.close()
-            
-        finally: # If errors happen, close VCOM ports and try again
-            RX.close()
-            TX.close()
-    successes = 0
-
-if True: # Toggle whether or not to generate plot of LSRL data over all channels -- takes a while
-    channels = []
+            vals, times, line = fitCapture(vals, rx_info)
+            if line['r']**2 >= .99 and successes[freq] + sum(1 for g in good if g[0] == freq) < CAPTURES: # Keep data provided it was sufficiently linear
+                good.append((freq, rep, vals, times, line, rx_info))
+        tx_infos = {(freq, rep): parseTransmission(msgs) for freq, rep, msgs in protocol.sweepSlots(TX)} # Transmissions, collected once the sweep is over
+        for freq, rep, vals, times, line, rx_info in good:
+            saveCapture(freq, vals, times, line, rx_info, tx_infos.get((freq, rep)))
+            successes[freq] += 1
+
+    finally: # If errors happen, close VCOM ports and try again
+        RX.close()
+        TX.close()
+
+if True: # Toggle whether or not to generate plot of LSRL data over all frequencies -- takes a while
+    freqs = []
     slopes = []
     intercepts = []
     for folder in os.listdir(os.path.join(os.getcwd(), 'data')):
         path = os.path.join(os.getcwd(), 'data', folder)
         with open(os.path.join(path, 'Data.pickle'), 'rb') as F:
             Data = pickle.load(F)
-        channels.append(Data['channel'])
+        freqs.append(Data['frequency'] if 'frequency' in Data else protocol.channelFreq(Data['channel'])) # Captures saved before frequency sweeps have a channel
         slopes.append(Data['regression line']['m'])
         intercepts.append(Data['regression line']['b'])
     fig, ax = plt.subplots(1, 1)
-    ax.plot(channels, slopes, '.', color='blue', label='slopes')
+    ax.plot(freqs, slopes, '.', color='blue', label='slopes')
     ax.set_ylabel('slopes')
-    ax.set_xlabel('channel')
+    ax.set_xlabel('frequency (MHz)')
     axt = ax.twinx()
     axt.set_ylabel('intercepts')
-    axt.plot(channels, intercepts, '.', color='red', label='intercepts')
+    axt.plot(freqs, intercepts, '.', color='red', label='intercepts')
     ax.legend()
     axt.legend()
     fig.savefig(os.path.join(os.getcwd(), 'plot.png'))
\ No newline at end of file
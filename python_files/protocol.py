@@ -0,0 +1,346 @@
+# -*- coding: utf-8 -*-
+"""
+Created on Sat Oct 17 2026
+"""
+
+# This file contains the computer end of the binary protocol the MSP430 firmware speaks over its VCOM port (see proto.c and proto.h).
+# Every message travels in a frame of its own: version, message type, sequence ID, payload length, payload and CRC-16/CCITT of all of those,
+# COBS-encoded and followed by a zero byte. Multi-byte fields are little-endian.
+# Every message the MSP430 sends about a command carries the sequence ID the command was sent with. The MSP430 queues commands, so several
+# can be in flight at once: see Pipeline.
+
+# Run as a script, it also converts between text and frames for the host simulator:
+#   printf 'CH 11\nTX\nRX\n' | python3 protocol.py encode | ../host/build/at86rf233_sim | python3 protocol.py decode
+
+import binascii
+import struct
+import sys
+import time
+
+VERSION = 7 # Protocol version; the MSP430 rejects frames of any other version
+DEFAULT_BAUD = 115200 # Baud rate of the MSP430 after reset, and after a change of rate that was not confirmed (VCOM_BAUD_DEFAULT in hal.h)
+ACK_TIMEOUT = 0.5 # Seconds Pipeline waits for the ACK of a command before sending it again; the ACK can queue behind a phase dump
+
+# Message types. Commands are sent by the computer, the others by the MSP430.
+TRANSMIT     = 0x01 # Have the AT86RF233 transmit a payload
+RECEIVE      = 0x02 # Have the AT86RF233 receive a payload
+CHANNEL      = 0x03 # Change the AT86RF233 channel; anything but channels 11 to 26 is ignored. Arguments: channel
+PERIOD       = 0x04 # Change the time between phase measurements. Arguments: period in ns
+SUMMARY      = 0x05 # Choose whether receptions are reported with the fitted line only (1) or with every phase measurement (0)
+BENCHMARK    = 0x06 # Measure the throughput of each kind of SPI transaction
+BAUD         = 0x07 # Change the baud rate; must be sent again at the new rate to confirm it. Arguments: baud rate
+SWEEP        = 0x08 # Transmit or receive payloads at a set of frequencies without the computer. Arguments: first frequency in MHz, step in MHz, mask of the steps to visit (see sweepPlan), gap in us, payloads per frequency, receive (1) or transmit (0)
+STATS        = 0x09 # Report how much time each task of the MSP430 scheduler has taken, and how much was spent asleep, then start counting again
+MAC          = 0x0A # Send payloads as acknowledged IEEE 802.15.4 data frames through the AT86RF233 extended operating mode (1) or as bare frames (0). Arguments: mode, own short address, short address of the other board, retransmissions
+RATE         = 0x0B # Change the data rate of the AT86RF233, and with it the time between phase measurements. Arguments: rate (see RATES), scrambler on (1) or off (0)
+FREQUENCY    = 0x0C # Move the AT86RF233 to any center frequency from FREQ_MIN to FREQ_MAX in 1 MHz steps, until the next channel change. Arguments: frequency in MHz
+BURST        = 0x0D # Transmit payloads back to back, each a set time after the end of the previous one, then report the burst. Arguments: payloads, time from the end of a payload to the start of the next in us (at most 5000)
+ACK          = 0x80 # A command was received intact and is being carried out
+ERROR        = 0x81 # A frame was rejected
+DONE         = 0x82 # A command has completed; nothing more will be sent about it
+TX_REPORT    = 0x83
+RX_REPORT    = 0x84
+PHASES       = 0x85
+FIT          = 0x86
+BENCH_REPORT = 0x87
+SLOT         = 0x88 # Start of a slot of a sweep, followed by the reports of its transmission or reception
+TASK_REPORT  = 0x89
+BURST_REPORT = 0x8A
+
+COMMANDS = {'TX': (TRANSMIT, ''), 'RX': (RECEIVE, ''), 'CH': (CHANNEL, '<B'), 'PR': (PERIOD, '<I'), 'SM': (SUMMARY, '<B'), 'BM': (BENCHMARK, ''), 'BR': (BAUD, '<I'), 'SW': (SWEEP, '<HBIIBB'), 'ST': (STATS, ''), 'MC': (MAC, '<BHHB'), 'DR': (RATE, '<BB'), 'FQ': (FREQUENCY, '<H'), 'BT': (BURST, '<HI')} # Text name and argument format of each command
+NAMES = {code: name for name, (code, _) in COMMANDS.items()}
+ERRORS = ['ok', 'bad encoding', 'bad length', 'bad CRC', 'bad version', 'bad type', 'busy'] # Reasons the MSP430 rejects a frame
+TASKS = ['radio', 'commands', 'analysis'] # Tasks of the MSP430 scheduler, by number
+TASK_IDLE = 0xFF # Stands for the time spent asleep
+RATES = [250, 500, 1000, 2000] # O-QPSK data rates in kb/s, by number
+TRAC = {0: 'success', 1: 'success, data pending', 2: 'success, wait for ACK', 3: 'channel access failure', 5: 'no ACK', 7: 'invalid'} # Outcomes of a transmission in MAC mode (TRAC_STATUS)
+CHANNELS = range(11, 27) # IEEE 802.15.4 channels of the 2.4 GHz band
+FREQ_MIN = 2322 # Lowest and highest center frequencies in MHz the AT86RF233 can tune to (AT86_FREQ_MIN and AT86_FREQ_MAX in at86.h)
+FREQ_MAX = 2527
+HOP_FAILED = 0xFFFF # Hop time of a SLOT message whose move to the frequency failed because the PLL did not lock (PROTO_HOP_FAILED in proto.h)
+SWEEP_POINTS = 32 # Most frequencies one sweep can visit
+BENCHES = ['REG_read', 'REG_write', 'REG_status', 'SRAM_read', 'SRAM_write', 'FB_read'] # Kinds of SPI transaction measured by the benchmark
+
+def crc(data): # CRC-16/CCITT with initial value 0xFFFF, as computed by the MSP430 CRC16 module
+    return binascii.crc_hqx(data, 0xFFFF)
+
+def cobsEncode(data): # Remove every zero byte from a frame
+    out = bytearray([0])
+    code_idx = 0 # Where the code of the block being encoded goes
+    for byte in data:
+        if byte == 0: # A zero ends the block; its code says where the zero was
+            out[code_idx] = len(out) - code_idx
+            code_idx = len(out)
+            out.append(0)
+        else:
+            out.append(byte)
+            if len(out) - code_idx == 0xFF: # Longest possible block
+                out[code_idx] = 0xFF
+                code_idx = len(out)
+                out.append(0)
+    out[code_idx] = len(out) - code_idx
+    return bytes(out)
+
+def cobsDecode(data): # Put the zero bytes back into a frame
+    out = bytearray()
+    idx = 0
+    while idx < len(data):
+        code = data[idx]
+        if code == 0 or idx + code > len(data):
+            raise ValueError('bad encoding')
+        out += data[idx+1:idx+code]
+        idx += code
+        if code != 0xFF and idx < len(data): # Every block but a full one and the last stood for a zero
+            out.append(0)
+    return bytes(out)
+
+def encodeFrame(msg_type, payload=b'', seq=0): # Build the bytes to send for a message, delimiter included
+    frame = bytes([VERSION, msg_type, seq, len(payload)]) + payload
+    return cobsEncode(frame + struct.pack('<H', crc(frame))) + b'\x00'
+
+def decodeFrame(data): # Check a frame received without its delimiter, and return its message type, sequence ID and payload
+    frame = cobsDecode(data)
+    if len(frame) < 6 or frame[3] != len(frame) - 6:
+        raise ValueError('bad length')
+    if crc(frame[:-2]) != struct.unpack('<H', frame[-2:])[0]:
+        raise ValueError('bad CRC')
+    if frame[0] != VERSION:
+        raise ValueError('bad version')
+    return frame[1], frame[2], frame[4:-2]
+
+def parseMessage(msg_type, seq, payload): # Turn a message from the MSP430 into a dictionary
+    msg = _parsePayload(msg_type, payload)
+    msg['seq'] = seq
+    return msg
+
+def _parsePayload(msg_type, payload):
+    if msg_type in (ACK, DONE):
+        return {'type': msg_type, 'command': payload[0]}
+    if msg_type == ERROR:
+        return {'type': msg_type, 'error': ERRORS[payload[0]]}
+    if msg_type == TX_REPORT:
+        address, time, outcome, retries, rate = struct.unpack('<BIBBB', payload)
+        return {'type': msg_type, 'address': address, 'time': time, 'outcome': TRAC.get(outcome, str(outcome)), 'retries': retries, 'rate': RATES[rate]}
+    if msg_type == RX_REPORT:
+        valid, length, address, payload_byte, time, rate = struct.unpack('<?BBBIB', payload)
+        return {'type': msg_type, 'valid': valid, 'length': length, 'address': address, 'payload': payload_byte, 'time': time, 'rate': RATES[rate]}
+    if msg_type == PHASES:
+        first, tick = struct.unpack('<HH', payload[:4])
+        samples = list(struct.iter_unpack('<BH', payload[4:]))
+        return {'type': msg_type, 'first': first, 'phases': [p for p, _ in samples], 'times': [t*tick for _, t in samples]} # Times in ns after start of reception
+    if msg_type == FIT:
+        count, slope, intercept, r2 = struct.unpack('<HiiI', payload)
+        return {'type': msg_type, 'count': count, 'slope': slope, 'intercept': intercept, 'r2': r2} # rad/s, mrad, parts per million
+    if msg_type == BENCH_REPORT:
+        bench, size, iterations, time, rate = struct.unpack('<BBHII', payload)
+        return {'type': msg_type, 'name': BENCHES[bench], 'bytes': size, 'iterations': iterations, 'time': time, 'rate': rate}
+    if msg_type == SLOT:
+        freq, rep, hop = struct.unpack('<HBH', payload)
+        return {'type': msg_type, 'freq': freq, 'rep': rep, 'hop': hop} # Center frequency in MHz; time in us the move to it took, 0 after the first repetition and HOP_FAILED if the PLL did not lock
+    if msg_type == TASK_REPORT:
+        task, runs, ticks, max_ticks, tick = struct.unpack('<BIQIH', payload)
+        name = 'idle' if task == TASK_IDLE else (TASKS[task] if task < len(TASKS) else str(task))
+        return {'type': msg_type, 'task': name, 'runs': runs, 'time': ticks*tick/1000, 'max': max_ticks*tick/1000} # Times in us
+    if msg_type == BURST_REPORT:
+        frames, underruns, failures, uploads, time, rate = struct.unpack('<HHHHIB', payload)
+        return {'type': msg_type, 'frames': frames, 'underruns': underruns, 'failures': failures, 'uploads': uploads, 'time': time, 'rate': RATES[rate]} # Payloads that went out with TRX_UR, were not acknowledged in MAC mode, and writes to the frame buffer; time in us
+    return {'type': msg_type, 'payload': payload}
+
+def readMessage(ser): # Wait for the next intact message from the MSP430; frames that fail their checks are skipped
+    while True:
+        data = ser.read_until(b'\x00')[:-1]
+        try:
+            return parseMessage(*decodeFrame(data))
+        except ValueError:
+            pass
+
+_last_seq = 0
+def nextSeq(): # Sequence ID for the next command: 1 to 255, 0 being what the MSP430 reports for frames it could not read
+    global _last_seq
+    _last_seq = _last_seq%255 + 1
+    return _last_seq
+
+def commandFrame(command, *args, seq=0): # Build the frame of a command, e.g. commandFrame('CH', 11, seq=1)
+    code, fmt = COMMANDS[command]
+    return encodeFrame(code, struct.pack(fmt, *args) if fmt else b'', seq)
+
+def sendCommand(ser, command, *args): # Send a command, e.g. sendCommand(ser, 'CH', 11), and wait until the MSP430 acknowledges it; returns its sequence ID
+    seq = nextSeq()
+    frame = commandFrame(command, *args, seq=seq)
+    ser.write(frame)
+    while True:
+        msg = readMessage(ser)
+        if msg['type'] == ACK and msg['seq'] == seq:
+            return seq
+        if msg['type'] == ERROR and msg['seq'] in (seq, 0): # The MSP430 rejected the frame; send it again
+            ser.write(frame)
+        # Anything else is still about an earlier command
+
+def readUntilDone(ser): # Collect the messages the MSP430 sends about a command until it has completed, when only one is in flight
+    msgs = []
+    while True:
+        msg = readMessage(ser)
+        if msg['type'] == DONE:
+            return msgs
+        msgs.append(msg)
+
+def runCommand(ser, command, *args): # Send a command and collect the messages the MSP430 sends about it
+    sendCommand(ser, command, *args)
+    return readUntilDone(ser)
+
+def setBaud(ser, rate, timeout=0.1): # Move the link to a new baud rate, returning whether the MSP430 and its USB bridge kept up; if not, both ends go back to DEFAULT_BAUD. No other command may be in flight.
+    seq = sendCommand(ser, 'BR', rate) # Acknowledged at the old rate
+    ser.baudrate = rate
+    ser.timeout = timeout
+    try:
+        ser.write(commandFrame('BR', rate, seq=seq)) # Confirm the rate by sending the command again at it
+        data = ser.read_until(b'\x00')
+        msg = parseMessage(*decodeFrame(data[:-1])) if data.endswith(b'\x00') else None
+    except ValueError:
+        msg = None
+    finally:
+        ser.timeout = None
+    if msg is not None and msg['type'] == DONE and msg['command'] == BAUD:
+        return True
+    ser.baudrate = DEFAULT_BAUD # The MSP430 falls back once it has waited long enough for the confirmation
+    ser.reset_input_buffer()
+    readUntilDone(ser)
+    return False
+
+def negotiateBaud(ser, rates=(921600, 460800, 230400)): # Move the link to the fastest of several baud rates that works, returning the rate in use
+    for rate in rates:
+        if setBaud(ser, rate):
+            return rate
+    return ser.baudrate
+
+class Pipeline: # Keeps several commands in flight on one MSP430, e.g. the next channel change and RX while the current phase dump is still streaming
+    def __init__(self, ser):
+        self.ser = ser
+        self.unacked = {} # Frames of commands not acknowledged yet and when they were last sent, by sequence ID
+        self.busy = {} # Frames rejected as busy (command queue full, or a baud rate change awaiting confirmation), sent again once a command completes, by sequence ID
+        self.msgs = {} # Messages about each command in flight, by sequence ID
+        self.done = set() # Commands that have completed and not been collected
+        self.rx = bytearray() # Bytes of a message from the MSP430 still being received
+
+    def _send(self, seq, frame): # Send the frame of a command, and wait for its ACK again
+        self.unacked[seq] = (frame, time.monotonic())
+        self.ser.write(frame)
+
+    def _read(self): # The next intact message from the MSP430, or None if there was none within ACK_TIMEOUT or it failed its checks
+        timeout = self.ser.timeout
+        self.ser.timeout = ACK_TIMEOUT
+        try:
+            self.rx += self.ser.read_until(b'\x00')
+        finally:
+            self.ser.timeout = timeout
+        if not self.rx.endswith(b'\x00'): # The rest of the message comes with the next read.
+            return None
+        data = bytes(self.rx[:-1])
+        self.rx = bytearray()
+        try:
+            return parseMessage(*decodeFrame(data))
+        except ValueError:
+            return None
+
+    def submit(self, command, *args): # Send a command without waiting for anything; returns its sequence ID
+        seq = nextSeq()
+        self.msgs[seq] = []
+        self._send(seq, commandFrame(command, *args, seq=seq))
+        return seq
+
+    def poll(self): # Handle the next message from the MSP430, if one comes within ACK_TIMEOUT, then send again the commands it has not acknowledged in time
+        msg = self._read()
+        if msg is not None:
+            self._handle(msg)
+        now = time.monotonic()
+        for seq, (frame, sent) in list(self.unacked.items()):
+            if now - sent >= ACK_TIMEOUT: # Lost, or rejected without a readable sequence ID
+                self._send(seq, frame)
+
+    def _handle(self, msg): # Act on a message from the MSP430
+        seq = msg['seq']
+        if msg['type'] == ACK:
+            self.unacked.pop(seq, None)
+        elif msg['type'] == ERROR:
+            if seq in self.unacked and msg['error'] == 'busy':
+                self.busy[seq] = self.unacked.pop(seq)[0]
+            elif seq in self.unacked:
+                self._send(seq, self.unacked[seq][0])
+            # A frame whose sequence ID was lost is sent again by poll once it is overdue, not at once: if the ERROR was about another frame,
+            # its ACK may still be on the way, and the MSP430 would carry the command out twice.
+        elif msg['type'] == DONE:
+            self.done.add(seq)
+            for busy_seq, frame in self.busy.items(): # There is room in the queue now
+                self._send(busy_seq, frame)
+            self.busy = {}
+        elif seq in self.msgs:
+            self.msgs[seq].append(msg)
+
+    def wait(self, seq): # Wait until a command has completed, and return the messages about it
+        while seq not in self.done:
+            self.poll()
+        self.done.remove(seq)
+        return self.msgs.pop(seq)
+
+def channelFreq(channel): # Center frequency in MHz of a channel
+    return 2405 + 5*(channel - 11)
+
+def sweepPlan(freqs, step): # Arguments of the SW command that visit as many of a list of frequencies in MHz, all on a grid of step MHz, as one sweep can: first frequency, step and mask; frequencies the AT86RF233 can't tune to are left out
+    freqs = sorted(f for f in freqs if FREQ_MIN <= f <= FREQ_MAX)
+    first = freqs[0]
+    return first, step, sum(1<<((f - first)//step) for f in freqs if (f - first)//step < SWEEP_POINTS)
+
+def sweepSlots(ser): # Collect the slots of a sweep started with sendCommand(ser, 'SW', ...) as the MSP430 streams them: yields frequency, repetition and the messages about the slot
+    slot = None
+    while True:
+        msg = readMessage(ser)
+        if msg['type'] in (SLOT, DONE) and slot is not None:
+            yield slot
+        if msg['type'] == DONE:
+            return
+        if msg['type'] == SLOT:
+            slot = (msg['freq'], msg['rep'], [])
+        elif slot is not None:
+            slot[2].append(msg)
+
+def formatMessage(msg): # Describe a message from the MSP430 in text
+    msg_type = msg['type']
+    if msg_type in (ACK, DONE):
+        return '%s %s'%('ack' if msg_type == ACK else 'done', NAMES.get(msg['command'], msg['command']))
+    if msg_type == ERROR:
+        return 'error %s'%msg['error']
+    if msg_type == TX_REPORT:
+        return '(TX) Address: 0x%x, Time: %d us at %d kb/s, Outcome: %s, Retries: %d'%(msg['address'], msg['time'], msg['rate'], msg['outcome'], msg['retries'])
+    if msg_type == RX_REPORT:
+        if msg['valid']:
+            return '(valid RX) Length: %d, Address: 0x%x, Time: %d us at %d kb/s'%(msg['length'], msg['address'], msg['time'], msg['rate'])
+        return '(invalid RX) Length: %d, Address: 0x%x, Payload: 0x%x'%(msg['length'], msg['address'], msg['payload'])
+    if msg_type == PHASES:
+        return '\n'.join('%x %d'%(p, t) for p, t in zip(msg['phases'], msg['times']))
+    if msg_type == FIT:
+        return 'fit %d %d %d %d'%(msg['count'], msg['slope'], msg['intercept'], msg['r2'])
+    if msg_type == BENCH_REPORT:
+        return '%s: %d bytes x %d in %d us, %d B/s'%(msg['name'], msg['bytes'], msg['iterations'], msg['time'], msg['rate'])
+    if msg_type == SLOT:
+        return 'slot %d MHz rep %d'%(msg['freq'], msg['rep']) + ((', PLL did not lock' if msg['hop'] == HOP_FAILED else ', hop %d us'%msg['hop']) if msg['rep'] == 0 else '')
+    if msg_type == TASK_REPORT:
+        return 'task %s: %d runs, %.0f us, max %.0f us'%(msg['task'], msg['runs'], msg['time'], msg['max'])
+    if msg_type == BURST_REPORT:
+        return 'burst %d frames in %d us at %d kb/s (%.0f frames/s), %d underruns, %d not acknowledged, %d frame buffer writes'%(msg['frames'], msg['time'], msg['rate'], msg['frames']*1e6/max(msg['time'], 1), msg['underruns'], msg['failures'], msg['uploads'])
+    return 'unknown message 0x%x'%msg_type
+
+if __name__ == '__main__':
+    if len(sys.argv) == 2 and sys.argv[1] == 'encode': # Text commands such as 'CH 11' on stdin, frames on stdout, numbered from 1
+        for line in sys.stdin:
+            words = line.split()
+            if words:
+                sys.stdout.buffer.write(commandFrame(words[0], *[int(word, 0) for word in words[1:]], seq=nextSeq()))
+    elif len(sys.argv) == 2 and sys.argv[1] == 'decode': # Frames on stdin, text on stdout
+        for data in sys.stdin.buffer.read().split(b'\x00')[:-1]:
+            try:
+                msg = parseMessage(*decodeFrame(data))
+                print(formatMessage(msg) if msg['type'] == PHASES else '#%d %s'%(msg['seq'], formatMessage(msg)))
+            except ValueError as e:
+                print('frame rejected: %s'%e)
+    else:
+        print('usage: python3 protocol.py encode|decode', file=sys.stderr)
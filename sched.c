@@ -0,0 +1,101 @@
+/*
+ * sched.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// This file contains a run-to-completion scheduler. Each task is a function that does a bounded piece of work and returns; interrupt
+// handlers (UART, USB, AT86RF233 IRQ, ...) post the tasks that should deal with what they saw, and tasks can post each other, or themselves
+// to carry on with a long job after the others have had a turn. The ready task of highest priority (lowest number) is run next. A task posted
+// several times before it runs, runs once. When nothing is ready, the CPU sleeps in LPM0 until an interrupt handler wakes it up.
+// The time spent in each task, and asleep, is accounted in timestamp ticks (200 ns). Time spent in interrupt handlers is counted towards
+// whatever they interrupted, and so is time a task spends sleeping in VCOM_waitTx or the like.
+
+#include <msp430.h> // Intrinsics to enable interrupts and enter low-power modes
+#include "sched.h" // Declarations of functions/macros in this file
+#include "hal.h" // Definitions of pins, peripheral initialization details, etc.
+#include "timestamp.h" // Time base the runtime is accounted in
+#include "assert_app.h" // Assert statements so we can abort code if errors happen
+
+static const SCHED_Task * sched_tasks; // Tasks, highest priority first
+static uint8_t sched_count = 0; // Number of tasks
+static volatile uint8_t sched_ready = 0; // Bit n set if task n has been posted and has not run since
+static SCHED_Stats sched_stats[SCHED_MAX_TASKS]; // Runtime accounting of each task
+static SCHED_Stats sched_idle; // Runtime accounting of the time spent asleep
+
+// This function adds a run to the accounting of a task.
+//  stats: accounting to add to.
+//  start: timestamp of the start of the run.
+static void _account(SCHED_Stats * stats, uint32_t start)
+{
+    uint32_t ticks = TS_now() - start;
+    ++stats->runs;
+    stats->ticks += ticks;
+    if(ticks > stats->max_ticks)
+        stats->max_ticks = ticks;
+}
+
+// This function sets the tasks the scheduler runs, and clears their accounting.
+//  tasks: the tasks, highest priority first. The array must remain valid.
+//  count: number of tasks, at most SCHED_MAX_TASKS.
+void SCHED_init(const SCHED_Task * tasks, uint8_t count)
+{
+    assert(count <= SCHED_MAX_TASKS);
+    sched_tasks = tasks;
+    sched_count = count;
+    sched_ready = 0;
+    SCHED_resetStats();
+}
+
+// This function has a task run once the ready tasks of higher priority have run. If it is already waiting to run, it still runs once.
+//  task: number of the task.
+void SCHED_post(uint8_t task)
+{
+    uint16_t gie = __get_interrupt_state(); // Interrupt state to return to.
+    __disable_interrupt(); // Interrupt handlers post tasks too.
+    sched_ready |= (uint8_t) (1U << task);
+    __set_interrupt_state(gie);
+}
+
+// This function runs the tasks as they are posted, and puts the CPU to sleep whenever none is ready. Interrupt handlers that post a task must
+// wake the CPU up on exit. Never returns.
+void SCHED_run(void)
+{
+    while(1)
+    {
+        __disable_interrupt(); // Don't let a task be posted between checking for one and going to sleep.
+        uint8_t ready = sched_ready;
+        if(ready == 0)
+        {
+            uint32_t start = TS_now();
+            __bis_SR_register(LPM0_bits + GIE); // Sleep until an interrupt handler wakes us up.
+            _account(&sched_idle, start);
+            continue;
+        }
+        uint8_t task = 0;
+        while(!(ready & (1U << task))) // Lowest number first
+            ++task;
+        sched_ready &= (uint8_t) ~(1U << task); // Posting it again from now on has it run again.
+        __enable_interrupt();
+        uint32_t start = TS_now();
+        sched_tasks[task]();
+        _account(&sched_stats[task], start);
+    }
+}
+
+// This function retrieves the runtime accounting of a task since the last SCHED_resetStats.
+//  task: number of the task, or SCHED_IDLE for the time spent asleep.
+//  stats: where to store it.
+void SCHED_getStats(uint8_t task, SCHED_Stats * stats)
+{
+    *stats = (task == SCHED_IDLE) ? sched_idle : sched_stats[task];
+}
+
+// This function clears the runtime accounting of every task, and of the time spent asleep.
+void SCHED_resetStats(void)
+{
+    uint8_t task;
+    for(task=0; task<SCHED_MAX_TASKS; ++task)
+        sched_stats[task] = (SCHED_Stats) {0, 0, 0};
+    sched_idle = (SCHED_Stats) {0, 0, 0};
+}
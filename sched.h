@@ -0,0 +1,33 @@
+/*
+ * sched.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// File with function declarations for sched.c. Specific details in this file.
+
+#ifndef SCHED_H_
+#define SCHED_H_
+
+#include <stdint.h> // Specific definitions of integers
+#include <stdbool.h> // Definition of bool data type
+
+#define SCHED_MAX_TASKS (8U) // Most tasks the scheduler can run
+#define SCHED_IDLE      (0xFFU) // Stands for the time spent asleep with no task ready, wherever a task number is expected
+
+typedef void (*SCHED_Task)(void); // Task: runs to completion, and is run again each time it is posted.
+
+typedef struct // Runtime accounting of a task, in timestamp ticks (TS_FREQ)
+{
+    uint32_t runs; // Times it has run (for SCHED_IDLE: times the CPU has been woken up)
+    uint64_t ticks; // Total time spent in it
+    uint32_t max_ticks; // Longest single run
+} SCHED_Stats;
+
+void SCHED_init(const SCHED_Task * tasks, uint8_t count); // Set the tasks to run, highest priority first.
+void SCHED_post(uint8_t task); // Have a task run once the tasks of higher priority are done. Can be called from interrupt handlers.
+void SCHED_run(void); // Run tasks as they are posted, sleeping when none is. Never returns.
+void SCHED_getStats(uint8_t task, SCHED_Stats * stats); // Get the runtime accounting of a task, or of SCHED_IDLE.
+void SCHED_resetStats(void); // Clear the runtime accounting of every task.
+
+#endif /* SCHED_H_ */
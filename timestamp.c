@@ -0,0 +1,91 @@
+/*
+ * timestamp.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// This file contains the time base shared by everything that needs to know when something happened: transmissions, receptions, phase
+// measurements, deadlines and the runtime accounting of the scheduler. TS_TIMER_BASE counts SMCLK/4 continuously (200 ns per tick), and its
+// overflow interrupt counts the times it wraps around, every 13.1 ms; together they make a 48-bit count, returned as 32 bits by TS_now and in
+// full by TS_now64. Both can be called from interrupt handlers as well as from tasks. The overflow interrupt must not be held off for more
+// than half a turn of the timer (6.5 ms), or a timestamp taken meanwhile may miss the overflow.
+// Capture registers of the timer can timestamp edges on their pins in hardware; TS_extend turns the count they latch into a timestamp.
+// With PHASE_DMA = 0, phase.c paces its measurements with CCR0 of the same timer, so they are taken on this time base too.
+
+#include "timestamp.h" // Declarations of functions/macros in this file
+#include "hal.h" // Definitions of pins, peripheral initialization details, etc.
+#include "timer_a.h" // TI-provided file to control MSP430 hardware timer
+
+#define TS_TIMER_R HWREG16(TS_TIMER_BASE + OFS_TAxR) // Timer count. The timer runs from SMCLK like the CPU, so it can be read directly.
+
+static volatile uint32_t ts_overflows = 0; // Times the timer has wrapped around since TS_init: the bits of timestamps above the count
+
+// This function starts the timer timestamps are taken from, and its overflow interrupt. Timestamps count from here.
+void TS_init(void)
+{
+    Timer_A_initContinuousModeParam timera_settings =
+    {
+     .clockSource = TIMER_A_CLOCKSOURCE_SMCLK,
+     .clockSourceDivider = TS_TIMER_DIVIDER,
+     .timerInterruptEnable_TAIE = TIMER_A_TAIE_INTERRUPT_ENABLE,
+     .timerClear = TIMER_A_DO_CLEAR,
+     .startTimer = true
+    };
+    Timer_A_initContinuousMode(TS_TIMER_BASE, &timera_settings);
+    ts_overflows = 0;
+}
+
+// This function reads the count of the timer and the overflows above it as one consistent value.
+//  high: where to store the overflows.
+// Returns the count.
+static uint16_t _read(uint32_t * high)
+{
+    uint16_t gie = __get_interrupt_state(); // Interrupt state to return to.
+    __disable_interrupt(); // The overflow interrupt must not count an overflow between the two reads.
+    uint16_t low = TS_TIMER_R;
+    *high = ts_overflows;
+    if((Timer_A_getInterruptStatus(TS_TIMER_BASE) == TIMER_A_INTERRUPT_PENDING) && !(low & 0x8000U))
+        ++*high; // The count wrapped around before it was read, and the interrupt handler has not run yet (we may be in another one).
+    __set_interrupt_state(gie);
+    return low;
+}
+
+// This function returns the current time.
+//  returns: TS_FREQ ticks since TS_init, modulo 2^32. The difference of two such timestamps is valid as long as they are less than 859 s apart.
+uint32_t TS_now(void)
+{
+    uint32_t high;
+    uint16_t low = _read(&high);
+    return (high << 16) | low;
+}
+
+// This function returns the current time without wrapping around.
+//  returns: TS_FREQ ticks since TS_init.
+uint64_t TS_now64(void)
+{
+    uint32_t high;
+    uint16_t low = _read(&high);
+    return ((uint64_t) high << 16) | low;
+}
+
+// This function turns a count of the timer latched by one of its capture registers into a timestamp. The capture must have been taken less
+// than a turn of the timer (13.1 ms) ago.
+//  count: captured count.
+//  returns: timestamp of the capture, comparable with those returned by TS_now.
+uint32_t TS_extend(uint16_t count)
+{
+    uint32_t now = TS_now();
+    return now - (uint16_t) ((uint16_t) now - count); // Ticks since the capture, which fit in the 16 bits of the count
+}
+
+// Interrupt triggered when the timer wraps around. CCR1 and up of the timer share it, but don't have their interrupts enabled: CCR3
+// captures the frame timestamp of the AT86RF233 (see AT86_getRxStart).
+#pragma vector=TIMER0_A1_VECTOR
+void __attribute__ ((interrupt)) _overflowIrqHandler(void)
+{
+    if(Timer_A_getInterruptStatus(TS_TIMER_BASE) == TIMER_A_INTERRUPT_PENDING)
+    {
+        Timer_A_clearTimerInterrupt(TS_TIMER_BASE);
+        ++ts_overflows;
+    }
+}
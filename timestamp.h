@@ -0,0 +1,24 @@
+/*
+ * timestamp.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+// File with function declarations for timestamp.c. Specific details in this file.
+
+#ifndef TIMESTAMP_H_
+#define TIMESTAMP_H_
+
+#include <stdint.h> // Specific definitions of integers
+#include "hal.h" // TS_FREQ
+
+#define TS_TICKS_PER_US (TS_FREQ/1000000UL) // Timestamp ticks per microsecond
+#define TS_US(us)       ((uint32_t) (us)*TS_TICKS_PER_US) // Convert a time in us to timestamp ticks
+#define TS_TO_US(ticks) ((uint32_t) (ticks)/TS_TICKS_PER_US) // Convert a time in timestamp ticks to us
+
+void     TS_init(void); // Start the timer timestamps are taken from.
+uint32_t TS_now(void); // Current time, in TS_FREQ ticks. Differences are valid up to 859 s.
+uint64_t TS_now64(void); // Current time, in TS_FREQ ticks since TS_init.
+uint32_t TS_extend(uint16_t count); // Timestamp of a count of the timer captured less than 13.1 ms ago.
+
+#endif /* TIMESTAMP_H_ */
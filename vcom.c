@@ -7,22 +7,209 @@
 
 // This file contains functions that will allow us to talk to the computer over USB. The MSP-EXP430F5529LP has a USB chip which we can talk to
 // using a UART; the chip will relay everything we say to the computer using a USB virtual COM port.
+// With VCOM_USB = 1, the MSP430F5529 USB module is used instead, through the CDC API of the TI MSP430 USB Developers Package: the LaunchPad
+// enumerates as a CDC-ACM port of its own on the target USB connector, and bytes move in 64-byte bulk packets at up to about 1 MB/s rather than
+// 11.5 kB/s. The ring buffers and functions below are the same for both; the stack calls USBCDC_handleDataReceived and
+// USBCDC_handleSendCompleted (in place of the empty ones of its usbEventHandling.c) where the UART would interrupt.
+// With VCOM_DMA = 1, bytes waiting in the transmit ring buffer are handed to a DMA channel a contiguous span at a time: the CPU writes the
+// first byte of the span, and every rising edge of UCA1TXIFG after that has the DMA channel write the next one. Interrupts only happen at the
+// ends of spans, instead of after every byte.
 
 
+#include <stddef.h> // Definition of NULL
 #include "vcom.h" // Declarations of functions/macros in this file
 #include "hal.h" // Definitions of pins, peripheral initialization details, etc.
 #include "gpio.h" // TI-provided file to control MSP430 GPIO pins
 #include "usci_a_uart.h" // TI-provided file to control MSP430 UART
+#include "ucs.h" // TI-provided file to control MSP430 clocks
 #include "assert_app.h" // Assert statements so we can abort code if errors happen
+#if VCOM_USB
+#include "USB_config/descriptors.h" // Interface numbers of the CDC-ACM configuration made with the TI descriptor tool
+#include "USB_API/USB_Common/usb.h" // TI-provided file to control MSP430 USB module
+#include "USB_API/USB_CDC_API/UsbCdc.h" // TI-provided file to send and receive over a USB CDC interface
+#endif
+#if VCOM_DMA
+#include "dma.h" // TI-provided file to control MSP430 DMA controller
+#endif
 
-static volatile uint8_t uart_rx[256]; // Buffer to store strings we receive over VCOM
-static volatile uint8_t uart_rx_idx = 0; // Index of above buffer
-static volatile bool uart_rx_available = false; // Track whether buffer contains a complete command
-#define UART_BREAKCHAR ('\n') // Character indicating end of a complete command
+static volatile uint8_t uart_rx[VCOM_RX_SLOTS][VCOM_RX_SLOT_LEN]; // Ring of frames we receive over VCOM, one per slot, each stored as a string
+#define UART_RX_MASK (VCOM_RX_SLOTS-1U) // Maps a free-running slot index to its place in the ring
+static volatile uint8_t uart_rx_head = 0; // Free-running index of the slot the frame being received goes in. Only written by the interrupt handler.
+static volatile uint8_t uart_rx_tail = 0; // Free-running index of the oldest complete frame. Only written by VCOM_releaseRx.
+static volatile uint8_t uart_rx_idx = 0; // Bytes of the frame being received stored so far
+static volatile bool uart_rx_discard = false; // Whether the frame being received is being dropped, for lack of a free slot or room in its slot
+static uint16_t uart_rx_dropped = 0; // Frames dropped
+static VCOM_Handler uart_rx_handler = NULL; // Called whenever a frame has been stored, or NULL
+#define UART_BREAKCHAR (0x00) // Character indicating end of a complete command: the delimiter of the frames of proto.c
 
-static volatile uint8_t uart_tx[256]; // Buffer to store strings we are going to transmit over VCOM
-static volatile uint8_t uart_tx_len = 0; // Total length of string we will send
-static volatile uint8_t uart_tx_idx = 0; // Index of above buffer
+static volatile uint8_t uart_tx[VCOM_TX_BUFFER_LEN]; // Ring buffer of bytes we are going to transmit over VCOM
+#define UART_TX_MASK (VCOM_TX_BUFFER_LEN-1U) // Maps a free-running index to its place in the ring buffer
+static volatile uint16_t uart_tx_head = 0; // Free-running index at which the next byte will be stored. Only written by VCOM_tx.
+static volatile uint16_t uart_tx_tail = 0; // Free-running index of the next byte to transmit. Only written once transmission has started.
+static volatile bool uart_tx_busy = false; // Whether the UART is transmitting, in which case its transmit interrupt empties the ring buffer
+static volatile uint16_t uart_tx_wanted = 0; // Free space VCOM_waitTx is sleeping until, or 0
+static uint16_t uart_tx_high_water = 0; // Most bytes ever waiting in the ring buffer
+static uint16_t uart_tx_dropped = 0; // Messages dropped because the ring buffer did not have room for them
+#if VCOM_DMA || VCOM_USB
+static volatile uint16_t uart_tx_span = 0; // Bytes the DMA channel is writing to the UART after the first byte of its span, or that the USB
+                                           // module is sending, or 0
+#endif
+#if VCOM_DMA
+static volatile bool uart_dma_lent = false; // Whether the DMA channel has been lent out, in which case every byte is written by the transmit interrupt
+#endif
+
+// This function returns how many bytes can be added to the transmit ring buffer.
+static uint16_t _txFree(void)
+{
+    return VCOM_TX_BUFFER_LEN - (uint16_t) (uart_tx_head - uart_tx_tail);
+}
+
+// This function returns whether VCOM_waitTx is sleeping until there is as much room as there is now, forgetting that it was if so. Must be
+// called with interrupts disabled.
+static bool _wakeWriter(void)
+{
+    if((uart_tx_wanted == 0) || (_txFree() < uart_tx_wanted))
+        return false;
+    uart_tx_wanted = 0;
+    return true;
+}
+
+// This function stores a byte received from the computer in the slot of the frame being received. A frame that does not fit, or that
+// arrives while every slot holds a frame waiting to be read, is dropped; the computer finds out when it is not acknowledged.
+//  rv: the byte.
+// Returns true if it completed a frame.
+static bool _rxByte(uint8_t rv)
+{
+    bool full = ((uint8_t) (uart_rx_head - uart_rx_tail) == VCOM_RX_SLOTS); // Every slot holds a frame waiting to be read
+    if(rv == UART_BREAKCHAR) // Character indicates completion of a command
+    {
+        bool stored = !uart_rx_discard && !full;
+        if(stored)
+        {
+            uart_rx[uart_rx_head & UART_RX_MASK][uart_rx_idx] = '\0'; // Add null character to end so it can be parsed using standard C string libraries
+            ++uart_rx_head; // The frame can be read; the next one goes in the next slot.
+            if(uart_rx_handler != NULL)
+                uart_rx_handler(); // Let the code that reads frames know about it.
+        }
+        else
+            ++uart_rx_dropped;
+        uart_rx_idx = 0;
+        uart_rx_discard = false;
+        return stored;
+    }
+    if(full || (uart_rx_idx == VCOM_RX_SLOT_LEN-1U)) // No room for the character, and the terminating null character after it
+        uart_rx_discard = true;
+    else
+        uart_rx[uart_rx_head & UART_RX_MASK][uart_rx_idx++] = rv; // Store the character in the slot
+    return false;
+}
+
+#if VCOM_USB || VCOM_DMA
+// This function returns how many of the bytes waiting in the transmit ring buffer can be handed over at once: they must be contiguous, and
+// at most VCOM_TX_MAX_SPAN. Must be called with at least one byte waiting.
+static uint16_t _txSpan(void)
+{
+    uint16_t span = uart_tx_head - uart_tx_tail; // Bytes waiting
+    uint16_t to_end = VCOM_TX_BUFFER_LEN - (uart_tx_tail & UART_TX_MASK); // A span can't wrap around the end of the ring buffer.
+    if(span > to_end)
+        span = to_end;
+    if(span > VCOM_TX_MAX_SPAN)
+        span = VCOM_TX_MAX_SPAN;
+    return span;
+}
+#endif
+
+#if VCOM_USB
+// This function hands the next span of the ring buffer to the USB module, which sends it in the background and calls
+// USBCDC_handleSendCompleted once it is done. If there is no computer to take it (cable unplugged, port not opened), everything waiting is
+// lost, as it would be on the UART. Must be called with interrupts disabled and at least one byte waiting.
+static void _txStart(void)
+{
+    uart_tx_span = _txSpan();
+    if(USBCDC_sendData((uint8_t *) &uart_tx[uart_tx_tail & UART_TX_MASK], uart_tx_span, VCOM_USB_INTF) != kUSBCDC_sendStarted)
+    {
+        uart_tx_tail = uart_tx_head;
+        uart_tx_span = 0;
+        uart_tx_busy = false;
+    }
+}
+
+// This function is called by the USB stack from its interrupt handler when the span handed to it has been sent, and starts the next one.
+//  intfNum: CDC interface.
+// Returns true if the CPU should be woken up on exit from the interrupt, for VCOM_waitTx to return.
+uint8_t USBCDC_handleSendCompleted(uint8_t intfNum)
+{
+    uart_tx_tail += uart_tx_span; // The span is out of the ring buffer, so its room can be reused.
+    uart_tx_span = 0;
+    if(uart_tx_tail != uart_tx_head) // There are more characters to transmit
+        _txStart();
+    else // We are done transmitting characters
+        uart_tx_busy = false;
+    return _wakeWriter();
+}
+
+// This function moves bytes from the computer out of the endpoint buffer into the RX ring, until there are none left or every slot holds a
+// frame waiting to be read. Bytes left behind keep the endpoint NAKing the computer, so with USB no frame is dropped for lack of a slot.
+// Must be called with interrupts disabled.
+// Returns true if it completed a frame.
+static bool _usbRx(void)
+{
+    bool wake = false;
+    uint8_t rv;
+    while(((uint8_t) (uart_rx_head - uart_rx_tail) != VCOM_RX_SLOTS) && (USBCDC_receiveDataInBuffer(&rv, 1, VCOM_USB_INTF) != 0))
+        wake |= _rxByte(rv);
+    return wake;
+}
+
+// This function is called by the USB stack from its interrupt handler when bytes from the computer are waiting in the endpoint buffer, and
+// moves them to the RX ring.
+//  intfNum: CDC interface.
+// Returns true if the CPU should be woken up on exit from the interrupt, because a frame has been completed.
+uint8_t USBCDC_handleDataReceived(uint8_t intfNum)
+{
+    return _usbRx();
+}
+#else
+#if VCOM_DMA
+// This function sets up the DMA channel that feeds the UART transmit buffer. The source address and size are set for each span.
+static void _dmaInit(void)
+{
+    DMA_initParam settings =
+    {
+     .channelSelect = VCOM_DMA_CHANNEL,
+     .transferModeSelect = DMA_TRANSFER_SINGLE,
+     .transferSize = 0,
+     .triggerSourceSelect = VCOM_DMA_TRIGGER,
+     .transferUnitSelect = DMA_SIZE_SRCBYTE_DSTBYTE,
+     .triggerTypeSelect = DMA_TRIGGER_RISINGEDGE
+    };
+    DMA_init(&settings);
+    DMA_setDstAddress(VCOM_DMA_CHANNEL, USCI_A_UART_getTransmitBufferAddressForDMA(MCU_BCUA_UCA), DMA_DIRECTION_UNCHANGED);
+    DMA_enableInterrupt(VCOM_DMA_CHANNEL); // The last byte of a span marks its end.
+}
+#endif
+
+// This function writes the next byte of the ring buffer to the UART, which must be ready for it. With VCOM_DMA = 1, the bytes after it up
+// in the same span (see _txSpan) are handed to the DMA channel, and the transmit interrupt is disabled until the DMA
+// interrupt says they have all been written. Must be called with interrupts disabled and at least one byte waiting.
+static void _txStart(void)
+{
+#if VCOM_DMA
+    uint16_t span = _txSpan();
+    if(!uart_dma_lent && (span > 1))
+    {
+        DMA_setSrcAddress(VCOM_DMA_CHANNEL, (uintptr_t) &uart_tx[(uart_tx_tail+1) & UART_TX_MASK], DMA_DIRECTION_INCREMENT);
+        DMA_setTransferSize(VCOM_DMA_CHANNEL, span-1);
+        DMA_enableTransfers(VCOM_DMA_CHANNEL); // Before the first byte is written, so that the edge of UCA1TXIFG it causes is seen
+        uart_tx_span = span-1;
+        USCI_A_UART_disableInterrupt(MCU_BCUA_UCA, USCI_A_UART_TRANSMIT_INTERRUPT);
+    }
+    else
+#endif
+        USCI_A_UART_enableInterrupt(MCU_BCUA_UCA, USCI_A_UART_TRANSMIT_INTERRUPT); // UART will interrupt every time its TX buffer is empty and we can transmit a new character
+    USCI_A_UART_transmitData(MCU_BCUA_UCA, uart_tx[uart_tx_tail & UART_TX_MASK]); // Transmit the first character (subsequent characters are written by the DMA channel or the interrupt handler)
+    ++uart_tx_tail;
+}
 
 // Interrupt triggered when hardware UART requires our attention
 #pragma vector=USCI_A1_VECTOR
@@ -32,87 +219,248 @@ void __attribute__ ((interrupt)) serviceUart(void)
     USCI_A_UART_clearInterrupt(MCU_BCUA_UCA, 0xFF); // Clear interrupt flags so we can detect future interrupts
     if(flags & USCI_A_UART_RECEIVE_INTERRUPT_FLAG) // UART has received a character
     {
-        char rv = USCI_A_UART_receiveData(MCU_BCUA_UCA); // Read the character
-        if(rv == UART_BREAKCHAR) // Character indicates completion of a command
-            uart_rx_available = true; // Make note of this
-        else
-            uart_rx[uart_rx_idx] = rv; // Store the character in the RX buffer
-        ++uart_rx_idx;
+        if(_rxByte(USCI_A_UART_receiveData(MCU_BCUA_UCA))) // Read the character
+            __bic_SR_register_on_exit(LPM0_bits); // A frame is complete: wake up code sleeping until there is a command to look at.
     }
 
     if(flags & USCI_A_UART_TRANSMIT_INTERRUPT_FLAG) // UART has finished transmitting a character
     {
-        if(uart_tx_idx < uart_tx_len) // There are more characters to transmit
+        if(uart_tx_tail != uart_tx_head) // There are more characters to transmit
         {
-            USCI_A_UART_transmitData(MCU_BCUA_UCA, uart_tx[uart_tx_idx]); // Load the next character into the UART
-            ++uart_tx_idx;
+            _txStart(); // Load the next character, or span of characters, into the UART
+            if(_wakeWriter())
+                __bic_SR_register_on_exit(LPM0_bits); // Wake up VCOM_waitTx.
         }
         else // We are done transmitting characters
         {
-            uart_tx_idx = 0; // Reset buffer indices
-            uart_tx_len = 0;
+            uart_tx_busy = false;
             USCI_A_UART_disableInterrupt(MCU_BCUA_UCA, USCI_A_UART_TRANSMIT_INTERRUPT); // Stop sending interrupts after characters are transmitted
         }
     }
 }
 
-// This function uses the UART to transmit a string to a USB chip, which will send it to the computer using a virtual COM port.
-//  data: base address of string we want to transmit
-//  length: number of characters to transmit
-void VCOM_tx(uint8_t * data, uint8_t len)
+#if VCOM_DMA
+// This function is called from the DMA interrupt handler (DMA_VECTOR, which other modules share) to see whether the DMA channel has written
+// the last byte of its span to the UART. The transmit interrupt is enabled again, so that the next span is started as soon as the UART can
+// take its first byte, or transmission ends if there is none.
+// Returns true if the CPU should be woken up on exit from the interrupt, for VCOM_waitTx to return.
+bool VCOM_serviceDma(void)
 {
-    assert(uart_tx_len == 0); // Ensure we are not in the middle of transmitting a string
-    uart_tx_len = len; // Record length of string to transmit
-    uart_tx_idx = 0; // Ensure buffer index is reset
-    uint8_t idx;
-    for(idx=0; idx<len; ++idx) // Store string in the transmit buffer
-        uart_tx[idx] = data[idx];
-    USCI_A_UART_enableInterrupt(MCU_BCUA_UCA, USCI_A_UART_TRANSMIT_INTERRUPT); // UART will interrupt every time its TX buffer is empty and we can transmit a new character
-    USCI_A_UART_transmitData(MCU_BCUA_UCA, uart_tx[0]); // Transmit the first character (subsequent characters will be transmitted in interrupt handler)
-    ++uart_tx_idx;
+    if((uart_tx_span == 0) || (DMA_getInterruptStatus(VCOM_DMA_CHANNEL) != DMA_INT_ACTIVE))
+        return false;
+    DMA_clearInterrupt(VCOM_DMA_CHANNEL); // Clear this interrupt
+    uart_tx_tail += uart_tx_span; // The span is out of the ring buffer, so its room can be reused.
+    uart_tx_span = 0;
+    USCI_A_UART_enableInterrupt(MCU_BCUA_UCA, USCI_A_UART_TRANSMIT_INTERRUPT); // Interrupt once the last byte has moved into the shift register
+    return _wakeWriter();
 }
 
-// This function initializes the UART so we can use it to talk to the virtual COM port.
-void VCOM_init(void)
+// This function lends the DMA channel to another module (see phase.c) until VCOM_reclaimDma is called. A span in progress is cut short, and
+// the transmit interrupt writes the rest of the ring buffer one byte at a time. Must be called with interrupts disabled.
+void VCOM_lendDma(void)
 {
-    GPIO_setAsPeripheralModuleFunctionInputPin(MCU_BCUARX_PORT, MCU_BCUARX_PIN); // Initialize RX GPIO pin
-    GPIO_setAsPeripheralModuleFunctionOutputPin(MCU_BCUATX_PORT, MCU_BCUATX_PIN); // Initialize TX GPIO pin
+    uart_dma_lent = true;
+    if(uart_tx_span == 0)
+        return;
+    DMA_disableTransfers(VCOM_DMA_CHANNEL);
+    if(DMA_getInterruptStatus(VCOM_DMA_CHANNEL) != DMA_INT_ACTIVE) // Span is not over: count the bytes already written
+        uart_tx_tail += uart_tx_span - DMA_getTransferSize(VCOM_DMA_CHANNEL);
+    else
+        uart_tx_tail += uart_tx_span;
+    DMA_clearInterrupt(VCOM_DMA_CHANNEL);
+    uart_tx_span = 0;
+    USCI_A_UART_enableInterrupt(MCU_BCUA_UCA, USCI_A_UART_TRANSMIT_INTERRUPT); // Carry on a byte at a time
+}
+
+// This function takes the DMA channel back once the module it was lent to is done with it, and sets it up again. Must be called with
+// interrupts disabled.
+void VCOM_reclaimDma(void)
+{
+    _dmaInit();
+    uart_dma_lent = false; // The next span goes to the DMA channel again.
+}
+#endif
+#endif
+
+// This function queues a message for transmission to the USB chip, which will send it to the computer using a virtual COM port. It never
+// waits: the message is copied into the transmit ring buffer, which the UART transmit interrupt (or USB module) empties in the background. A message that
+// does not fit in the free space is dropped whole, so that the computer never gets part of one; call VCOM_waitTx first where messages must
+// not be lost. Must not be called from interrupt handlers.
+//  data: base address of message we want to transmit
+//  len: number of characters to transmit
+//  returns: true if the message was queued, false if it was dropped
+bool VCOM_tx(const uint8_t * data, uint16_t len)
+{
+    if(len > _txFree()) // Transmission only ever makes more room, so this can't change to true while we copy.
+    {
+        ++uart_tx_dropped;
+        return false;
+    }
+    uint16_t idx;
+    for(idx=0; idx<len; ++idx) // Store message in the ring buffer, past the bytes the transmit interrupt may be reading
+        uart_tx[(uart_tx_head + idx) & UART_TX_MASK] = data[idx];
+    uint16_t gie = __get_interrupt_state(); // Interrupt state to return to.
+    __disable_interrupt(); // Make sure the transmit interrupt doesn't finish between the checks below.
+    uart_tx_head += len; // Hand the message to the transmit interrupt.
+    if((uint16_t) (uart_tx_head - uart_tx_tail) > uart_tx_high_water)
+        uart_tx_high_water = uart_tx_head - uart_tx_tail;
+    if(!uart_tx_busy && (len != 0)) // The UART is idle, so nothing will empty the buffer until we start it.
+    {
+        uart_tx_busy = true;
+        _txStart();
+    }
+    __set_interrupt_state(gie); // Interrupts can happen again, if they could before.
+    return true;
+}
+
+// This function puts the CPU to sleep until the transmit ring buffer has room for a message, applying backpressure to the caller instead of
+// dropping the message. It returns at once if there is room already. Interrupts are enabled on return.
+//  len: length of the message, at most VCOM_TX_BUFFER_LEN.
+void VCOM_waitTx(uint16_t len)
+{
+    __disable_interrupt(); // Don't let the room appear between checking for it and going to sleep.
+    while(_txFree() < len) // The UART is busy, so its transmit or DMA interrupt will wake us up.
+    {
+        uart_tx_wanted = len;
+        __bis_SR_register(LPM0_bits + GIE); // Sleep until the transmit or DMA interrupt has made enough room.
+        __disable_interrupt();
+    }
+    __enable_interrupt();
+}
+
+// This function returns the most bytes that have ever been waiting in the transmit ring buffer, to tell whether VCOM_TX_BUFFER_LEN is large
+// enough.
+uint16_t VCOM_getTxHighWater(void)
+{
+    return uart_tx_high_water;
+}
+
+// This function returns how many messages VCOM_tx has dropped because the transmit ring buffer did not have room for them.
+uint16_t VCOM_getTxDropped(void)
+{
+    return uart_tx_dropped;
+}
+
+#if !VCOM_USB
+// This function sets the UART up for a baud rate, computing the divider and modulation from SMCLK as the user's guide does: with
+// N = SMCLK/baud, UCBRx = INT(N/16) and UCBRFx = round(frac(N/16)*16) in oversampling mode, used whenever N >= 16, or UCBRx = INT(N) and
+// UCBRSx = round(frac(N)*8) in low-frequency mode. 115200 baud from 20 MHz gives UCBRx = 10, UCBRFx = 14.
+//  baud: baud rate, which must leave N >= VCOM_BAUD_MIN_DIVIDER.
+static void _uartInit(uint32_t baud)
+{
+    uint32_t clock = UCS_getSMCLK();
     USCI_A_UART_initParam uart_settings = // Initialize the UART we will be using
     {
      .selectClockSource = USCI_A_UART_CLOCKSOURCE_SMCLK,
-     .clockPrescalar = 10,
-     .firstModReg = 14,
-     .secondModReg = 0,
      .parity = USCI_A_UART_NO_PARITY,
      .msborLsbFirst = USCI_A_UART_LSB_FIRST,
      .numberofStopBits = USCI_A_UART_ONE_STOP_BIT,
-     .uartMode = USCI_A_UART_MODE,
-     .overSampling = USCI_A_UART_OVERSAMPLING_BAUDRATE_GENERATION
+     .uartMode = USCI_A_UART_MODE
     };
+    if(clock/baud >= 16U)
+    {
+        uint32_t n = (clock + baud/2)/baud; // N rounded to the nearest integer, i.e. N/16 to the nearest 1/16
+        uart_settings.clockPrescalar = n/16U;
+        uart_settings.firstModReg = n%16U;
+        uart_settings.secondModReg = 0;
+        uart_settings.overSampling = USCI_A_UART_OVERSAMPLING_BAUDRATE_GENERATION;
+    }
+    else
+    {
+        uint32_t n = (8U*clock + baud/2)/baud; // N in eighths
+        uart_settings.clockPrescalar = n/8U;
+        uart_settings.firstModReg = 0;
+        uart_settings.secondModReg = n%8U;
+        uart_settings.overSampling = USCI_A_UART_LOW_FREQUENCY_BAUDRATE_GENERATION;
+    }
     USCI_A_UART_init(MCU_BCUA_UCA, &uart_settings);
     USCI_A_UART_enable(MCU_BCUA_UCA); // Enable the UART
     USCI_A_UART_enableInterrupt(MCU_BCUA_UCA, USCI_A_UART_RECEIVE_INTERRUPT); // UART will interrupt every time we receive a character
 }
+#endif
+
+// This function initializes the UART so we can use it to talk to the virtual COM port, at VCOM_BAUD_DEFAULT, or with VCOM_USB = 1 the USB
+// module.
+void VCOM_init(void)
+{
+#if VCOM_USB
+    USB_setup(true, true); // Enumerate as soon as the cable is plugged in, and report events through the USBCDC_handle... functions.
+#else
+    GPIO_setAsPeripheralModuleFunctionInputPin(MCU_BCUARX_PORT, MCU_BCUARX_PIN); // Initialize RX GPIO pin
+    GPIO_setAsPeripheralModuleFunctionOutputPin(MCU_BCUATX_PORT, MCU_BCUATX_PIN); // Initialize TX GPIO pin
+    _uartInit(VCOM_BAUD_DEFAULT);
+#if VCOM_DMA
+    _dmaInit(); // Set up the DMA channel that feeds the UART.
+#endif
+#endif
+}
+
+// This function changes the baud rate of the UART. Everything already queued is transmitted at the old rate first, and a command partly
+// received is forgotten. With VCOM_USB = 1 there is no baud rate to change, and nothing is done. Must not be called from interrupt handlers.
+//  baud: new baud rate.
+//  returns: false, leaving the rate as it was, if SMCLK is too slow to generate it.
+bool VCOM_setBaud(uint32_t baud)
+{
+#if VCOM_USB
+    return true;
+#else
+    if((baud == 0) || (UCS_getSMCLK()/baud < VCOM_BAUD_MIN_DIVIDER))
+        return false;
+    VCOM_waitTx(VCOM_TX_BUFFER_LEN); // Sleep until the ring buffer is empty,
+    while(VCOM_isTransmitting() || USCI_A_UART_queryStatusFlags(MCU_BCUA_UCA, USCI_A_UART_BUSY)); // then wait for the last character to go out.
+    uint16_t gie = __get_interrupt_state(); // Interrupt state to return to.
+    __disable_interrupt(); // Don't take a receive interrupt while the UART is being set up again.
+    _uartInit(baud);
+    uart_rx_idx = 0; // The frame being received was partly at the old rate; frames already complete are kept.
+    uart_rx_discard = false;
+    __set_interrupt_state(gie);
+    return true;
+#endif
+}
+
+// This function sets the function to call whenever a frame from the computer has been stored in the RX ring. It is called from the
+// interrupt handler that completed the frame, which wakes the CPU up on exit, or from VCOM_releaseRx with USB.
+//  handler: function to call, or NULL for none.
+void VCOM_setRxHandler(VCOM_Handler handler)
+{
+    uart_rx_handler = handler;
+}
 
-// This function indicates whether the RX buffer contains a complete command (true = yes).
+// This function indicates whether the RX ring holds a complete frame (true = yes).
 bool VCOM_rxAvailable(void)
 {
-    return uart_rx_available;
+    return uart_rx_head != uart_rx_tail;
 }
 
-// This function returns the base address of the command stored in the RX buffer.
+// This function returns the oldest complete frame in the RX ring, as a string. It stays there, and can be modified in place, until
+// VCOM_releaseRx is called. Must only be called once VCOM_rxAvailable() is true.
 char * VCOM_getRxString(void)
 {
-    uart_rx[uart_rx_idx-1] = '\0'; // Add null character to end so it can be parsed using standard C string libraries
-    uart_rx_idx = 0; // Indicate RX buffer no longer contains valid string
-    uart_rx_available = false;
-    return (char *) uart_rx; // Return base address
+    return (char *) uart_rx[uart_rx_tail & UART_RX_MASK]; // Return base address
+}
+
+// This function frees the slot of the oldest complete frame for a new frame.
+void VCOM_releaseRx(void)
+{
+    ++uart_rx_tail;
+#if VCOM_USB
+    uint16_t gie = __get_interrupt_state(); // Interrupt state to return to.
+    __disable_interrupt(); // The USB interrupt handler also takes bytes out of the endpoint buffer.
+    _usbRx(); // Take the bytes that were left in the endpoint buffer for lack of a slot.
+    __set_interrupt_state(gie);
+#endif
+}
+
+// This function returns how many frames from the computer have been dropped because the RX ring was full or they were too long.
+uint16_t VCOM_getRxDropped(void)
+{
+    return uart_rx_dropped;
 }
 
-// This function indicates whether we are currently transmitting a string over the VCOM port (true = yes).
+// This function indicates whether we are currently transmitting over the VCOM port, i.e. the ring buffer has not drained yet (true = yes).
 bool VCOM_isTransmitting(void)
 {
-    return uart_tx_len!=0;
+    return uart_tx_busy;
 }
 
 
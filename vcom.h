@@ -13,10 +13,22 @@
 #include <stdint.h> // Specific definitions of integers
 #include <stdbool.h> // Definition of bool data type
 
+typedef void (*VCOM_Handler)(void); // Called from an interrupt handler when a frame from the computer has been stored in the RX ring.
+
 void   VCOM_init(void); // Initialize necessary peripherals so we can talk to computer over virtual COM port
-bool   VCOM_rxAvailable(void); // Indicates whether we have received a complete command that can be read.
-void   VCOM_tx(uint8_t *, uint8_t); // Transmit a string.
-char * VCOM_getRxString(void); // Retrieve a complete command from the RX buffer.
+bool   VCOM_setBaud(uint32_t); // Change the baud rate of the UART.
+void   VCOM_setRxHandler(VCOM_Handler); // Set the function to call whenever a frame has been received.
+bool   VCOM_rxAvailable(void); // Indicates whether we have received a complete frame that can be read.
+bool   VCOM_tx(const uint8_t *, uint16_t); // Queue a message for transmission, or drop it if there is no room.
+void   VCOM_waitTx(uint16_t); // Sleep until a message of a given length can be queued.
+char * VCOM_getRxString(void); // Retrieve the oldest complete frame from the RX ring.
+void   VCOM_releaseRx(void); // Free the slot of that frame.
+uint16_t VCOM_getRxDropped(void); // Number of frames dropped for lack of room.
 bool   VCOM_isTransmitting(void); // Indicates whether we are currently transmitting over VCOM.
+uint16_t VCOM_getTxHighWater(void); // Most bytes that have ever been waiting for transmission.
+uint16_t VCOM_getTxDropped(void); // Number of messages dropped for lack of room.
+bool   VCOM_serviceDma(void); // Checks the DMA channel that feeds the UART, from the DMA interrupt handler (VCOM_DMA = 1 only).
+void   VCOM_lendDma(void); // Lets another module use the DMA channel that feeds the UART.
+void   VCOM_reclaimDma(void); // Takes that DMA channel back.
 
 #endif /* VCOM_H_ */